@@ -0,0 +1,98 @@
+/**
+ * @file fileio.c
+ * @author Roy Freytag
+ *
+ * files and I/O accounting of the out-of-core benchmark mode.
+ *
+ * The inputs live in shared file mappings instead of memory, so the generators and the key types fill them as usual while the
+ * kernel writes them back and evicts them as needed, and datasets larger than the memory can be benchmarked.
+ * The I/O of a run is taken from /proc/thread-self/io, so concurrent workers don't count each other's I/O.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "fileio.h"
+
+/**
+ * @brief reads the I/O counters of the calling thread.
+ * @param counters gets the counters.
+ * @return 0 on success, -1 if the kernel doesn't provide them.
+ */
+int io_counters(IoCounters_t *counters)
+{
+  char line[128];
+  unsigned long long value;
+  FILE *f = fopen("/proc/thread-self/io", "r");
+  if(!f) f = fopen("/proc/self/io", "r");
+  memset(counters, 0, sizeof(IoCounters_t));
+  if(!f) return -1;
+  while(fgets(line, sizeof(line), f))
+  {
+    if(sscanf(line, "rchar: %llu", &value) == 1) counters->read = value;
+    else if(sscanf(line, "wchar: %llu", &value) == 1) counters->written = value;
+    else if(sscanf(line, "read_bytes: %llu", &value) == 1) counters->diskRead = value;
+    else if(sscanf(line, "write_bytes: %llu", &value) == 1) counters->diskWritten = value;
+  }
+  fclose(f);
+  return 0;
+}
+
+/**
+ * @brief creates a file of a size and maps it shared.
+ * @param path path of the file, an existing one gets truncated.
+ * @param size size in bytes.
+ * @param fd gets the file descriptor, which stays open for the I/O of the modules.
+ * @return pointer to the mapping, 0 on failure.
+ */
+void *io_mapFile(const char *path, size_t size, int *fd)
+{
+  *fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if(*fd < 0) return 0;
+  if(ftruncate(*fd, size?size:1))
+  {
+    close(*fd);
+    unlink(path);
+    *fd = -1;
+    return 0;
+  }
+  void *map = mmap(0, size?size:1, PROT_READ | PROT_WRITE, MAP_SHARED, *fd, 0);
+  if(map == MAP_FAILED)
+  {
+    close(*fd);
+    unlink(path);
+    *fd = -1;
+    return 0;
+  }
+  return map;
+}
+
+/**
+ * @brief unmaps and removes a file created by io_mapFile().
+ * @param map pointer to the mapping, may be 0.
+ * @param size size in bytes as given to io_mapFile().
+ * @param fd file descriptor.
+ * @param path path of the file.
+ */
+void io_unmapFile(void *map, size_t size, int fd, const char *path)
+{
+  if(map) munmap(map, size?size:1);
+  if(fd >= 0) close(fd);
+  if(path) unlink(path);
+}
+
+/**
+ * @brief writes back a file and drops it from the page cache, so the next run reads it from storage.
+ * @param fd file descriptor.
+ * @param map mapping of the file, its pages would keep the cache alive, 0 if there is none.
+ * @param size size of the mapping in bytes.
+ */
+void io_dropCache(int fd, void *map, size_t size)
+{
+  fdatasync(fd);
+  if(map) madvise(map, size?size:1, MADV_DONTNEED);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+}
@@ -0,0 +1,29 @@
+/**
+ * @file fileio.h
+ * @author Roy Freytag
+ *
+ * files and I/O accounting of the out-of-core benchmark mode
+ */
+
+#ifndef FILEIO_H_
+#define FILEIO_H_
+
+#include <stdlib.h>
+
+/**
+ * I/O counters of the calling thread
+ */
+typedef struct
+{
+  unsigned long long read; ///< bytes read through read-like system calls, including the page cache
+  unsigned long long written; ///< bytes written through write-like system calls, including the page cache
+  unsigned long long diskRead; ///< bytes fetched from storage
+  unsigned long long diskWritten; ///< bytes sent to storage, or dirtied in the page cache for it
+} IoCounters_t;
+
+int   io_counters(IoCounters_t *counters);
+void *io_mapFile(const char *path, size_t size, int *fd);
+void  io_unmapFile(void *map, size_t size, int fd, const char *path);
+void  io_dropCache(int fd, void *map, size_t size);
+
+#endif /* FILEIO_H_ */
@@ -0,0 +1,354 @@
+/**
+ * @file generators.c
+ * @author Roy Freytag
+ *
+ * input distributions to benchmark the sorting algorithms with.
+ *
+ * Every generator fills the first n elements of an array, deterministically for a given seed,
+ * so every module gets to sort exactly the same data and any run can be regenerated from the seed.
+ * Random distributions are filled in parallel through rng_parallel().
+ * New distributions only need a generator function and an entry in the registry below.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "rng.h"
+#include "generators.h"
+
+/**
+ * @brief 0, 1, 2, ..., n-1
+ */
+static void genSorted(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  for(i = 0; i < n; i++) numbers[i] = i;
+}
+
+/**
+ * @brief chunk fill function of genRandom().
+ */
+static void fillRandom(Rng_t *rng, size_t begin, size_t end, void *arg)
+{
+  int64_t *numbers = arg;
+  size_t i;
+  for(i = begin; i < end; i++) numbers[i] = (int64_t)rng_next(rng);
+}
+
+/**
+ * @brief uniformly distributed random numbers over the whole 64 bit range.
+ */
+static void genRandom(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  rng_parallel(n, ctx->seed, ctx->threads, fillRandom, numbers);
+}
+
+/**
+ * @brief n-1, n-2, ..., 0
+ */
+static void genReverse(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  for(i = 0; i < n; i++) numbers[i] = n - 1 - i;
+}
+
+/**
+ * @brief ascending up to the middle, descending afterwards.
+ */
+static void genOrganPipe(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  for(i = 0; i < n; i++) numbers[i] = (i < n/2)?i:n - 1 - i;
+}
+
+/**
+ * @brief param ascending runs of equal length.
+ */
+static void genSawtooth(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  size_t teeth = (ctx->param >= 1)?ctx->param:1;
+  size_t period = (n + teeth - 1) / teeth;
+  for(i = 0; i < n; i++) numbers[i] = i % period;
+}
+
+/**
+ * arguments of the chunk fill functions that need a parameter
+ */
+typedef struct
+{
+  int64_t *numbers; ///< array to fill
+  size_t n; ///< size of the whole array
+  double param; ///< distribution parameter
+} FillArgs_t;
+
+/**
+ * @brief chunk fill function of genFewUnique().
+ */
+static void fillFewUnique(Rng_t *rng, size_t begin, size_t end, void *arg)
+{
+  FillArgs_t *a = arg;
+  uint64_t keys = (a->param >= 1)?a->param:1;
+  size_t i;
+  for(i = begin; i < end; i++) a->numbers[i] = rng_bounded(rng, keys);
+}
+
+/**
+ * @brief random numbers out of only param different keys.
+ */
+static void genFewUnique(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  FillArgs_t a = {numbers, n, ctx->param};
+  rng_parallel(n, ctx->seed, ctx->threads, fillFewUnique, &a);
+}
+
+/**
+ * @brief all keys are the same.
+ */
+static void genEqual(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  for(i = 0; i < n; i++) numbers[i] = 0;
+}
+
+/**
+ * @brief sorted numbers with param random pairs swapped, n/100 + 1 pairs if param is 0.
+ */
+static void genNearlySorted(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i, k = (ctx->param >= 1)?ctx->param:n / 100 + 1;
+  Rng_t rng;
+  genSorted(numbers, n, ctx);
+  if(n < 2) return;
+  rng_seed(&rng, ctx->seed);
+  for(i = 0; i < k; i++)
+  {
+    size_t a = rng_bounded(&rng, n), b = rng_bounded(&rng, n);
+    int64_t tmp = numbers[a];
+    numbers[a] = numbers[b];
+    numbers[b] = tmp;
+  }
+}
+
+/**
+ * @brief sorted numbers followed by param percent random ones, like a sorted log that got appended to.
+ */
+static void genAppend(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  double percent = (ctx->param > 100)?100:(ctx->param > 0)?ctx->param:0;
+  size_t i, sorted = n - (size_t)(n * percent / 100);
+  Rng_t rng;
+  genSorted(numbers, sorted, ctx);
+  rng_seed(&rng, ctx->seed);
+  for(i = sorted; i < n; i++) numbers[i] = rng_bounded(&rng, n);
+}
+
+/**
+ * @brief chunk fill function of genZipf().
+ */
+static void fillZipf(Rng_t *rng, size_t begin, size_t end, void *arg)
+{
+  FillArgs_t *a = arg;
+  size_t i;
+  double s = a->param, u, x;
+  for(i = begin; i < end; i++)
+  {
+    u = 1.0 - rng_double(rng);
+    if(fabs(s - 1) < 1e-9) x = pow(a->n, u);
+    else x = pow((pow(a->n, 1 - s) - 1) * u + 1, 1 / (1 - s));
+    a->numbers[i] = (x < a->n)?(int64_t)x:(int64_t)a->n;
+  }
+}
+
+/**
+ * @brief Zipf distributed keys out of 1..n with skew param.
+ *
+ * Small keys are very frequent, large keys rare. Keys are drawn by inverting the continuous approximation of the distribution.
+ */
+static void genZipf(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  FillArgs_t a = {numbers, n, ctx->param};
+  rng_parallel(n, ctx->seed, ctx->threads, fillZipf, &a);
+}
+
+//state of the adversary, see genKiller()
+static __thread int64_t *killerVal = 0; ///< values assigned to the items so far
+static __thread int64_t killerGas = 0; ///< value of items that have not been assigned yet
+static __thread int64_t killerSolid = 0; ///< next value to be assigned
+static __thread size_t killerCandidate = 0; ///< item that will likely be the pivot
+
+/**
+ * @brief comparison function of the adversary.
+ *
+ * Compares item indices, assigning values to unassigned items lazily so the assumed pivot always ends up as small as possible.
+ */
+static int killerCompare(void *a, void *b)
+{
+  size_t x = *((size_t*)a), y = *((size_t*)b);
+  if(killerVal[x] == killerGas && killerVal[y] == killerGas)
+  {
+    if(x == killerCandidate) killerVal[x] = killerSolid++;
+    else killerVal[y] = killerSolid++;
+  }
+  if(killerVal[x] == killerGas) killerCandidate = x;
+  else if(killerVal[y] == killerGas) killerCandidate = y;
+  return (killerVal[x] < killerVal[y])?-1:((killerVal[x] > killerVal[y])?1:0);
+}
+
+/**
+ * @brief adversarial input for the sort function under test.
+ *
+ * Uses M. D. McIlroy's "A Killer Adversary for Quicksort": the sort function is run on item indices with a comparison
+ * function that decides the item values as late as possible. The resulting values drive quicksort-like algorithms into their worst case.
+ * Falls back to random numbers if there is no sort function.
+ */
+static void genKiller(int64_t *numbers, size_t n, GenContext_t *ctx)
+{
+  size_t i;
+  if(!ctx->sort || !n)
+  {
+    genRandom(numbers, n, ctx);
+    return;
+  }
+
+  size_t *items = malloc(sizeof(size_t) * n);
+  if(!items)
+  {
+    genRandom(numbers, n, ctx);
+    return;
+  }
+
+  killerVal = numbers;
+  killerGas = n - 1;
+  killerSolid = 0;
+  killerCandidate = 0;
+  for(i = 0; i < n; i++)
+  {
+    items[i] = i;
+    numbers[i] = killerGas;
+  }
+
+  ctx->sort(items, n, sizeof(size_t), killerCompare);
+
+  killerVal = 0;
+  free(items);
+}
+
+/**
+ * registry of all available distributions
+ */
+static Generator_t generators[] = {
+  {"sorted", "Sorted", 0, 0, genSorted},
+  {"random", "Random", 0, 0, genRandom},
+  {"reverse", "Reverse", 0, 0, genReverse},
+  {"organpipe", "Organ-Pipe", 0, 0, genOrganPipe},
+  {"sawtooth", "Sawtooth", "number of teeth", 8, genSawtooth},
+  {"fewunique", "Few-Unique", "number of different keys", 16, genFewUnique},
+  {"equal", "All-Equal", 0, 0, genEqual},
+  {"nearlysorted", "Nearly-Sorted", "number of random swaps, 0 for n/100+1", 0, genNearlySorted},
+  {"append", "Appended", "percentage of random keys appended to sorted ones", 10, genAppend},
+  {"zipf", "Zipf", "skew", 1, genZipf},
+  {"killer", "Killer", 0, 0, genKiller},
+  {0, 0, 0, 0, 0}
+};
+
+/**
+ * @brief getter for the generator registry.
+ * @return array of all generators, terminated by an entry with name 0.
+ */
+Generator_t *gen_getGenerators(void)
+{
+  return generators;
+}
+
+/**
+ * @brief searches the registry for a generator.
+ * @param name name of the generator.
+ * @return pointer to the registry entry or 0 if there is none with that name.
+ */
+Generator_t *gen_findGenerator(const char *name)
+{
+  Generator_t *g;
+  for(g = generators; g->name; g++)
+  {
+    if(!strcmp(g->name, name)) return g;
+  }
+  return 0;
+}
+
+/**
+ * @brief parses a comma separated list of generators.
+ *
+ * Every entry may set its parameter after a colon, e.g. "random,fewunique:4,zipf:1.5".
+ * "all" selects every generator with its default parameter.
+ * @param list list to parse.
+ * @param count set to the number of selected generators.
+ * @return array of copies of the selected generators, has to be freed, 0 on unknown names or if allocation fails.
+ */
+Generator_t *gen_parseList(const char *list, size_t *count)
+{
+  size_t n = 1, i;
+  const char *c;
+  *count = 0;
+
+  if(!strcmp(list, "all"))
+  {
+    for(n = 0; generators[n].name; n++);
+    Generator_t *tmp = malloc(sizeof(Generator_t) * n);
+    if(!tmp) return 0;
+    memcpy(tmp, generators, sizeof(Generator_t) * n);
+    *count = n;
+    return tmp;
+  }
+
+  for(c = list; *c; c++) if(*c == ',') n++;
+
+  Generator_t *tmp = malloc(sizeof(Generator_t) * n);
+  char *copy = malloc(strlen(list) + 1);
+  if(!tmp || !copy)
+  {
+    free(tmp);
+    free(copy);
+    return 0;
+  }
+  strcpy(copy, list);
+
+  char *save = 0, *tok, *param;
+  i = 0;
+  for(tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(0, ",", &save))
+  {
+    param = strchr(tok, ':');
+    if(param) *param++ = 0;
+
+    Generator_t *g = gen_findGenerator(tok);
+    if(!g)
+    {
+      fprintf(stderr, "Unknown distribution \"%s\"!\n", tok);
+      free(tmp);
+      free(copy);
+      return 0;
+    }
+    tmp[i] = *g;
+    if(param) sscanf(param, "%lf", &tmp[i].param);
+    i++;
+  }
+  free(copy);
+
+  *count = i;
+  return tmp;
+}
+
+/**
+ * @brief prints all available generators and their parameters.
+ */
+void gen_printGenerators(void)
+{
+  Generator_t *g;
+  for(g = generators; g->name; g++)
+  {
+    if(g->paramHelp) printf("\t\t%-14s - %s, parameter: %s(default: %g)\n", g->name, g->title, g->paramHelp, g->param);
+    else printf("\t\t%-14s - %s\n", g->name, g->title);
+  }
+}
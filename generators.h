@@ -0,0 +1,47 @@
+/**
+ * @file generators.h
+ * @author Roy Freytag
+ *
+ * input distributions to benchmark the sorting algorithms with,
+ * generated as 64 bit keys that get converted to the benchmarked element types
+ */
+
+#ifndef GENERATORS_H_
+#define GENERATORS_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "sorting_lib.h"
+
+/**
+ * information a generator may need besides the array to fill
+ */
+typedef struct
+{
+  uint64_t seed; ///< seed for random distributions, same seed means same data
+  unsigned threads; ///< maximum number of threads to generate with
+  double param; ///< distribution specific parameter
+  sortFn_t sort; ///< sort function under test, for adversarial inputs
+} GenContext_t;
+
+typedef void (*generatorFn_t)(int64_t*, size_t, GenContext_t*); ///< Function-pointer type definition for input generators
+
+/**
+ * registry entry of an input distribution
+ */
+typedef struct
+{
+  char *name; ///< name to select the generator on the command-line, also used in file names
+  char *title; ///< name displayed in the console and plots
+  char *paramHelp; ///< description of the parameter, 0 if it has none
+  double param; ///< default parameter
+  generatorFn_t generate; ///< generator function
+} Generator_t;
+
+Generator_t *gen_getGenerators(void);
+Generator_t *gen_findGenerator(const char *name);
+Generator_t *gen_parseList(const char *list, size_t *count);
+void        gen_printGenerators(void);
+
+#endif /* GENERATORS_H_ */
@@ -0,0 +1,332 @@
+/**
+ * @file keytypes.c
+ * @author Roy Freytag
+ *
+ * element types the sorting algorithms get benchmarked with.
+ *
+ * The generators produce 64 bit keys, every type converts them into its own elements while keeping their order,
+ * so a sorted distribution stays sorted and duplicates stay duplicates(except for float, which rounds large keys).
+ * Every type brings its own comparison function, so there is no extra indirection in the measured comparisons.
+ * Records and strings are tagged with the original index of the element, the records in their payload and the strings
+ * by their address in the pool, so the order of equal keys can be validated after sorting, i.e. whether the sort was stable.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "keytypes.h"
+
+#define STRING_SUFFIX 32 ///< maximum length of the variable part of a string key
+
+__thread unsigned long long runCompares = 0;
+
+/**
+ * @brief defines the counting comparison function and the validators of a numeric type.
+ *
+ * KEY converts the 64 bit key k into an element.
+ */
+#define NUMERIC_TYPE(NAME, TYPE, KEY) \
+  static int NAME##Compare(void *a, void *b) \
+  { \
+    runCompares++; \
+    TYPE x = *((TYPE*)a), y = *((TYPE*)b); \
+    return (x < y)?-1:((x > y)?1:0); \
+  } \
+  static int NAME##CompareCtx(const void *a, const void *b, void *arg) \
+  { \
+    runCompares++; \
+    TYPE x = *((const TYPE*)a), y = *((const TYPE*)b); \
+    return (x < y)?-1:((x > y)?1:0); \
+  } \
+  static int NAME##IsSorted(void *data, size_t n) \
+  { \
+    TYPE *d = data; \
+    size_t i; \
+    for(i = 1; i < n; i++) if(d[i-1] > d[i]) return 0; \
+    return 1; \
+  } \
+  static int NAME##IsPartitioned(void *data, size_t n, size_t k) \
+  { \
+    TYPE *d = data; \
+    size_t i; \
+    for(i = 0; i < n; i++) if((i < k && d[i] > d[k]) || (i > k && d[i] < d[k])) return 0; \
+    return 1; \
+  } \
+  static void *NAME##Convert(void *data, int64_t *keys, size_t n) \
+  { \
+    TYPE *d = data; \
+    size_t i; \
+    for(i = 0; i < n; i++) \
+    { \
+      int64_t k = keys[i]; \
+      d[i] = (TYPE)(KEY); \
+    } \
+    return 0; \
+  }
+
+NUMERIC_TYPE(i32, int32_t, k)
+NUMERIC_TYPE(i64, int64_t, k)
+NUMERIC_TYPE(u64, uint64_t, (uint64_t)k ^ 0x8000000000000000ULL) //offset by 2^63, so negative keys order correctly
+NUMERIC_TYPE(f32, float, k)
+NUMERIC_TYPE(f64, double, k)
+
+/**
+ * @brief comparison function for string keys.
+ */
+static int strCompare(void *a, void *b)
+{
+  runCompares++;
+  return strcmp(*((char**)a), *((char**)b));
+}
+
+/**
+ * @brief comparison function for string keys of context-taking modules.
+ */
+static int strCompareCtx(const void *a, const void *b, void *arg)
+{
+  runCompares++;
+  return strcmp(*((char* const*)a), *((char* const*)b));
+}
+
+/**
+ * @brief validator for string keys.
+ */
+static int strIsSorted(void *data, size_t n)
+{
+  char **d = data;
+  size_t i;
+  for(i = 1; i < n; i++) if(strcmp(d[i-1], d[i]) > 0) return 0;
+  return 1;
+}
+
+/**
+ * @brief stability validator for string keys, the strings lie in the pool in their original order.
+ */
+static int strIsStable(void *data, size_t n)
+{
+  char **d = data;
+  size_t i;
+  for(i = 1; i < n; i++) if(d[i-1] > d[i] && !strcmp(d[i-1], d[i])) return 0;
+  return 1;
+}
+
+/**
+ * @brief selection validator for string keys.
+ */
+static int strIsPartitioned(void *data, size_t n, size_t k)
+{
+  char **d = data;
+  size_t i;
+  for(i = 0; i < n; i++)
+  {
+    int c = strcmp(d[i], d[k]);
+    if((i < k && c > 0) || (i > k && c < 0)) return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief builds variable length strings from the keys.
+ *
+ * Every string consists of the key as 16 hex digits(offset by 2^63, so negative keys order correctly)
+ * followed by a suffix of 0 to STRING_SUFFIX characters derived from the key.
+ * The elements are pointers into a pool, which is returned to be freed after sorting.
+ */
+static void *strConvert(void *data, int64_t *keys, size_t n)
+{
+  char **d = data;
+  size_t i, j, len;
+  char *pool = malloc(n * (16 + STRING_SUFFIX + 1));
+  if(!pool) return 0;
+
+  char *c = pool;
+  for(i = 0; i < n; i++)
+  {
+    uint64_t k = (uint64_t)keys[i] ^ 0x8000000000000000ULL;
+    uint64_t h = k * 0x9e3779b97f4a7c15ULL;
+    d[i] = c;
+    sprintf(c, "%016llx", (unsigned long long)k);
+    c += 16;
+    len = (h >> 58) % (STRING_SUFFIX + 1);
+    for(j = 0; j < len; j++) *c++ = 'a' + ((h >> (j % 58)) & 15);
+    *c++ = 0;
+  }
+  return pool;
+}
+
+/**
+ * @brief defines the functions of a fat record type of SIZE bytes, the key is stored in its first 8 bytes.
+ *
+ * The payload starts with the original index of the record, for the stability validator.
+ */
+#define RECORD_TYPE(SIZE) \
+  typedef struct \
+  { \
+    int64_t key; \
+    unsigned char payload[SIZE - sizeof(int64_t)]; \
+  } Record##SIZE##_t; \
+  static int rec##SIZE##Compare(void *a, void *b) \
+  { \
+    runCompares++; \
+    int64_t x = ((Record##SIZE##_t*)a)->key, y = ((Record##SIZE##_t*)b)->key; \
+    return (x < y)?-1:((x > y)?1:0); \
+  } \
+  static int rec##SIZE##CompareCtx(const void *a, const void *b, void *arg) \
+  { \
+    runCompares++; \
+    int64_t x = ((const Record##SIZE##_t*)a)->key, y = ((const Record##SIZE##_t*)b)->key; \
+    return (x < y)?-1:((x > y)?1:0); \
+  } \
+  static int rec##SIZE##IsSorted(void *data, size_t n) \
+  { \
+    Record##SIZE##_t *d = data; \
+    size_t i; \
+    for(i = 1; i < n; i++) if(d[i-1].key > d[i].key) return 0; \
+    return 1; \
+  } \
+  static int rec##SIZE##IsStable(void *data, size_t n) \
+  { \
+    Record##SIZE##_t *d = data; \
+    uint64_t x, y; \
+    size_t i; \
+    for(i = 1; i < n; i++) \
+    { \
+      if(d[i-1].key != d[i].key) continue; \
+      memcpy(&x, d[i-1].payload, sizeof(x)); \
+      memcpy(&y, d[i].payload, sizeof(y)); \
+      if(x > y) return 0; \
+    } \
+    return 1; \
+  } \
+  static int rec##SIZE##IsPartitioned(void *data, size_t n, size_t k) \
+  { \
+    Record##SIZE##_t *d = data; \
+    size_t i; \
+    for(i = 0; i < n; i++) if((i < k && d[i].key > d[k].key) || (i > k && d[i].key < d[k].key)) return 0; \
+    return 1; \
+  } \
+  static void *rec##SIZE##Convert(void *data, int64_t *keys, size_t n) \
+  { \
+    Record##SIZE##_t *d = data; \
+    size_t i; \
+    for(i = 0; i < n; i++) \
+    { \
+      d[i].key = keys[i]; \
+      uint64_t index = i; \
+      memset(d[i].payload, (unsigned char)keys[i], sizeof(d[i].payload)); \
+      memcpy(d[i].payload, &index, sizeof(index)); \
+    } \
+    return 0; \
+  }
+
+RECORD_TYPE(64)
+RECORD_TYPE(128)
+RECORD_TYPE(256)
+
+/**
+ * registry of all available types
+ */
+static KeyType_t types[] = {
+  {"i32", "int32", sizeof(int32_t), i32Compare, i32CompareCtx, SORT_KEY_I32, 0, i32IsSorted, 0, i32IsPartitioned, i32Convert, 0},
+  {"i64", "int64", sizeof(int64_t), i64Compare, i64CompareCtx, SORT_KEY_I64, 0, i64IsSorted, 0, i64IsPartitioned, i64Convert, 0},
+  {"u64", "uint64", sizeof(uint64_t), u64Compare, u64CompareCtx, SORT_KEY_U64, 0, u64IsSorted, 0, u64IsPartitioned, u64Convert, 0},
+  {"f32", "float", sizeof(float), f32Compare, f32CompareCtx, SORT_KEY_F32, 0, f32IsSorted, 0, f32IsPartitioned, f32Convert, 0},
+  {"f64", "double", sizeof(double), f64Compare, f64CompareCtx, SORT_KEY_F64, 0, f64IsSorted, 0, f64IsPartitioned, f64Convert, 0},
+  {"str", "string", sizeof(char*), strCompare, strCompareCtx, SORT_KEY_STR, 0, strIsSorted, strIsStable, strIsPartitioned, strConvert, 16 + STRING_SUFFIX + 1},
+  {"rec64", "record64", sizeof(Record64_t), rec64Compare, rec64CompareCtx, SORT_KEY_I64, 0, rec64IsSorted, rec64IsStable, rec64IsPartitioned, rec64Convert, 0},
+  {"rec128", "record128", sizeof(Record128_t), rec128Compare, rec128CompareCtx, SORT_KEY_I64, 0, rec128IsSorted, rec128IsStable, rec128IsPartitioned, rec128Convert, 0},
+  {"rec256", "record256", sizeof(Record256_t), rec256Compare, rec256CompareCtx, SORT_KEY_I64, 0, rec256IsSorted, rec256IsStable, rec256IsPartitioned, rec256Convert, 0},
+  {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0}
+};
+
+/**
+ * @brief getter for the type registry.
+ * @return array of all types, terminated by an entry with name 0.
+ */
+KeyType_t *key_getTypes(void)
+{
+  return types;
+}
+
+/**
+ * @brief searches the registry for a type.
+ * @param name name of the type.
+ * @return pointer to the registry entry or 0 if there is none with that name.
+ */
+KeyType_t *key_findType(const char *name)
+{
+  KeyType_t *t;
+  for(t = types; t->name; t++)
+  {
+    if(!strcmp(t->name, name)) return t;
+  }
+  return 0;
+}
+
+/**
+ * @brief parses a comma separated list of types.
+ *
+ * "all" selects every type.
+ * @param list list to parse.
+ * @param count set to the number of selected types.
+ * @return array of copies of the selected types, has to be freed, 0 on unknown names or if allocation fails.
+ */
+KeyType_t *key_parseList(const char *list, size_t *count)
+{
+  size_t n = 1, i = 0;
+  const char *c;
+  *count = 0;
+
+  if(!strcmp(list, "all"))
+  {
+    for(n = 0; types[n].name; n++);
+    KeyType_t *tmp = malloc(sizeof(KeyType_t) * n);
+    if(!tmp) return 0;
+    memcpy(tmp, types, sizeof(KeyType_t) * n);
+    *count = n;
+    return tmp;
+  }
+
+  for(c = list; *c; c++) if(*c == ',') n++;
+
+  KeyType_t *tmp = malloc(sizeof(KeyType_t) * n);
+  char *copy = malloc(strlen(list) + 1);
+  if(!tmp || !copy)
+  {
+    free(tmp);
+    free(copy);
+    return 0;
+  }
+  strcpy(copy, list);
+
+  char *save = 0, *tok;
+  for(tok = strtok_r(copy, ",", &save); tok; tok = strtok_r(0, ",", &save))
+  {
+    KeyType_t *t = key_findType(tok);
+    if(!t)
+    {
+      fprintf(stderr, "Unknown key type \"%s\"!\n", tok);
+      free(tmp);
+      free(copy);
+      return 0;
+    }
+    tmp[i++] = *t;
+  }
+  free(copy);
+
+  *count = i;
+  return tmp;
+}
+
+/**
+ * @brief prints all available types.
+ */
+void key_printTypes(void)
+{
+  KeyType_t *t;
+  for(t = types; t->name; t++)
+  {
+    printf("\t\t%-14s - %s, %llu bytes\n", t->name, t->title, (unsigned long long)t->size);
+  }
+}
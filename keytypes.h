@@ -0,0 +1,42 @@
+/**
+ * @file keytypes.h
+ * @author Roy Freytag
+ *
+ * element types the sorting algorithms get benchmarked with
+ */
+
+#ifndef KEYTYPES_H_
+#define KEYTYPES_H_
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "sorting_lib.h"
+
+extern __thread unsigned long long runCompares; ///< comparisons counter of the calling thread, incremented by every comparison function handed to a module
+
+/**
+ * description of an element type
+ */
+typedef struct
+{
+  char *name; ///< name to select the type on the command-line, also used in file names
+  char *title; ///< name displayed in the console and plots
+  size_t size; ///< element size handed to the sort function
+  int (*compare)(void*, void*); ///< counting comparison function handed to the modules
+  int (*compareCtx)(const void*, const void*, void*); ///< counting comparison function for context-taking modules
+  unsigned keyType; ///< SORT_KEY_ type of the key
+  size_t keyOffset; ///< offset of the key inside an element
+  int (*isSorted)(void*, size_t); ///< validator, returns 1 if the elements are in order
+  int (*isStable)(void*, size_t); ///< stability validator of sorted elements, returns 1 if equal keys kept their original order, or 0 if the type carries no original order
+  int (*isPartitioned)(void*, size_t, size_t); ///< selection validator, returns 1 if no element before index k is greater than the one at k and none after it is less
+  void *(*convert)(void*, int64_t*, size_t); ///< builds the elements from generated keys, returns extra memory to be freed after sorting or 0
+  size_t extraSize; ///< bytes per element of the extra memory convert returns
+} KeyType_t;
+
+KeyType_t *key_getTypes(void);
+KeyType_t *key_findType(const char *name);
+KeyType_t *key_parseList(const char *list, size_t *count);
+void      key_printTypes(void);
+
+#endif /* KEYTYPES_H_ */
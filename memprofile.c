@@ -0,0 +1,550 @@
+/**
+ * @file memprofile.c
+ * @author Roy Freytag
+ *
+ * memory profiling of single benchmark runs.
+ *
+ * The allocation functions of the C library get replaced by the ones in here, so every allocation of a module
+ * passes through them. While a run records, every block gets remembered with its size in a hash table, so frees can
+ * be accounted for. That gives the live bytes and their peak, allocation and free counts, a histogram of the
+ * allocation sizes and the blocks a module didn't free.
+ * Anonymous mmap() mappings count as allocations of their pages as well. They are kept as address ranges apart from
+ * the blocks, because munmap() may unmap any part of them: the unmapped bytes stop being live, a mapping gets trimmed
+ * or split by a hole, and it counts as freed once its last page is gone.
+ * Recording covers the whole process, so the worker threads of parallel modules count as well and a block may be freed
+ * by another thread than the one that allocated it. The profile is shared by all threads behind a mutex, the hooks
+ * only take it while a run records. Concurrent runs in the same process would mix, so only one may record at a time.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <malloc.h>
+#include <dlfcn.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+#include "memprofile.h"
+
+//We can only profile memory if we use the GNU C Standard-lib as of now
+#ifdef _GNU_SOURCE
+
+#define TABLE_MIN 1024 ///< initial number of slots of the block table, has to be a power of two
+
+/**
+ * allocated block
+ */
+typedef struct
+{
+  void *ptr; ///< address of the block, 0 for empty slots
+  size_t size; ///< requested size
+} MemBlock_t;
+
+/**
+ * anonymous mapping, or what is left of it
+ */
+typedef struct
+{
+  char *start; ///< first byte of the mapping
+  size_t length; ///< mapped bytes, a multiple of the page size
+  unsigned long long origin; ///< number of the mmap() it comes from, the pieces of a split mapping share it
+} MemMapping_t;
+
+//store original function-pointers, to call later on
+static void* (*o_malloc)(size_t) = 0; ///< function-pointer to original malloc()
+static void* (*o_realloc)(void*, size_t) = 0; ///< function-pointer to original realloc()
+static void* (*o_calloc)(size_t, size_t) = 0; ///< function-pointer to original calloc()
+static void  (*o_free)(void*) = 0; ///< function-pointer to original free()
+static int   (*o_posix_memalign)(void**, size_t, size_t) = 0; ///< function-pointer to original posix_memalign()
+static void* (*o_aligned_alloc)(size_t, size_t) = 0; ///< function-pointer to original aligned_alloc()
+static void* (*o_memalign)(size_t, size_t) = 0; ///< function-pointer to original memalign()
+static void* (*o_mmap)(void*, size_t, int, int, int, off_t) = 0; ///< function-pointer to original mmap()
+static int   (*o_munmap)(void*, size_t) = 0; ///< function-pointer to original munmap()
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER; ///< protects everything below while a run records
+static int recording = 0; ///< set to one while a run records, read without the lock first
+static MemProfile_t current; ///< profile of the current run
+static unsigned long long live = 0; ///< bytes currently allocated by the run
+static MemBlock_t *table = 0; ///< blocks allocated by the run, open addressing with linear probing
+static size_t tableSize = 0; ///< number of slots of table
+static size_t tableUsed = 0; ///< number of used slots of table
+static MemMapping_t *mappings = 0; ///< anonymous mappings of the run, unordered
+static size_t mappingsSize = 0; ///< number of slots of mappings
+static size_t mappingsUsed = 0; ///< number of used slots of mappings
+static unsigned long long mappingsMade = 0; ///< number of mmap() calls recorded, numbers the mappings
+static size_t pageSize = 4096; ///< size of a page, mappings are made of whole pages
+
+/**
+ * @brief slot a block address hashes to.
+ */
+static inline size_t blockSlot(void *ptr)
+{
+  uint64_t h = (uintptr_t)ptr;
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  return h & (tableSize - 1);
+}
+
+/**
+ * @brief remembers a block.
+ * @return 1 on success, 0 if the table couldn't grow.
+ */
+static int insertBlock(void *ptr, size_t size)
+{
+  size_t i;
+  if((tableUsed + 1) * 2 > tableSize)
+  {
+    MemBlock_t *old = table;
+    size_t oldSize = tableSize;
+    size_t newSize = tableSize?tableSize * 2:TABLE_MIN;
+    MemBlock_t *grown = o_calloc(newSize, sizeof(MemBlock_t));
+    if(!grown) return 0;
+    table = grown;
+    tableSize = newSize;
+    for(i = 0; i < oldSize; i++)
+    {
+      if(!old[i].ptr) continue;
+      size_t s = blockSlot(old[i].ptr);
+      while(table[s].ptr) s = (s + 1) & (tableSize - 1);
+      table[s] = old[i];
+    }
+    o_free(old);
+  }
+
+  i = blockSlot(ptr);
+  while(table[i].ptr) i = (i + 1) & (tableSize - 1);
+  table[i].ptr = ptr;
+  table[i].size = size;
+  tableUsed++;
+  return 1;
+}
+
+/**
+ * @brief forgets a block.
+ * @param ptr address of the block.
+ * @param size set to the size of the block, if found.
+ * @return 1 if the block was recorded, 0 otherwise.
+ */
+static int removeBlock(void *ptr, size_t *size)
+{
+  if(!tableUsed || !ptr) return 0;
+  size_t mask = tableSize - 1;
+  size_t i = blockSlot(ptr);
+  while(table[i].ptr != ptr)
+  {
+    if(!table[i].ptr) return 0;
+    i = (i + 1) & mask;
+  }
+  *size = table[i].size;
+  tableUsed--;
+
+  //shift the following blocks back, so no probe sequence gets interrupted
+  size_t j = i;
+  for(;;)
+  {
+    table[i].ptr = 0;
+    do
+    {
+      j = (j + 1) & mask;
+      if(!table[j].ptr) return 1;
+    }
+    while(((j - blockSlot(table[j].ptr)) & mask) < ((j - i) & mask));
+    table[i] = table[j];
+    i = j;
+  }
+}
+
+/**
+ * @brief histogram bucket of an allocation size.
+ */
+static inline int sizeBucket(size_t size)
+{
+  int b = size?63 - __builtin_clzll(size):0;
+  return (b < MEM_BUCKETS)?b:MEM_BUCKETS - 1;
+}
+
+/**
+ * @brief records a new block.
+ */
+static void trackBlock(void *ptr, size_t size)
+{
+  if(!ptr) return;
+  current.allocations++;
+  current.allocated += size;
+  current.histogram[sizeBucket(size)]++;
+  live += size;
+  if(live > current.peak) current.peak = live;
+  insertBlock(ptr, size);
+}
+
+/**
+ * @brief records a freed block.
+ */
+static void untrackBlock(void *ptr)
+{
+  size_t size;
+  if(!removeBlock(ptr, &size)) return;
+  current.frees++;
+  live -= size;
+}
+
+/**
+ * @brief remembers a mapping.
+ * @return 1 on success, 0 if the list couldn't grow.
+ */
+static int insertMapping(char *start, size_t length, unsigned long long origin)
+{
+  if(mappingsUsed == mappingsSize)
+  {
+    size_t newSize = mappingsSize?mappingsSize * 2:16;
+    MemMapping_t *grown = o_realloc(mappings, newSize * sizeof(MemMapping_t));
+    if(!grown) return 0;
+    mappings = grown;
+    mappingsSize = newSize;
+  }
+  mappings[mappingsUsed].start = start;
+  mappings[mappingsUsed].length = length;
+  mappings[mappingsUsed].origin = origin;
+  mappingsUsed++;
+  return 1;
+}
+
+/**
+ * @brief records a new mapping, like a block of its pages.
+ */
+static void trackMapping(void *ptr, size_t length)
+{
+  length = (length + pageSize - 1) & ~(pageSize - 1);
+  current.allocations++;
+  current.allocated += length;
+  current.histogram[sizeBucket(length)]++;
+  live += length;
+  if(live > current.peak) current.peak = live;
+  insertMapping(ptr, length, mappingsMade++);
+}
+
+/**
+ * @brief counts the mappings whose pieces are still mapped.
+ * @param except index of a piece to leave out, mappingsUsed for none.
+ * @param origin number of the mmap() to count the pieces of, counts every mapping once if except is mappingsUsed.
+ */
+static size_t countMappings(size_t except, unsigned long long origin)
+{
+  size_t i, j, count = 0;
+  for(i = 0; i < mappingsUsed; i++)
+  {
+    if(i == except) continue;
+    if(except < mappingsUsed)
+    {
+      count += mappings[i].origin == origin;
+      continue;
+    }
+    for(j = 0; j < i && mappings[j].origin != mappings[i].origin; j++);
+    count += j == i;
+  }
+  return count;
+}
+
+/**
+ * @brief records unmapped pages.
+ *
+ * Every recorded mapping overlapping them loses the overlap: it is freed if nothing is left, trimmed if the pages are
+ * at one of its ends and split in two if they are inside of it.
+ */
+static void untrackMapping(void *addr, size_t length)
+{
+  char *lo = addr, *hi = lo + ((length + pageSize - 1) & ~(pageSize - 1));
+  size_t i = 0;
+  while(i < mappingsUsed)
+  {
+    char *start = mappings[i].start, *end = start + mappings[i].length;
+    if(hi <= start || lo >= end)
+    {
+      i++;
+      continue;
+    }
+    char *from = (lo > start)?lo:start, *to = (hi < end)?hi:end;
+    live -= to - from;
+    if(from == start && to == end)
+    {
+      if(!countMappings(i, mappings[i].origin)) current.frees++; //last piece of the mapping
+      mappings[i] = mappings[--mappingsUsed]; //the moved mapping gets checked next
+      continue;
+    }
+    if(from == start)
+    {
+      mappings[i].start = to;
+      mappings[i].length = end - to;
+    }
+    else
+    {
+      mappings[i].length = from - start;
+      if(to < end) insertMapping(to, end - to, mappings[i].origin);
+    }
+    i++;
+  }
+}
+
+/**
+ * @brief takes the lock of the profile if a run records.
+ * @return 1 if a run records and the lock was taken, 0 otherwise.
+ */
+static int lockProfile(void)
+{
+  if(!__atomic_load_n(&recording, __ATOMIC_ACQUIRE)) return 0;
+  pthread_mutex_lock(&lock);
+  if(recording) return 1; //the run may have stopped in between
+  pthread_mutex_unlock(&lock);
+  return 0;
+}
+
+/**
+ * @brief redefinition of malloc().
+ * Will record the block while recording.
+ * @param size allocation size.
+ */
+void *malloc(size_t size)
+{
+  if(!o_malloc) o_malloc = dlsym(RTLD_NEXT, "malloc");
+  void *ptr = o_malloc(size);
+  if(ptr && lockProfile())
+  {
+    trackBlock(ptr, size);
+    pthread_mutex_unlock(&lock);
+  }
+  return ptr;
+}
+
+/**
+ * @brief redefinition of realloc().
+ * @see malloc()
+ * Resizing a recorded block only counts its growth as allocated bytes.
+ * The lock is held across the call, so no other thread can get the old address before it is forgotten.
+ * @param ptr pointer to memory block that should be resized.
+ * @param size allocation size.
+ */
+void *realloc(void* ptr, size_t size)
+{
+  if(!o_realloc) o_realloc = dlsym(RTLD_NEXT, "realloc");
+  if(!lockProfile()) return o_realloc(ptr, size);
+
+  size_t old;
+  int known = removeBlock(ptr, &old);
+  void *res = o_realloc(ptr, size);
+  if(!res)
+  {
+    if(known && size) insertBlock(ptr, old); //failed, the old block stays
+    else if(known)
+    {
+      current.frees++;
+      live -= old;
+    }
+  }
+  else if(!known) trackBlock(res, size);
+  else
+  {
+    current.reallocations++;
+    if(size > old) current.allocated += size - old;
+    current.histogram[sizeBucket(size)]++;
+    live = live - old + size;
+    if(live > current.peak) current.peak = live;
+    insertBlock(res, size);
+  }
+  pthread_mutex_unlock(&lock);
+  return res;
+}
+
+/**
+ * @brief redefinition of calloc().
+ * @see malloc()
+ * @param nmemb member size.
+ * @param size allocation size.
+ */
+void *calloc(size_t nmemb, size_t size)
+{
+  if(!o_calloc) o_calloc = dlsym(RTLD_NEXT, "calloc");
+  void *ptr = o_calloc(nmemb, size);
+  if(ptr && lockProfile())
+  {
+    trackBlock(ptr, nmemb * size);
+    pthread_mutex_unlock(&lock);
+  }
+  return ptr;
+}
+
+/**
+ * @brief redefinition of free().
+ * @param ptr block to free.
+ */
+void free(void *ptr)
+{
+  if(!o_free) o_free = dlsym(RTLD_NEXT, "free");
+  if(ptr && lockProfile())
+  {
+    untrackBlock(ptr);
+    pthread_mutex_unlock(&lock);
+  }
+  o_free(ptr);
+}
+
+/**
+ * @brief redefinition of posix_memalign().
+ * @see malloc()
+ */
+int posix_memalign(void **memptr, size_t alignment, size_t size)
+{
+  if(!o_posix_memalign) o_posix_memalign = dlsym(RTLD_NEXT, "posix_memalign");
+  int res = o_posix_memalign(memptr, alignment, size);
+  if(!res && lockProfile())
+  {
+    trackBlock(*memptr, size);
+    pthread_mutex_unlock(&lock);
+  }
+  return res;
+}
+
+/**
+ * @brief redefinition of aligned_alloc().
+ * @see malloc()
+ */
+void *aligned_alloc(size_t alignment, size_t size)
+{
+  if(!o_aligned_alloc) o_aligned_alloc = dlsym(RTLD_NEXT, "aligned_alloc");
+  void *ptr = o_aligned_alloc(alignment, size);
+  if(ptr && lockProfile())
+  {
+    trackBlock(ptr, size);
+    pthread_mutex_unlock(&lock);
+  }
+  return ptr;
+}
+
+/**
+ * @brief redefinition of memalign().
+ * @see malloc()
+ */
+void *memalign(size_t alignment, size_t size)
+{
+  if(!o_memalign) o_memalign = dlsym(RTLD_NEXT, "memalign");
+  void *ptr = o_memalign(alignment, size);
+  if(ptr && lockProfile())
+  {
+    trackBlock(ptr, size);
+    pthread_mutex_unlock(&lock);
+  }
+  return ptr;
+}
+
+/**
+ * @brief redefinition of mmap().
+ * Anonymous mappings get recorded like allocations.
+ */
+void *mmap(void *addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+  if(!o_mmap) o_mmap = dlsym(RTLD_NEXT, "mmap");
+  void *ptr = o_mmap(addr, length, prot, flags, fd, offset);
+  if((flags & MAP_ANONYMOUS) && ptr != MAP_FAILED && lockProfile())
+  {
+    trackMapping(ptr, length);
+    pthread_mutex_unlock(&lock);
+  }
+  return ptr;
+}
+
+/**
+ * @brief redefinition of munmap().
+ * The unmapped part of recorded mappings gets freed. The lock is held across the call, so no other thread can map
+ * the pages again before they are forgotten.
+ */
+int munmap(void *addr, size_t length)
+{
+  if(!o_munmap) o_munmap = dlsym(RTLD_NEXT, "munmap");
+  if(!lockProfile()) return o_munmap(addr, length);
+  int res = o_munmap(addr, length);
+  if(!res) untrackMapping(addr, length);
+  pthread_mutex_unlock(&lock);
+  return res;
+}
+
+/**
+ * @brief tells if memory can be profiled.
+ * @return 1 if it can, 0 otherwise.
+ */
+int mem_available(void)
+{
+  return 1;
+}
+
+/**
+ * @brief starts recording the allocations of the process.
+ */
+void mem_start(void)
+{
+  if(!o_calloc) o_calloc = dlsym(RTLD_NEXT, "calloc");
+  if(!o_free) o_free = dlsym(RTLD_NEXT, "free");
+  if(!o_realloc) o_realloc = dlsym(RTLD_NEXT, "realloc");
+  long page = sysconf(_SC_PAGESIZE);
+  if(page > 0) pageSize = page;
+  pthread_mutex_lock(&lock);
+  memset(&current, 0, sizeof(current));
+  live = 0;
+  if(table) memset(table, 0, tableSize * sizeof(MemBlock_t));
+  tableUsed = 0;
+  mappingsUsed = 0;
+  __atomic_store_n(&recording, 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&lock);
+}
+
+/**
+ * @brief stops recording.
+ *
+ * Blocks and mappings still allocated count as leaked, they are forgotten afterwards.
+ * @param profile recorded memory usage.
+ */
+void mem_stop(MemProfile_t *profile)
+{
+  pthread_mutex_lock(&lock);
+  __atomic_store_n(&recording, 0, __ATOMIC_RELAXED);
+  current.leaked = live;
+  current.leakedBlocks = tableUsed + countMappings(mappingsUsed, 0);
+  *profile = current;
+  pthread_mutex_unlock(&lock);
+}
+
+#else
+
+int mem_available(void)
+{
+  return 0;
+}
+
+void mem_start(void)
+{
+}
+
+void mem_stop(MemProfile_t *profile)
+{
+  memset(profile, 0, sizeof(MemProfile_t));
+}
+
+#endif
+
+/**
+ * @brief prints the non-empty buckets of the size histogram, e.g. "16B:3 4K:1".
+ * @param profile recorded memory usage.
+ * @param output file to print to.
+ */
+void mem_printHistogram(MemProfile_t *profile, FILE *output)
+{
+  static const char units[] = "BKMGT";
+  int i;
+  for(i = 0; i < MEM_BUCKETS; i++)
+  {
+    if(!profile->histogram[i]) continue;
+    fprintf(output, " %llu%c:%llu", 1ULL << (i % 10), units[i / 10], profile->histogram[i]);
+  }
+  fprintf(output, "\n");
+}
@@ -0,0 +1,36 @@
+/**
+ * @file memprofile.h
+ * @author Roy Freytag
+ *
+ * memory profiling of single benchmark runs
+ */
+
+#ifndef MEMPROFILE_H_
+#define MEMPROFILE_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MEM_BUCKETS 32 ///< number of size histogram buckets, bucket i counts allocations of [2^i, 2^(i+1)) bytes
+
+/**
+ * memory usage of a run
+ */
+typedef struct
+{
+  unsigned long long allocated; ///< requested bytes, reallocations only count their growth
+  unsigned long long peak; ///< maximum of the live bytes
+  unsigned long long allocations; ///< number of allocations, including mmap()
+  unsigned long long reallocations; ///< number of reallocations of existing blocks
+  unsigned long long frees; ///< number of freed blocks, including mappings munmap() removed the last pages of
+  unsigned long long leaked; ///< bytes still allocated when the run ended
+  unsigned long long leakedBlocks; ///< blocks and mappings still allocated when the run ended
+  unsigned long long histogram[MEM_BUCKETS]; ///< allocation sizes
+} MemProfile_t;
+
+int  mem_available(void);
+void mem_start(void);
+void mem_stop(MemProfile_t *profile);
+void mem_printHistogram(MemProfile_t *profile, FILE *output);
+
+#endif /* MEMPROFILE_H_ */
@@ -0,0 +1,165 @@
+/**
+ * @file perfcounters.c
+ * @author Roy Freytag
+ *
+ * hardware performance counters of single benchmark runs.
+ *
+ * The counters get opened with perf_event_open() as one group for the calling thread and the threads it creates,
+ * so they are scheduled onto the PMU together. Only user space gets counted, which is permitted with the default
+ * perf_event_paranoid setting of 2. Counters the CPU or the kernel don't provide are left out, the others still work.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "perfcounters.h"
+
+/**
+ * @brief event definition of a counter
+ */
+typedef struct
+{
+  const char *name; ///< name used for columns and plots
+  unsigned type; ///< PERF_TYPE_
+  unsigned long long config; ///< event of that type
+} PerfEvent_t;
+
+#define CACHE_READ_MISS(CACHE) ((CACHE) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)) ///< config of a cache read miss event
+
+static const PerfEvent_t events[PRF_COUNT] =
+{
+  {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+  {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+  {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+  {"L1d-misses", PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D)},
+  {"LLC-misses", PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_LL)},
+  {"dTLB-misses", PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB)}
+};
+
+/**
+ * @brief opens a single counter.
+ * @param event counter to open.
+ * @param group file descriptor of the group leader, -1 to open a new group.
+ * @return file descriptor, -1 on error.
+ */
+static int openEvent(const PerfEvent_t *event, int group)
+{
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event->type;
+  attr.config = event->config;
+  attr.disabled = (group == -1); //the group gets enabled through its leader
+  attr.inherit = 1; //count the threads of parallel modules as well
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+/**
+ * @brief checks if hardware performance counters can be used.
+ *
+ * Prints why not, if they can't.
+ * @return number of available counters.
+ */
+int prf_probe(void)
+{
+  PerfCounters_t counters;
+  int available = prf_open(&counters);
+  if(!available)
+  {
+    perror("Hardware performance counters are not available");
+    if(errno == EACCES || errno == EPERM) fprintf(stderr, "Check /proc/sys/kernel/perf_event_paranoid, it has to be 2 or less.\n");
+    else fprintf(stderr, "The CPU or the virtual machine doesn't seem to provide them.\n");
+  }
+  else
+  {
+    int i;
+    for(i = 0; i < PRF_COUNT; i++)
+    {
+      if(counters.fds[i] == -1) fprintf(stderr, "Performance counter %s is not available.\n", events[i].name);
+    }
+  }
+  prf_close(&counters);
+  return available;
+}
+
+/**
+ * @brief name of a counter.
+ * @param counter PRF_ index of the counter.
+ */
+const char* prf_getName(int counter)
+{
+  return events[counter].name;
+}
+
+/**
+ * @brief opens the counters for the calling thread.
+ * @param counters counters to open.
+ * @return number of counters that could be opened.
+ */
+int prf_open(PerfCounters_t *counters)
+{
+  int i, available = 0;
+  counters->leader = -1;
+  for(i = 0; i < PRF_COUNT; i++)
+  {
+    counters->fds[i] = openEvent(&events[i], counters->leader);
+    if(counters->fds[i] == -1) continue;
+    if(counters->leader == -1) counters->leader = counters->fds[i];
+    available++;
+  }
+  return available;
+}
+
+/**
+ * @brief closes the counters.
+ * @param counters counters opened with prf_open().
+ */
+void prf_close(PerfCounters_t *counters)
+{
+  int i;
+  for(i = 0; i < PRF_COUNT; i++)
+  {
+    if(counters->fds[i] != -1) close(counters->fds[i]);
+    counters->fds[i] = -1;
+  }
+  counters->leader = -1;
+}
+
+/**
+ * @brief resets the counters and starts counting.
+ * @param counters counters opened with prf_open().
+ */
+void prf_start(PerfCounters_t *counters)
+{
+  if(counters->leader == -1) return;
+  ioctl(counters->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+  ioctl(counters->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/**
+ * @brief stops counting and reads the counters.
+ * @param counters counters opened with prf_open().
+ * @param values counted events.
+ */
+void prf_stop(PerfCounters_t *counters, PerfValues_t *values)
+{
+  int i;
+  if(counters->leader != -1) ioctl(counters->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+  for(i = 0; i < PRF_COUNT; i++)
+  {
+    unsigned long long data[3]; //value, time enabled, time running
+    values->values[i] = -1;
+    if(counters->fds[i] == -1 || read(counters->fds[i], data, sizeof(data)) != sizeof(data)) continue;
+    //scale up if the kernel had to multiplex the counters
+    if(data[2] && data[2] < data[1]) values->values[i] = (double)data[0] * data[1] / data[2];
+    else values->values[i] = data[0];
+  }
+}
@@ -0,0 +1,44 @@
+/**
+ * @file perfcounters.h
+ * @author Roy Freytag
+ *
+ * hardware performance counters of single benchmark runs
+ */
+
+#ifndef PERFCOUNTERS_H_
+#define PERFCOUNTERS_H_
+
+#define PRF_CYCLES 0 ///< core cycles
+#define PRF_INSTRUCTIONS 1 ///< retired instructions
+#define PRF_BRANCH_MISSES 2 ///< mispredicted branches
+#define PRF_L1D_MISSES 3 ///< L1 data cache read misses
+#define PRF_LLC_MISSES 4 ///< last level cache read misses
+#define PRF_DTLB_MISSES 5 ///< data TLB read misses
+#define PRF_COUNT 6 ///< number of recorded counters
+
+/**
+ * counters opened by the calling thread
+ */
+typedef struct
+{
+  int fds[PRF_COUNT]; ///< file descriptors of the counters, -1 for counters that couldn't be opened
+  int leader; ///< file descriptor of the group leader, -1 if no counter could be opened
+} PerfCounters_t;
+
+/**
+ * counter values of a run
+ */
+typedef struct
+{
+  double values[PRF_COUNT]; ///< counted events, scaled up if the kernel had to multiplex, negative if not available
+} PerfValues_t;
+
+int         prf_probe(void);
+const char* prf_getName(int counter);
+
+int         prf_open(PerfCounters_t *counters);
+void        prf_close(PerfCounters_t *counters);
+void        prf_start(PerfCounters_t *counters);
+void        prf_stop(PerfCounters_t *counters, PerfValues_t *values);
+
+#endif /* PERFCOUNTERS_H_ */
@@ -0,0 +1,305 @@
+/**
+ * @file placement.c
+ * @author Roy Freytag
+ *
+ * page size and NUMA node placement of the benchmark buffers.
+ *
+ * Placed buffers are fresh anonymous mappings: the page size gets chosen by madvise() or MAP_HUGETLB and the node by mbind()
+ * before anything touches them, so neither the generators nor the threads of a module can move them elsewhere.
+ * The policies are set by system calls, so libnuma isn't needed. Whether the kernel actually provided huge pages or the
+ * requested node gets measured afterwards from /proc/self/smaps and move_pages(), as both can silently fall back.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+
+#include "placement.h"
+
+#define MAX_NODES 1024 ///< nodes a node mask can hold
+#define SHARE_SAMPLES 4096 ///< pages sampled by plc_nodeShare()
+
+static const char *pageNames[] = {"default", "small", "thp", "huge"};
+static const char *numaNames[] = {"default", "local", "interleave", "remote"};
+static int hugeWarned = 0; ///< set once the pool of explicit huge pages ran out
+
+/**
+ * @brief reads a single number from a file.
+ * @return the number, def if the file can't be read.
+ */
+static long readNumber(const char *path, const char *format, long def)
+{
+  long value;
+  FILE *f = fopen(path, "r");
+  if(!f) return def;
+  if(fscanf(f, format, &value) != 1) value = def;
+  fclose(f);
+  return value;
+}
+
+/**
+ * @brief size of the huge pages of a page mode.
+ * @return bytes, or the base page size if the mode doesn't use huge pages.
+ */
+static size_t hugePageSize(int pages)
+{
+  if(pages == PLC_PAGES_THP) return readNumber("/sys/kernel/mm/transparent_hugepage/hpage_pmd_size", "%ld", 2 << 20);
+  if(pages == PLC_PAGES_HUGE)
+  {
+    char line[128];
+    long kb = 2048;
+    FILE *f = fopen("/proc/meminfo", "r");
+    while(f && fgets(line, sizeof(line), f)) if(sscanf(line, "Hugepagesize: %ld kB", &kb) == 1) break;
+    if(f) fclose(f);
+    return kb << 10;
+  }
+  return sysconf(_SC_PAGESIZE);
+}
+
+/**
+ * @brief size of the mapping of a placed buffer.
+ */
+static size_t mappedSize(const Placement_t *p, size_t size)
+{
+  size_t page = hugePageSize(p->pages);
+  if(!size) size = 1;
+  return (size + page - 1) / page * page;
+}
+
+/**
+ * @brief parses the name of a page mode.
+ * @return PLC_PAGES_ constant, -1 if unknown.
+ */
+int plc_parsePages(const char *name)
+{
+  int i;
+  for(i = 0; i < 4; i++) if(!strcmp(name, pageNames[i])) return i;
+  return -1;
+}
+
+/**
+ * @brief parses the name of a NUMA placement.
+ * @return PLC_NUMA_ constant, -1 if unknown.
+ */
+int plc_parseNuma(const char *name)
+{
+  int i;
+  for(i = 0; i < 4; i++) if(!strcmp(name, numaNames[i])) return i;
+  return -1;
+}
+
+/**
+ * @brief name of a page mode.
+ */
+const char *plc_pagesName(int pages)
+{
+  return (pages >= 0 && pages < 4)?pageNames[pages]:"?";
+}
+
+/**
+ * @brief name of a NUMA placement.
+ */
+const char *plc_numaName(int numa)
+{
+  return (numa >= 0 && numa < 4)?numaNames[numa]:"?";
+}
+
+/**
+ * @brief checks if buffers get placed at all.
+ * @return 1 if they do, 0 if they are plain allocations.
+ */
+int plc_active(const Placement_t *p)
+{
+  return p->pages != PLC_PAGES_DEFAULT || p->numa != PLC_NUMA_DEFAULT;
+}
+
+/**
+ * @brief number of NUMA nodes, the highest online node + 1.
+ */
+int plc_nodes(void)
+{
+  char list[256];
+  int nodes = 1;
+  FILE *f = fopen("/sys/devices/system/node/online", "r");
+  if(!f) return 1;
+  if(fgets(list, sizeof(list), f))
+  {
+    //the list is ordered, e.g. 0-1,3, so the last number is the highest node
+    char *c = list + strlen(list);
+    while(c > list && (c[-1] < '0' || c[-1] > '9')) c--;
+    while(c > list && c[-1] >= '0' && c[-1] <= '9') c--;
+    nodes = atoi(c) + 1;
+  }
+  fclose(f);
+  return (nodes > 0 && nodes <= MAX_NODES)?nodes:1;
+}
+
+/**
+ * @brief node a cpu belongs to.
+ * @return node, 0 if the topology isn't available.
+ */
+int plc_nodeOfCpu(int cpu)
+{
+  char path[128];
+  int node, nodes = plc_nodes();
+  for(node = 0; node < nodes && cpu >= 0; node++)
+  {
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/node%d", cpu, node);
+    if(!access(path, F_OK)) return node;
+  }
+  return 0;
+}
+
+/**
+ * @brief allocates a benchmark buffer with the requested placement.
+ *
+ * Without a placement this is malloc(), or an anonymous shared mapping if shared.
+ * Explicit huge pages fall back to transparent ones if the pool is exhausted, plc_hugeShare() tells.
+ * @param p placement.
+ * @param size size in bytes.
+ * @param shared 1 if child processes have to see the buffer.
+ * @param cpu cpu of the worker using the buffer, the local node is the one of that cpu.
+ * @return pointer to the buffer or 0 if the allocation failed.
+ */
+void *plc_alloc(const Placement_t *p, size_t size, int shared, int cpu)
+{
+  int flags = MAP_ANONYMOUS | (shared?MAP_SHARED:MAP_PRIVATE);
+  if(!plc_active(p))
+  {
+    if(!shared) return malloc(size);
+    void *tmp = mmap(0, size?size:1, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return (tmp == MAP_FAILED)?0:tmp;
+  }
+
+  size_t bytes = mappedSize(p, size);
+  char *buffer = MAP_FAILED;
+  if(p->pages == PLC_PAGES_HUGE)
+  {
+    buffer = mmap(0, bytes, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+    if(buffer == MAP_FAILED && !__atomic_exchange_n(&hugeWarned, 1, __ATOMIC_RELAXED)) fprintf(stderr, "Not enough explicit huge pages reserved, using transparent ones.\n");
+  }
+  if(buffer == MAP_FAILED && p->pages != PLC_PAGES_SMALL && p->pages != PLC_PAGES_DEFAULT)
+  {
+    //over-allocate so the buffer can start at a huge page boundary
+    size_t page = hugePageSize(PLC_PAGES_THP);
+    char *raw = mmap(0, bytes + page, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(raw == MAP_FAILED) return 0;
+    buffer = (char*)(((size_t)raw + page - 1) / page * page);
+    if(buffer > raw) munmap(raw, buffer - raw);
+    munmap(buffer + bytes, raw + page - buffer);
+    madvise(buffer, bytes, MADV_HUGEPAGE);
+  }
+  else if(buffer == MAP_FAILED)
+  {
+    buffer = mmap(0, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if(buffer == MAP_FAILED) return 0;
+    if(p->pages == PLC_PAGES_SMALL) madvise(buffer, bytes, MADV_NOHUGEPAGE);
+  }
+
+  if(p->numa != PLC_NUMA_DEFAULT)
+  {
+    unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))];
+    int i, nodes = plc_nodes(), node = plc_nodeOfCpu(cpu), mode = MPOL_BIND;
+    memset(mask, 0, sizeof(mask));
+    if(p->numa == PLC_NUMA_INTERLEAVE)
+    {
+      mode = MPOL_INTERLEAVE;
+      for(i = 0; i < nodes; i++) mask[i / (8 * sizeof(unsigned long))] |= 1UL << (i % (8 * sizeof(unsigned long)));
+    }
+    else
+    {
+      if(p->numa == PLC_NUMA_REMOTE) node = (node + 1) % nodes;
+      mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+    }
+    //the kernel ignores the last bit of maxnode
+    if(syscall(SYS_mbind, buffer, bytes, mode, mask, MAX_NODES + 1, 0)) perror("Binding a buffer to its NUMA node failed");
+  }
+  return buffer;
+}
+
+/**
+ * @brief frees a buffer allocated by plc_alloc().
+ * @param p placement as given to plc_alloc().
+ * @param buffer pointer to the buffer, may be 0.
+ * @param size size in bytes as given to plc_alloc().
+ * @param shared as given to plc_alloc().
+ */
+void plc_free(const Placement_t *p, void *buffer, size_t size, int shared)
+{
+  if(!buffer) return;
+  if(!plc_active(p) && !shared) free(buffer);
+  else if(!plc_active(p)) munmap(buffer, size?size:1);
+  else munmap(buffer, mappedSize(p, size));
+}
+
+/**
+ * @brief share of a buffer backed by huge pages, transparent or explicit.
+ *
+ * Sums up the huge pages of the mappings overlapping the buffer in /proc/self/smaps.
+ * @param buffer pointer to the buffer.
+ * @param size size in bytes.
+ * @return share between 0 and 1, negative if smaps can't be read.
+ */
+double plc_hugeShare(void *buffer, size_t size)
+{
+  char line[256];
+  unsigned long start, end, from = (unsigned long)buffer, to = from + size;
+  unsigned long long overlap = 0, kb, huge = 0, hugeOfMapping = 0;
+  int inside = 0, hugetlb = 0;
+  FILE *f = fopen("/proc/self/smaps", "r");
+  if(!f || !size)
+  {
+    if(f) fclose(f);
+    return -1;
+  }
+
+  while(fgets(line, sizeof(line), f))
+  {
+    if(sscanf(line, "%lx-%lx ", &start, &end) == 2 && strchr(line, '-') < strchr(line, ' '))
+    {
+      //the huge pages of the previous mapping count as far as it overlaps the buffer
+      if(inside) huge += hugetlb?overlap:((hugeOfMapping < overlap)?hugeOfMapping:overlap);
+      inside = start < to && end > from;
+      overlap = inside?((end < to)?end:to) - ((start > from)?start:from):0;
+      hugeOfMapping = 0;
+      hugetlb = 0;
+    }
+    else if(!inside) continue;
+    else if(sscanf(line, "KernelPageSize: %llu kB", &kb) == 1) hugetlb = kb > 4;
+    else if(sscanf(line, "AnonHugePages: %llu kB", &kb) == 1) hugeOfMapping += kb << 10;
+    else if(sscanf(line, "ShmemPmdMapped: %llu kB", &kb) == 1) hugeOfMapping += kb << 10;
+  }
+  if(inside) huge += hugetlb?overlap:((hugeOfMapping < overlap)?hugeOfMapping:overlap);
+  fclose(f);
+  return (double)huge / size;
+}
+
+/**
+ * @brief share of the pages of a buffer on a node.
+ *
+ * Queries the nodes of up to SHARE_SAMPLES pages spread over the buffer with move_pages(), without moving them.
+ * @param buffer pointer to the buffer.
+ * @param size size in bytes.
+ * @param node node to count.
+ * @return share of the present pages between 0 and 1, negative if the nodes can't be queried.
+ */
+double plc_nodeShare(void *buffer, size_t size, int node)
+{
+  void *pages[SHARE_SAMPLES];
+  int status[SHARE_SAMPLES];
+  size_t page = sysconf(_SC_PAGESIZE), count = (size + page - 1) / page, i, samples = 0, present = 0, onNode = 0;
+  if(!count) return -1;
+  size_t step = (count + SHARE_SAMPLES - 1) / SHARE_SAMPLES;
+  for(i = 0; i < count && samples < SHARE_SAMPLES; i += step) pages[samples++] = (char*)buffer + i * page;
+  if(syscall(SYS_move_pages, 0, samples, pages, 0, status, 0)) return -1;
+  for(i = 0; i < samples; i++)
+  {
+    if(status[i] < 0) continue; //not present
+    present++;
+    if(status[i] == node) onNode++;
+  }
+  return present?(double)onNode / present:-1;
+}
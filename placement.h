@@ -0,0 +1,44 @@
+/**
+ * @file placement.h
+ * @author Roy Freytag
+ *
+ * page size and NUMA node placement of the benchmark buffers
+ */
+
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+#include <stdlib.h>
+
+#define PLC_PAGES_DEFAULT 0 ///< whatever malloc() returns
+#define PLC_PAGES_SMALL   1 ///< base pages only, transparent huge pages disabled for the buffer
+#define PLC_PAGES_THP     2 ///< transparent huge pages, the buffer is aligned to and advised for them
+#define PLC_PAGES_HUGE    3 ///< explicit huge pages from the reserved pool(vm.nr_hugepages)
+
+#define PLC_NUMA_DEFAULT    0 ///< first touch, pages land on the node of the thread writing them first
+#define PLC_NUMA_LOCAL      1 ///< bound to the node of the worker's cpu
+#define PLC_NUMA_INTERLEAVE 2 ///< interleaved over all nodes
+#define PLC_NUMA_REMOTE     3 ///< bound to a node other than the worker's
+
+/**
+ * requested placement of the benchmark buffers
+ */
+typedef struct
+{
+  int pages; ///< one of the PLC_PAGES_ constants
+  int numa; ///< one of the PLC_NUMA_ constants
+} Placement_t;
+
+int   plc_parsePages(const char *name);
+int   plc_parseNuma(const char *name);
+const char *plc_pagesName(int pages);
+const char *plc_numaName(int numa);
+int   plc_active(const Placement_t *p);
+int   plc_nodes(void);
+int   plc_nodeOfCpu(int cpu);
+void *plc_alloc(const Placement_t *p, size_t size, int shared, int cpu);
+void  plc_free(const Placement_t *p, void *buffer, size_t size, int shared);
+double plc_hugeShare(void *buffer, size_t size);
+double plc_nodeShare(void *buffer, size_t size, int node);
+
+#endif /* PLACEMENT_H_ */
@@ -0,0 +1,254 @@
+/**
+ * @file results.c
+ * @author Roy Freytag
+ *
+ * results database: every data point as a record of a JSON Lines and a CSV file, with the machine and build it was measured on.
+ *
+ * Both files get appended to, so one database can collect the benchmarks of many machines and builds. A record is written
+ * field by field, JSON gets them as an object per line, CSV as a row below a header the first record of a new file writes.
+ * Missing numbers are written as null and empty CSV fields. Every record is flushed, so an aborted benchmark keeps the
+ * records of the data points it finished.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/utsname.h>
+
+#include "results.h"
+#include "scheduler.h"
+
+#ifndef BUILD_FLAGS
+#define BUILD_FLAGS "unknown" ///< set by the makefile
+#endif
+#ifndef GIT_REVISION
+#define GIT_REVISION "" ///< set by the makefile
+#endif
+
+/**
+ * @brief collects the machine and build the benchmark runs on.
+ * @param env filled, unknown strings are set to "unknown".
+ */
+void res_environment(Environment_t *env)
+{
+  char line[256];
+  int cpus[CPU_SETSIZE];
+  struct utsname u;
+  memset(env, 0, sizeof(*env));
+
+  if(gethostname(env->host, sizeof(env->host) - 1)) strcpy(env->host, "unknown");
+
+  strcpy(env->cpu, "unknown");
+  FILE *f = fopen("/proc/cpuinfo", "r");
+  while(f && fgets(line, sizeof(line), f))
+  {
+    char *colon = strchr(line, ':');
+    if(strncmp(line, "model name", 10) || !colon) continue;
+    colon += strspn(colon + 1, " \t") + 1;
+    colon[strcspn(colon, "\n")] = 0;
+    snprintf(env->cpu, sizeof(env->cpu), "%s", colon);
+    break;
+  }
+  if(f) fclose(f);
+
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  env->cpus = (online > 0)?online:1;
+  env->cores = sch_physicalCores(cpus, CPU_SETSIZE);
+
+  if(uname(&u)) strcpy(env->kernel, "unknown");
+  else snprintf(env->kernel, sizeof(env->kernel), "%s %s %s %s", u.sysname, u.release, u.version, u.machine);
+
+#if defined(__clang__)
+  snprintf(env->compiler, sizeof(env->compiler), "%s", __VERSION__);
+#elif defined(__GNUC__)
+  snprintf(env->compiler, sizeof(env->compiler), "gcc %s", __VERSION__);
+#else
+  strcpy(env->compiler, "unknown");
+#endif
+  snprintf(env->flags, sizeof(env->flags), "%s", BUILD_FLAGS);
+  snprintf(env->revision, sizeof(env->revision), "%s", strlen(GIT_REVISION)?GIT_REVISION:"unknown");
+}
+
+/**
+ * @brief hashes a file with 64 bit FNV-1a, to tell builds of a module apart.
+ * @param path file to hash.
+ * @param hash gets RES_HASH_SIZE characters, the hash as hex digits.
+ * @return 0 on success, -1 if the file couldn't be read.
+ */
+int res_hashFile(const char *path, char *hash)
+{
+  unsigned char buffer[1 << 16];
+  unsigned long long h = 0xcbf29ce484222325ULL;
+  size_t n, i;
+  FILE *f = fopen(path, "rb");
+  strcpy(hash, "unknown");
+  if(!f) return -1;
+  while((n = fread(buffer, 1, sizeof(buffer), f)) > 0)
+  {
+    for(i = 0; i < n; i++) h = (h ^ buffer[i]) * 0x100000001b3ULL;
+  }
+  int failed = ferror(f);
+  fclose(f);
+  if(failed) return -1;
+  snprintf(hash, RES_HASH_SIZE, "%016llx", h);
+  return 0;
+}
+
+/**
+ * @brief opens a results database for appending.
+ * @param path path of the database without extension, .jsonl and .csv get appended.
+ * @return the database, 0 if neither file could be opened.
+ */
+ResultsFile_t *res_open(const char *path)
+{
+  char name[512];
+  ResultsFile_t *rf = calloc(1, sizeof(ResultsFile_t));
+  if(!rf) return 0;
+  snprintf(name, sizeof(name), "%s.jsonl", path);
+  rf->json = fopen(name, "a");
+  snprintf(name, sizeof(name), "%s.csv", path);
+  rf->csv = fopen(name, "a");
+  if(rf->csv) rf->header = !fseek(rf->csv, 0, SEEK_END) && ftell(rf->csv) == 0;
+  if(!rf->json && !rf->csv)
+  {
+    free(rf);
+    return 0;
+  }
+  return rf;
+}
+
+/**
+ * @brief closes a results database.
+ * @param rf database, may be 0.
+ */
+void res_close(ResultsFile_t *rf)
+{
+  if(!rf) return;
+  if(rf->json) fclose(rf->json);
+  if(rf->csv) fclose(rf->csv);
+  free(rf);
+}
+
+/**
+ * @brief starts a record.
+ */
+void res_begin(ResultsFile_t *rf)
+{
+  rf->fields = 0;
+  rf->values = open_memstream(&rf->line, &rf->lineSize);
+  rf->columns = rf->header?open_memstream(&rf->names, &rf->namesSize):0;
+  if(rf->json) fputc('{', rf->json);
+}
+
+/**
+ * @brief writes the separator and name of the next field.
+ */
+static void field(ResultsFile_t *rf, const char *name)
+{
+  if(rf->fields++)
+  {
+    if(rf->json) fputc(',', rf->json);
+    if(rf->values) fputc(',', rf->values);
+    if(rf->columns) fputc(',', rf->columns);
+  }
+  if(rf->json) fprintf(rf->json, "\"%s\":", name);
+  if(rf->columns) fputs(name, rf->columns);
+}
+
+/**
+ * @brief adds a string field to the record.
+ * @param value string, 0 for a missing one.
+ */
+void res_string(ResultsFile_t *rf, const char *name, const char *value)
+{
+  const char *c;
+  field(rf, name);
+  if(!value)
+  {
+    if(rf->json) fputs("null", rf->json);
+    return;
+  }
+
+  if(rf->json)
+  {
+    fputc('"', rf->json);
+    for(c = value; *c; c++)
+    {
+      if(*c == '"' || *c == '\\') fprintf(rf->json, "\\%c", *c);
+      else if((unsigned char)*c < 0x20) fprintf(rf->json, "\\u%04x", *c);
+      else fputc(*c, rf->json);
+    }
+    fputc('"', rf->json);
+  }
+
+  //CSV fields only need quotes if they contain separators, quotes or line breaks, quotes are doubled
+  if(rf->values && strpbrk(value, ",\"\r\n"))
+  {
+    fputc('"', rf->values);
+    for(c = value; *c; c++)
+    {
+      if(*c == '"') fputc('"', rf->values);
+      fputc(*c, rf->values);
+    }
+    fputc('"', rf->values);
+  }
+  else if(rf->values) fputs(value, rf->values);
+}
+
+/**
+ * @brief adds an integer field to the record.
+ */
+void res_integer(ResultsFile_t *rf, const char *name, unsigned long long value)
+{
+  field(rf, name);
+  if(rf->json) fprintf(rf->json, "%llu", value);
+  if(rf->values) fprintf(rf->values, "%llu", value);
+}
+
+/**
+ * @brief adds a number field to the record.
+ * @param value number, NAN for a missing one.
+ */
+void res_number(ResultsFile_t *rf, const char *name, double value)
+{
+  field(rf, name);
+  if(!isfinite(value))
+  {
+    if(rf->json) fputs("null", rf->json);
+    return;
+  }
+  if(rf->json) fprintf(rf->json, "%.15g", value);
+  if(rf->values) fprintf(rf->values, "%.15g", value);
+}
+
+/**
+ * @brief finishes a record and writes it.
+ */
+void res_end(ResultsFile_t *rf)
+{
+  if(rf->json)
+  {
+    fputs("}\n", rf->json);
+    fflush(rf->json);
+  }
+  if(rf->columns)
+  {
+    fclose(rf->columns);
+    if(rf->csv) fprintf(rf->csv, "%s\n", rf->names);
+    free(rf->names);
+    rf->columns = 0;
+    rf->names = 0;
+    rf->header = 0;
+  }
+  if(rf->values)
+  {
+    fclose(rf->values);
+    if(rf->csv) fprintf(rf->csv, "%s\n", rf->line);
+    free(rf->line);
+    rf->values = 0;
+    rf->line = 0;
+  }
+  if(rf->csv) fflush(rf->csv);
+}
@@ -0,0 +1,58 @@
+/**
+ * @file results.h
+ * @author Roy Freytag
+ *
+ * results database: every data point as a record of a JSON Lines and a CSV file, with the machine and build it was measured on
+ */
+
+#ifndef RESULTS_H_
+#define RESULTS_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define RES_HASH_SIZE 17 ///< characters of a file hash, including the terminating 0
+
+/**
+ * machine and build a benchmark runs on
+ */
+typedef struct
+{
+  char host[64]; ///< host name
+  char cpu[128]; ///< model name of the cpu
+  unsigned cpus; ///< online cpus
+  unsigned cores; ///< physical cores
+  char kernel[264]; ///< kernel name, release, version and architecture
+  char compiler[64]; ///< compiler the harness was built with
+  char flags[160]; ///< compiler and linker flags of the harness
+  char revision[64]; ///< git revision of the harness, "unknown" outside of a repository
+} Environment_t;
+
+/**
+ * results database being written
+ */
+typedef struct
+{
+  FILE *json; ///< JSON Lines file, 0 if it couldn't be opened
+  FILE *csv; ///< CSV file, 0 if it couldn't be opened
+  int header; ///< 1 if the CSV file is new and the first record has to write the header
+  char *line; ///< CSV values of the current record
+  size_t lineSize; ///< size of line
+  FILE *values; ///< stream writing line
+  char *names; ///< CSV header of the current record
+  size_t namesSize; ///< size of names
+  FILE *columns; ///< stream writing names
+  int fields; ///< fields of the current record so far
+} ResultsFile_t;
+
+void res_environment(Environment_t *env);
+int  res_hashFile(const char *path, char *hash);
+ResultsFile_t *res_open(const char *path);
+void res_close(ResultsFile_t *rf);
+void res_begin(ResultsFile_t *rf);
+void res_string(ResultsFile_t *rf, const char *name, const char *value);
+void res_integer(ResultsFile_t *rf, const char *name, unsigned long long value);
+void res_number(ResultsFile_t *rf, const char *name, double value);
+void res_end(ResultsFile_t *rf);
+
+#endif /* RESULTS_H_ */
@@ -0,0 +1,224 @@
+/**
+ * @file rng.c
+ * @author Roy Freytag
+ *
+ * fast, seedable pseudo random number generator.
+ *
+ * Implements xoshiro256** by D. Blackman and S. Vigna, seeded through splitmix64.
+ * Large arrays are filled in chunks of RNG_CHUNK elements, chunk c uses the stream jumped ahead c times.
+ * So the generated data only depends on the seed, not on the number of threads filling it,
+ * and the first n elements are the same no matter how large the whole array is.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "rng.h"
+
+/**
+ * @brief rotates x left by k bits.
+ */
+static inline uint64_t rotl(const uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief seeds the generator.
+ * @param rng generator.
+ * @param seed seed, every value including 0 is fine.
+ */
+void rng_seed(Rng_t *rng, uint64_t seed)
+{
+  int i;
+  for(i = 0; i < 4; i++) //splitmix64
+  {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    rng->s[i] = z ^ (z >> 31);
+  }
+}
+
+/**
+ * @brief next 64 random bits.
+ * @param rng generator.
+ */
+uint64_t rng_next(Rng_t *rng)
+{
+  uint64_t *s = rng->s;
+  const uint64_t result = rotl(s[1] * 5, 7) * 9;
+  const uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+}
+
+/**
+ * @brief advances the generator by 2^128 steps.
+ *
+ * Streams jumped a different number of times don't overlap.
+ * @param rng generator.
+ */
+void rng_jump(Rng_t *rng)
+{
+  static const uint64_t jump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+  uint64_t s[4] = {0, 0, 0, 0};
+  int i, b;
+  for(i = 0; i < 4; i++)
+  {
+    for(b = 0; b < 64; b++)
+    {
+      if(jump[i] & (1ULL << b))
+      {
+        s[0] ^= rng->s[0];
+        s[1] ^= rng->s[1];
+        s[2] ^= rng->s[2];
+        s[3] ^= rng->s[3];
+      }
+      rng_next(rng);
+    }
+  }
+  rng->s[0] = s[0];
+  rng->s[1] = s[1];
+  rng->s[2] = s[2];
+  rng->s[3] = s[3];
+}
+
+/**
+ * @brief uniformly distributed number in [0, bound).
+ *
+ * Uses D. Lemire's multiply and reject method, so there is no modulo bias.
+ * @param rng generator.
+ * @param bound upper bound, exclusive.
+ */
+uint64_t rng_bounded(Rng_t *rng, uint64_t bound)
+{
+  if(!bound) return 0;
+  unsigned __int128 m = (unsigned __int128)rng_next(rng) * bound;
+  uint64_t l = (uint64_t)m;
+  if(l < bound)
+  {
+    uint64_t t = -bound % bound;
+    while(l < t)
+    {
+      m = (unsigned __int128)rng_next(rng) * bound;
+      l = (uint64_t)m;
+    }
+  }
+  return m >> 64;
+}
+
+/**
+ * @brief uniformly distributed double in [0, 1).
+ * @param rng generator.
+ */
+double rng_double(Rng_t *rng)
+{
+  return (rng_next(rng) >> 11) * 0x1.0p-53;
+}
+
+/**
+ * arguments of a fill thread
+ */
+typedef struct
+{
+  size_t n; ///< number of elements to fill
+  uint64_t seed; ///< seed of the whole fill
+  unsigned thread; ///< index of this thread
+  unsigned threads; ///< number of threads
+  rngChunkFn_t fn; ///< chunk fill function
+  void *arg; ///< argument for fn
+} RngFill_t;
+
+/**
+ * @brief fills every threads-th chunk, starting with chunk thread.
+ * @param arg pointer to RngFill_t.
+ */
+static void *fillThread(void *arg)
+{
+  RngFill_t *f = arg;
+  Rng_t rng;
+  size_t chunk, begin, end;
+  unsigned i;
+
+  rng_seed(&rng, f->seed);
+  for(i = 0; i < f->thread; i++) rng_jump(&rng);
+
+  for(chunk = f->thread; chunk * RNG_CHUNK < f->n; chunk += f->threads)
+  {
+    begin = chunk * RNG_CHUNK;
+    end = (begin + RNG_CHUNK < f->n)?begin + RNG_CHUNK:f->n;
+
+    Rng_t stream = rng; //keep rng at the chunk start, so jumping to the next chunk doesn't depend on how much fn consumed
+    f->fn(&stream, begin, end, f->arg);
+    for(i = 0; i < f->threads; i++) rng_jump(&rng);
+  }
+  return 0;
+}
+
+/**
+ * @brief fills n elements in chunks, spread over several threads.
+ *
+ * fn is called for every chunk with the generator stream of that chunk.
+ * @param n number of elements.
+ * @param seed seed of the fill.
+ * @param threads maximum number of threads to use, small fills are done by the calling thread only.
+ * @param fn chunk fill function.
+ * @param arg argument for fn.
+ */
+void rng_parallel(size_t n, uint64_t seed, unsigned threads, rngChunkFn_t fn, void *arg)
+{
+  size_t chunks = (n + RNG_CHUNK - 1) / RNG_CHUNK;
+  unsigned i;
+  if(threads > chunks) threads = chunks;
+  if(threads < 1) threads = 1;
+
+  RngFill_t *fills = malloc(sizeof(RngFill_t) * threads);
+  pthread_t *tids = malloc(sizeof(pthread_t) * threads);
+  if(!fills || !tids) threads = 1;
+
+  RngFill_t single;
+  if(threads == 1)
+  {
+    single.n = n;
+    single.seed = seed;
+    single.thread = 0;
+    single.threads = 1;
+    single.fn = fn;
+    single.arg = arg;
+    fillThread(&single);
+    free(fills);
+    free(tids);
+    return;
+  }
+
+  for(i = 0; i < threads; i++)
+  {
+    fills[i].n = n;
+    fills[i].seed = seed;
+    fills[i].thread = i;
+    fills[i].threads = threads;
+    fills[i].fn = fn;
+    fills[i].arg = arg;
+    if(pthread_create(&tids[i], 0, fillThread, &fills[i]))
+    {
+      fillThread(&fills[i]); //couldn't start a thread, do its share ourselves
+      tids[i] = 0;
+    }
+  }
+  for(i = 0; i < threads; i++)
+  {
+    if(tids[i]) pthread_join(tids[i], 0);
+  }
+
+  free(fills);
+  free(tids);
+}
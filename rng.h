@@ -0,0 +1,35 @@
+/**
+ * @file rng.h
+ * @author Roy Freytag
+ *
+ * fast, seedable pseudo random number generator(xoshiro256**)
+ */
+
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#define RNG_CHUNK (1 << 16) ///< elements per chunk when filling in parallel, every chunk gets its own jumped stream
+
+/**
+ * state of the generator
+ */
+typedef struct
+{
+  uint64_t s[4]; ///< xoshiro256 state, must not be all zero
+} Rng_t;
+
+typedef void (*rngChunkFn_t)(Rng_t*, size_t, size_t, void*); ///< Function-pointer type definition for chunk fill functions, gets the range [begin, end) to fill
+
+void     rng_seed(Rng_t *rng, uint64_t seed);
+uint64_t rng_next(Rng_t *rng);
+void     rng_jump(Rng_t *rng);
+
+uint64_t rng_bounded(Rng_t *rng, uint64_t bound);
+double   rng_double(Rng_t *rng);
+
+void     rng_parallel(size_t n, uint64_t seed, unsigned threads, rngChunkFn_t fn, void *arg);
+
+#endif /* RNG_H_ */
@@ -0,0 +1,248 @@
+/**
+ * @file scheduler.c
+ * @author Roy Freytag
+ *
+ * runs independent benchmark jobs concurrently on pinned worker threads.
+ *
+ * Every worker is pinned to its own cpu and takes the next job from a shared counter.
+ * Completed jobs are handed to the completion callback by the calling thread strictly in job order,
+ * so the output doesn't depend on which worker finished first.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+
+#include "scheduler.h"
+
+/**
+ * shared state of a scheduler run
+ */
+typedef struct
+{
+  size_t jobs; ///< number of jobs
+  size_t next; ///< next job to be taken by a worker
+  char *done; ///< per job flag, set when it is completed
+  jobFn_t run; ///< job function
+  void *arg; ///< argument of the job function and the callback
+  pthread_mutex_t lock; ///< protects next and done
+  pthread_cond_t cond; ///< signaled whenever a job is completed
+} Schedule_t;
+
+/**
+ * arguments of a worker thread
+ */
+typedef struct
+{
+  Schedule_t *schedule; ///< shared state
+  unsigned worker; ///< index of the worker
+  int cpu; ///< cpu to pin to, -1 to not pin
+} Worker_t;
+
+/**
+ * @brief reads an integer from a sysfs file.
+ * @return the value or -1 if it couldn't be read.
+ */
+static int readSysInt(const char *path)
+{
+  int v = -1;
+  FILE *f = fopen(path, "r");
+  if(!f) return -1;
+  if(fscanf(f, "%d", &v) != 1) v = -1;
+  fclose(f);
+  return v;
+}
+
+/**
+ * @brief parses a cpu list like "0-3,8,10-11".
+ * @param list list to parse.
+ * @param cpus array to fill with the cpu numbers.
+ * @param max size of cpus.
+ * @return number of cpus parsed.
+ */
+unsigned sch_parseCpuList(const char *list, int *cpus, unsigned max)
+{
+  unsigned count = 0;
+  int from, to, len;
+  const char *c = list;
+  while(*c && count < max)
+  {
+    if(sscanf(c, "%d%n", &from, &len) != 1) break;
+    c += len;
+    to = from;
+    if(*c == '-')
+    {
+      c++;
+      if(sscanf(c, "%d%n", &to, &len) != 1) break;
+      c += len;
+    }
+    for(; from <= to && count < max; from++) cpus[count++] = from;
+    if(*c == ',') c++;
+  }
+  return count;
+}
+
+/**
+ * @brief selects one logical cpu of every physical core the process may run on.
+ *
+ * SMT siblings share the execution units and caches of a core, so jobs on them would disturb each other.
+ * If the topology isn't available, every cpu is considered a core of its own.
+ * @param cpus array to fill with the cpu numbers.
+ * @param max size of cpus.
+ * @return number of cpus selected.
+ */
+unsigned sch_physicalCores(int *cpus, unsigned max)
+{
+  cpu_set_t set;
+  unsigned count = 0, j;
+  int cpu;
+  char path[128];
+
+  if(sched_getaffinity(0, sizeof(set), &set)) return 0;
+
+  int *cores = malloc(sizeof(int) * 2 * max); //package and core id of every selected cpu
+  if(!cores) return 0;
+
+  for(cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++)
+  {
+    if(!CPU_ISSET(cpu, &set)) continue;
+
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    int package = readSysInt(path);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", cpu);
+    int core = readSysInt(path);
+
+    if(core >= 0)
+    {
+      for(j = 0; j < count; j++)
+      {
+        if(cores[2*j] == package && cores[2*j+1] == core) break;
+      }
+      if(j < count) continue; //sibling of an already selected cpu
+    }
+
+    cores[2*count] = package;
+    cores[2*count+1] = (core >= 0)?core:-1 - cpu;
+    cpus[count++] = cpu;
+  }
+
+  free(cores);
+  return count;
+}
+
+/**
+ * @brief pins the calling thread to a cpu.
+ * @param cpu cpu number.
+ * @return 0 on success, -1 otherwise.
+ */
+int sch_pinThread(int cpu)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set); //pid 0 is the calling thread
+}
+
+/**
+ * @brief worker thread, takes jobs until there are none left.
+ * @param arg pointer to Worker_t.
+ */
+static void *workerThread(void *arg)
+{
+  Worker_t *w = arg;
+  Schedule_t *s = w->schedule;
+  size_t job;
+
+  if(w->cpu >= 0 && sch_pinThread(w->cpu)) perror("Pinning worker failed");
+
+  while(1)
+  {
+    pthread_mutex_lock(&s->lock);
+    job = s->next++;
+    pthread_mutex_unlock(&s->lock);
+    if(job >= s->jobs) break;
+
+    s->run(job, w->worker, s->arg);
+
+    pthread_mutex_lock(&s->lock);
+    s->done[job] = 1;
+    pthread_cond_broadcast(&s->cond);
+    pthread_mutex_unlock(&s->lock);
+  }
+  return 0;
+}
+
+/**
+ * @brief runs all jobs on the given number of workers.
+ *
+ * The completion callback is called by the calling thread for every job in order, as soon as it and all jobs before it are done.
+ * @param jobs number of jobs.
+ * @param cpus cpus to pin the workers to, one per worker, 0 to not pin them.
+ * @param workers number of worker threads.
+ * @param run job function, called by the workers.
+ * @param done completion callback, may be 0.
+ * @param arg argument for run and done.
+ * @return 0 on success, -1 if the scheduler couldn't be set up.
+ */
+int sch_run(size_t jobs, int *cpus, unsigned workers, jobFn_t run, jobDoneFn_t done, void *arg)
+{
+  Schedule_t s;
+  unsigned i;
+  size_t job;
+
+  if(workers < 1) workers = 1;
+
+  s.jobs = jobs;
+  s.next = 0;
+  s.run = run;
+  s.arg = arg;
+  s.done = calloc(jobs?jobs:1, 1);
+  Worker_t *w = malloc(sizeof(Worker_t) * workers);
+  pthread_t *tids = malloc(sizeof(pthread_t) * workers);
+  char *started = calloc(workers, 1);
+  if(!s.done || !w || !tids || !started)
+  {
+    free(s.done);
+    free(w);
+    free(tids);
+    free(started);
+    return -1;
+  }
+  pthread_mutex_init(&s.lock, 0);
+  pthread_cond_init(&s.cond, 0);
+
+  for(i = 0; i < workers; i++)
+  {
+    w[i].schedule = &s;
+    w[i].worker = i;
+    w[i].cpu = cpus?cpus[i]:-1;
+    started[i] = !pthread_create(&tids[i], 0, workerThread, &w[i]);
+    if(!started[i]) fprintf(stderr, "Starting worker %u failed!\n", i);
+  }
+
+  for(i = 0; i < workers && !started[i]; i++);
+  if(i == workers) workerThread(&w[0]); //no worker could be started, do all jobs ourselves
+
+  for(job = 0; job < jobs; job++)
+  {
+    pthread_mutex_lock(&s.lock);
+    while(!s.done[job]) pthread_cond_wait(&s.cond, &s.lock);
+    pthread_mutex_unlock(&s.lock);
+    if(done) done(job, arg);
+  }
+
+  for(i = 0; i < workers; i++)
+  {
+    if(started[i]) pthread_join(tids[i], 0);
+  }
+
+  pthread_cond_destroy(&s.cond);
+  pthread_mutex_destroy(&s.lock);
+  free(s.done);
+  free(w);
+  free(tids);
+  free(started);
+  return 0;
+}
@@ -0,0 +1,22 @@
+/**
+ * @file scheduler.h
+ * @author Roy Freytag
+ *
+ * runs independent benchmark jobs concurrently on pinned worker threads
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdlib.h>
+
+typedef void (*jobFn_t)(size_t, unsigned, void*); ///< Function-pointer type definition for job functions, gets the job and the worker index
+typedef void (*jobDoneFn_t)(size_t, void*); ///< Function-pointer type definition for the completion callback, gets the job index
+
+unsigned sch_parseCpuList(const char *list, int *cpus, unsigned max);
+unsigned sch_physicalCores(int *cpus, unsigned max);
+int      sch_pinThread(int cpu);
+
+int      sch_run(size_t jobs, int *cpus, unsigned workers, jobFn_t run, jobDoneFn_t done, void *arg);
+
+#endif /* SCHEDULER_H_ */
@@ -0,0 +1,193 @@
+/**
+ * @file sizes.c
+ * @author Roy Freytag
+ *
+ * sample sizes: the cache-aware sweep, overflow checked arithmetic on them and the memory available to their buffers.
+ *
+ * The sizes are spread geometrically between start and end, with perDecade points per power of 10, and get denser
+ * around the sizes at which the elements outgrow a cache level, as that's where the time per element changes.
+ * Their density on the log10 scale is perDecade plus a bump of SWEEP_EXTRA points around every boundary.
+ * The sizes are the quantiles of that density, so the number of sizes doesn't depend on the element size,
+ * only where they lie does, and every key type gets a series of the same length.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "sizes.h"
+
+#define SWEEP_EXTRA 3 ///< additional points around every boundary
+#define SWEEP_WIDTH 0.1 ///< standard deviation of the bumps around the boundaries in decades
+#define DRAM_FACTOR 2 ///< the elements count as DRAM-bound once the last level holds less than 1/DRAM_FACTOR of them
+
+/**
+ * @brief reads the data cache levels of cpu0 and adds DRAM behind the last one.
+ * @param boundaries array to fill, ordered by size.
+ * @param max size of boundaries.
+ * @return number of boundaries, 0 if the cache sizes aren't available.
+ */
+unsigned siz_cacheBoundaries(CacheBoundary_t *boundaries, unsigned max)
+{
+  char path[128], type[32], unit;
+  unsigned count = 0, index, level, i;
+  unsigned long size;
+  for(index = 0; count + 1 < max; index++)
+  {
+    FILE *f;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", index);
+    if(!(f = fopen(path, "r"))) break;
+    if(fscanf(f, "%u", &level) != 1) level = 0;
+    fclose(f);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/type", index);
+    if(!(f = fopen(path, "r"))) continue;
+    if(fscanf(f, "%31s", type) != 1) type[0] = 0;
+    fclose(f);
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", index);
+    if(!(f = fopen(path, "r"))) continue;
+    unit = 0;
+    if(fscanf(f, "%lu%c", &size, &unit) < 1) size = 0;
+    fclose(f);
+    if(!strcmp(type, "Instruction") || !size) continue;
+    if(unit == 'K') size <<= 10;
+    else if(unit == 'M') size <<= 20;
+    else if(unit == 'G') size <<= 30;
+
+    snprintf(boundaries[count].name, sizeof(boundaries[count].name), (level == 1)?"L%ud":"L%u", level);
+    boundaries[count++].size = size;
+  }
+  if(!count) return 0;
+
+  //the index order is the level order on every known system, but don't rely on it
+  for(index = 1; index < count; index++)
+  {
+    for(i = index; i > 0 && boundaries[i - 1].size > boundaries[i].size; i--)
+    {
+      CacheBoundary_t tmp = boundaries[i];
+      boundaries[i] = boundaries[i - 1];
+      boundaries[i - 1] = tmp;
+    }
+  }
+  snprintf(boundaries[count].name, sizeof(boundaries[count].name), "DRAM");
+  boundaries[count].size = boundaries[count - 1].size * DRAM_FACTOR;
+  return count + 1;
+}
+
+/**
+ * @brief number of sizes of a sweep.
+ * @param start smallest size.
+ * @param end largest size.
+ * @param perDecade points per power of 10 apart from the boundaries.
+ * @param boundaryCount number of boundaries.
+ */
+size_t siz_sweepLength(size_t start, size_t end, double perDecade, unsigned boundaryCount)
+{
+  if(start < 1) start = 1;
+  if(end <= start) return 1;
+  return (size_t)ceil(perDecade * log10((double)end / start)) + 1 + SWEEP_EXTRA * boundaryCount;
+}
+
+/**
+ * @brief number of points of the density up to u on the log10 scale, relative to a.
+ */
+static double cumulative(double u, double a, double perDecade, const double *centers, unsigned count)
+{
+  double sum = perDecade * (u - a);
+  unsigned i;
+  for(i = 0; i < count; i++)
+  {
+    sum += SWEEP_EXTRA * 0.5 * (erf((u - centers[i]) / (SWEEP_WIDTH * M_SQRT2)) - erf((a - centers[i]) / (SWEEP_WIDTH * M_SQRT2)));
+  }
+  return sum;
+}
+
+/**
+ * @brief calculates the sizes of a sweep for an element size.
+ * @param start smallest size in elements.
+ * @param end largest size in elements.
+ * @param perDecade points per power of 10 apart from the boundaries.
+ * @param boundaries boundaries in bytes.
+ * @param boundaryCount number of boundaries.
+ * @param elementSize bytes per element, converts the boundaries to elements.
+ * @param sizes gets the sizes in ascending order.
+ * @param count number of sizes, from siz_sweepLength().
+ */
+void siz_sweep(size_t start, size_t end, double perDecade, const CacheBoundary_t *boundaries, unsigned boundaryCount,
+               size_t elementSize, size_t *sizes, size_t count)
+{
+  double centers[SIZ_MAX_BOUNDARIES];
+  unsigned i, k;
+  if(start < 1) start = 1;
+  if(end < start) end = start;
+  if(boundaryCount > SIZ_MAX_BOUNDARIES) boundaryCount = SIZ_MAX_BOUNDARIES;
+  for(i = 0; i < boundaryCount; i++) centers[i] = log10((double)boundaries[i].size / elementSize);
+
+  double a = log10(start), b = log10(end);
+  double total = cumulative(b, a, perDecade, centers, boundaryCount);
+  for(i = 0; i < count; i++)
+  {
+    //bisect for the quantile i / (count - 1), so the first size is start and the last one end
+    double target = (count > 1)?total * i / (count - 1):0, lo = a, hi = b;
+    for(k = 0; k < 60; k++)
+    {
+      double mid = (lo + hi) / 2;
+      if(cumulative(mid, a, perDecade, centers, boundaryCount) < target) lo = mid;
+      else hi = mid;
+    }
+    sizes[i] = (size_t)llround(pow(10, (lo + hi) / 2));
+    if(sizes[i] > end) sizes[i] = end;
+  }
+  if(count) sizes[count - 1] = end;
+}
+
+/**
+ * @brief multiplies two sizes.
+ * @return a * b, SIZE_MAX if that doesn't fit into a size_t.
+ */
+size_t siz_multiply(size_t a, size_t b)
+{
+  size_t r;
+  if(__builtin_mul_overflow(a, b, &r)) return SIZE_MAX;
+  return r;
+}
+
+/**
+ * @brief adds two sizes.
+ * @return a + b, SIZE_MAX if that doesn't fit into a size_t.
+ */
+size_t siz_add(size_t a, size_t b)
+{
+  size_t r;
+  if(__builtin_add_overflow(a, b, &r)) return SIZE_MAX;
+  return r;
+}
+
+/**
+ * @brief memory that can be allocated without swapping.
+ *
+ * MemAvailable of /proc/meminfo, the free and reclaimable memory, or the free physical pages on older kernels.
+ * @return bytes, 0 if unknown.
+ */
+size_t siz_availableMemory(void)
+{
+  char line[128];
+  unsigned long long kb;
+  FILE *f = fopen("/proc/meminfo", "r");
+  if(f)
+  {
+    while(fgets(line, sizeof(line), f))
+    {
+      if(sscanf(line, "MemAvailable: %llu kB", &kb) == 1)
+      {
+        fclose(f);
+        return siz_multiply(kb, 1024);
+      }
+    }
+    fclose(f);
+  }
+  long pages = sysconf(_SC_AVPHYS_PAGES), pageSize = sysconf(_SC_PAGESIZE);
+  if(pages <= 0 || pageSize <= 0) return 0;
+  return siz_multiply(pages, pageSize);
+}
@@ -0,0 +1,32 @@
+/**
+ * @file sizes.h
+ * @author Roy Freytag
+ *
+ * sample sizes of a cache-aware sweep, overflow checked size arithmetic and the memory available to the benchmark
+ */
+
+#ifndef SIZES_H_
+#define SIZES_H_
+
+#include <stdlib.h>
+
+#define SIZ_MAX_BOUNDARIES 8 ///< cache levels plus DRAM a sweep knows about
+
+/**
+ * size at which the elements outgrow a level of the memory hierarchy
+ */
+typedef struct
+{
+  char name[8]; ///< name of the level, e.g. L2
+  size_t size; ///< bytes the level holds
+} CacheBoundary_t;
+
+unsigned siz_cacheBoundaries(CacheBoundary_t *boundaries, unsigned max);
+size_t   siz_sweepLength(size_t start, size_t end, double perDecade, unsigned boundaryCount);
+void     siz_sweep(size_t start, size_t end, double perDecade, const CacheBoundary_t *boundaries, unsigned boundaryCount,
+                   size_t elementSize, size_t *sizes, size_t count);
+size_t   siz_multiply(size_t a, size_t b);
+size_t   siz_add(size_t a, size_t b);
+size_t   siz_availableMemory(void);
+
+#endif /* SIZES_H_ */
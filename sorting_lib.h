@@ -5,10 +5,101 @@
  * @author Roy Freytag
  * @brief Definitions for function-pointers required in the dynamically loaded modules
  *
+ * A module needs to export getSortName() and either
+ * - ABI v1: getSortSymbol() naming a sort function of type sortFn_t, or
+ * - ABI v2: getSortAbiVersion() returning SORT_ABI_VERSION and getSortCapabilities(), whose contextSymbol names a sort function of type sortCtxFn_t.
+ *
+ * v2 modules may export getSortSymbol() as well, the benchmark will prefer the context-taking entry though.
+ *
+ * Modules of either ABI may additionally export type-specialized entries of type sortTypedFn_t, named SORT_TYPED_PREFIX and
+ * the name of the key type, e.g. void sort_i32(int32_t*, size_t), void sort_u64(uint64_t*, size_t) or void sort_f64(double*, size_t).
+ * They sort in ascending order without a comparison function, so the comparisons can be inlined.
+ * As they have nothing to count with, an instrumented build of the module(lib<name>-instrumented.so.1.0)
+ * exporting the thread-local counter SORT_COMPARE_COUNTER may be put next to it, it is used to count comparisons and swaps.
+ *
+ * External-memory modules export SORT_FILE_SYMBOL of type sortFileFn_t, which sorts the elements of a file into another file
+ * within a memory budget. The benchmark only runs those in its file mode(--external).
+ *
+ * Selection modules export SORT_SELECT_SYMBOL, partial-sort modules SORT_PARTIAL_SYMBOL, both of type sortSelectFn_t.
+ * The benchmark only runs those in its selection mode(--select), a module exporting both gets its partial sort benchmarked.
  */
 
+#include <stdlib.h>
+
+#define SORT_ABI_VERSION 2 ///< current module ABI version
+
 typedef char* (*getSortNameFn_t)(void); ///< Function-pointer type definition for Sort name getter
 typedef char* (*getSortSymbolFn_t)(void); ///< Function-pointer type definition for Sort function symbol name getter
 typedef void (*sortFn_t)(void*, size_t, size_t, int (*)(void*,void*)); ///< Function-pointer type definition for sort function, based on qsort
 
+//capability flags of v2 modules
+#define SORT_CAP_STABLE   (1 << 0) ///< equal elements keep their order
+#define SORT_CAP_INPLACE  (1 << 1) ///< needs no more than O(log n) extra memory
+#define SORT_CAP_PARALLEL (1 << 2) ///< uses SortContext_t::threads threads
+#define SORT_CAP_SCRATCH  (1 << 3) ///< wants a scratch buffer of n elements in SortContext_t::scratch
+
+//key types, as bits of SortCapabilities_t::keyTypes and value of SortContext_t::keyType
+#define SORT_KEY_NONE 0 ///< unknown key, only the comparison function may be used
+#define SORT_KEY_I32 (1 << 0) ///< int32_t key
+#define SORT_KEY_I64 (1 << 1) ///< int64_t key
+#define SORT_KEY_F32 (1 << 2) ///< float key
+#define SORT_KEY_F64 (1 << 3) ///< double key
+#define SORT_KEY_STR (1 << 4) ///< pointer to a zero terminated string
+#define SORT_KEY_U64 (1 << 5) ///< uint64_t key
+
+/**
+ * capabilities a v2 module declares
+ */
+typedef struct
+{
+  unsigned flags; ///< SORT_CAP_ flags
+  unsigned keyTypes; ///< SORT_KEY_ bits of the supported key types, 0 if the module sorts any elements through the comparison function
+  unsigned maxThreads; ///< maximum number of threads the module makes use of, 0 for no limit
+  const char *contextSymbol; ///< symbol name of the sortCtxFn_t entry
+} SortCapabilities_t;
+
+/**
+ * everything a v2 sort function gets besides the elements
+ */
+typedef struct
+{
+  int (*compare)(const void*, const void*, void*); ///< comparison function, gets compareArg as third parameter
+  void *compareArg; ///< argument for compare
+  unsigned keyType; ///< SORT_KEY_ type of the key, SORT_KEY_NONE if the module has to use compare
+  size_t keyOffset; ///< offset of the key inside an element
+  unsigned threads; ///< number of threads the module may use
+  void *scratch; ///< scratch buffer of n elements if SORT_CAP_SCRATCH was declared, 0 otherwise
+  size_t scratchSize; ///< size of scratch in bytes
+} SortContext_t;
+
+typedef unsigned (*getSortAbiVersionFn_t)(void); ///< Function-pointer type definition for the ABI version getter
+typedef const SortCapabilities_t* (*getSortCapabilitiesFn_t)(void); ///< Function-pointer type definition for the capabilities getter
+typedef void (*sortCtxFn_t)(void*, size_t, size_t, SortContext_t*); ///< Function-pointer type definition for context-taking sort functions
+
+#define SORT_TYPED_PREFIX "sort_" ///< prefix of the type-specialized entries, followed by the key type name
+#define SORT_INSTRUMENTED_SUFFIX "-instrumented" ///< suffix of the library name of instrumented builds
+#define SORT_COMPARE_COUNTER "sortCompares" ///< thread-local unsigned long long comparison counter of instrumented builds
+
+typedef void (*sortTypedFn_t)(void*, size_t); ///< Function-pointer type definition for type-specialized sort functions
+
+/**
+ * files and limits of an external-memory sort
+ */
+typedef struct
+{
+  int in; ///< file descriptor of the input, n elements starting at offset 0
+  int out; ///< file descriptor of the output, gets the sorted elements starting at offset 0
+  size_t memory; ///< bytes of memory the module may use for its buffers
+  const char *tmpDir; ///< folder for temporary files
+} SortFiles_t;
+
+#define SORT_FILE_SYMBOL "sortFile" ///< symbol name of the sortFileFn_t entry of external-memory modules
+
+typedef int (*sortFileFn_t)(SortFiles_t*, size_t, size_t, SortContext_t*); ///< Function-pointer type definition for external-memory sort functions, returns 0 on success
+
+#define SORT_SELECT_SYMBOL "sortSelect" ///< symbol name of the selection entry: moves the element a sort would put at index k there, no element before it is greater and none after it is less
+#define SORT_PARTIAL_SYMBOL "sortPartial" ///< symbol name of the partial-sort entry: moves the k smallest elements in order to the front, the others follow in any order
+
+typedef void (*sortSelectFn_t)(void*, size_t, size_t, size_t, SortContext_t*); ///< Function-pointer type definition for selection and partial-sort functions, taking elements, n, k, size and context
+
 #endif
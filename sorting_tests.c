@@ -12,231 +12,738 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
-//#include <pthread.h>
+#include <unistd.h>
+
+#include <errno.h>
+#include <signal.h>
 
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <sys/wait.h>
 #include <dirent.h>
+#include <fcntl.h>
 
 #include <dlfcn.h>
+#include <sched.h>
 
 #include "argParser.h"
+#include "timing.h"
+#include "stats.h"
+#include "generators.h"
+#include "keytypes.h"
+#include "scheduler.h"
+#include "perfcounters.h"
+#include "memprofile.h"
+#include "fileio.h"
+#include "placement.h"
+#include "sizes.h"
+#include "results.h"
 #include "sorting_lib.h"
 
 //variables we'll need in some functions
 static unsigned int averagingRuns = 3; ///< how often to run a test on one sample size to average out
+static unsigned int warmupRuns = 0; ///< runs to do before recording, to warm up caches and page in the buffers
+static double targetConfidence = 0; ///< repeat runs until the 95% confidence interval is below this percentage of the mean, 0 to disable
+static unsigned int maxAveragingRuns = 100; ///< upper limit of runs when repeating for a target confidence
+
+static unsigned sortThreads = 1; ///< threads handed to modules declaring SORT_CAP_PARALLEL
+static unsigned threadSweep = 0; ///< if set, modules declaring SORT_CAP_PARALLEL run with 1 up to this many threads
+
+#define ENTRY_TYPED 1 ///< use the type-specialized entries of modules exporting them
+#define ENTRY_GENERIC 2 ///< use the generic entries of modules only
+#define ENTRY_BOTH (ENTRY_TYPED | ENTRY_GENERIC) ///< benchmark modules exporting type-specialized entries twice, once with either entry
+static int entryMode = ENTRY_TYPED; ///< which entries of the modules get benchmarked
 
-static int profileSwaps = 0; ///< decides whether to profile swaps or not
-static unsigned long long *pTotalSwaps = 0; ///< pointer to Swap counter
+static int isolate = 0; ///< decides whether every job runs in its own process
+static double runBudget = 0; ///< time budget of a single run in ms when isolated, 0 for none
+
+static int profileSwaps = 0; ///< decides whether to profile swaps or not, only modules exporting a swap counter get profiled
+static __thread unsigned long long *pTotalSwaps = 0; ///< pointer to Swap counter of the module the calling thread is testing
+
+static int profilePerf = 0; ///< decides whether to record hardware performance counters
+static __thread PerfCounters_t perfCounters; ///< counters of the calling thread, opened per data point
 
 static int profileMemory = 0; ///< decides whether to profile memory allocations or not
-static int recordMemory = 0; ///< set to one when memory is supposed to be recorded
 
-static size_t totalAllocations = 0; ///< memory allocations counter in byte
+static char *externalFolder = 0; ///< folder of the input and output files of external-memory modules, 0 to sort in memory
+static size_t externalMemory = 64 << 20; ///< memory budget of external-memory modules in bytes
+
+static double selectFraction = -1; ///< k of the selection mode as a fraction of n, negative to sort
+
+static Placement_t placement = {PLC_PAGES_DEFAULT, PLC_NUMA_DEFAULT}; ///< page size and NUMA node of the input, sort and scratch buffers
+
+/**
+ * a loaded sort module
+ */
+typedef struct
+{
+  void *handle; ///< handle returned by dlopen()
+  void *instrumented; ///< handle of the instrumented build, 0 if there is none
+  int shared; ///< 1 if the handles belong to the previous module, which is the same library
+  char name[64]; ///< name returned by getSortName()
+  char library[256]; ///< path of the library
+  char hash[RES_HASH_SIZE]; ///< hash of the library, tells builds apart
+  int typed; ///< 1 if the type-specialized entries get used
+  unsigned abi; ///< ABI version of the module
+  const SortCapabilities_t *caps; ///< declared capabilities, 0 for v1 modules
+  sortFn_t sort; ///< qsort-like sort function, 0 if there is none
+  sortCtxFn_t sortCtx; ///< context-taking sort function, 0 if there is none
+  sortFileFn_t sortFile; ///< external-memory sort function, 0 if there is none
+  sortSelectFn_t sortSelect; ///< selection function, 0 if there is none
+  sortSelectFn_t sortPartial; ///< partial-sort function, 0 if there is none
+  int hasSwaps; ///< set to 1 if the module exports a swap counter
+} Module_t;
+
+#define RESULT_OK 0 ///< data point was recorded
+#define RESULT_CRASHED 1 ///< the module crashed, the signal is stored in the result
+#define RESULT_TIMEOUT 2 ///< a run exceeded the time budget
+#define RESULT_SKIPPED 3 ///< skipped, because a smaller size of the same series exceeded the time budget
+
+/**
+ * recorded data of a single benchmark data point
+ */
+typedef struct
+{
+  int status; ///< one of the RESULT_ constants
+  int signal; ///< signal that killed the module if it crashed
+  unsigned long long compares; ///< comparisons of the first run
+  unsigned long long swaps; ///< swaps of the first run
+  MemProfile_t memory; ///< memory usage of the first run
+  Stats_t wall; ///< wall-clock time statistics
+  Stats_t cpu; ///< thread cpu-time statistics
+  Stats_t cycles; ///< TSC cycle statistics
+  double throughput; ///< million elements per second, based on the median wall-clock time
+  double perf[PRF_COUNT]; ///< medians of the hardware performance counters, negative if not recorded
+  int valid; ///< 1 if the result was sorted
+  int stable; ///< 1 if equal keys kept their original order, 0 if not, -1 if the type can't tell
+  unsigned long long ioRead; ///< bytes read by the first run of an external-memory module
+  unsigned long long ioWritten; ///< bytes written by the first run of an external-memory module
+  unsigned long long diskRead; ///< bytes of ioRead that came from storage
+  unsigned long long diskWritten; ///< bytes of ioWritten that went to storage
+  double ioThroughput; ///< MB read and written per second, based on the median wall-clock time
+  double hugeShare; ///< share of the sorted buffer backed by huge pages, negative if not measured
+  double localShare; ///< share of the pages of the sorted buffer on the node of the worker, negative if not measured
+} Result_t;
+
+/**
+ * a benchmark data point: one module sorting one type of one distribution of one size
+ */
+typedef struct
+{
+  size_t module; ///< index of the module
+  size_t type; ///< index of the key type
+  size_t generator; ///< index of the generator
+  size_t n; ///< number of elements
+  unsigned threads; ///< threads handed to the module
+  int first; ///< 1 if this is the first data point of its series
+  int firstOfModule; ///< 1 if this is the first data point of its module
+  int last; ///< 1 if this is the last data point of its series
+  Result_t result; ///< recorded data
+} Job_t;
+
+/**
+ * everything the jobs and the output of a benchmark need
+ */
+typedef struct
+{
+  Module_t *modules; ///< loaded modules
+  size_t moduleCount; ///< number of loaded modules
+  KeyType_t *keyTypes; ///< selected key types
+  size_t keyTypeCount; ///< number of selected key types
+  Generator_t *generators; ///< selected generators
+  size_t generatorCount; ///< number of selected generators
+  Job_t *jobs; ///< all data points in output order
+  size_t jobCount; ///< number of data points
+  int64_t **keys; ///< key buffer of every worker
+  void **data; ///< element buffer of every worker
+  int *keyFiles; ///< file descriptor of the key buffer of every worker in external mode, -1 otherwise
+  int *dataFiles; ///< file descriptor of the element buffer of every worker in external mode, -1 otherwise
+  int *outFiles; ///< file descriptor of the output file of every worker in external mode, -1 otherwise
+  Result_t **shared; ///< result buffer shared with the isolated process of every worker
+  size_t seriesLength; ///< number of sizes, so jobs / seriesLength is the series of a job
+  char *seriesTimedOut; ///< per series flag, set when a job of it exceeded the time budget
+  unsigned long long seed; ///< seed of the generators
+  unsigned genThreads; ///< threads per input generation
+
+  char *plotFolder; ///< folder for the plot files, 0 if no plots are written
+  char *timeDate; ///< time stamp used in the file names
+  FILE *pPlotFile; ///< time plot script
+  FILE *pPlotFileComp; ///< comparisons plot script
+  FILE *pPlotFileMem; ///< memory plot script
+  FILE *pPlotFileSwap; ///< swaps plot script
+  FILE *pPlotFilePerf[PRF_COUNT]; ///< hardware performance counter plot scripts
+  FILE *pPlotFileSpeedup; ///< speedup plot script of the thread sweep
+  FILE *pPlotFileEfficiency; ///< parallel efficiency plot script of the thread sweep
+  FILE *plotData; ///< data file of the current series
+  char plotDataName[128]; ///< name of the data file of the current series
+  ResultsFile_t *results; ///< results database, 0 if none is written
+  Environment_t env; ///< machine and build noted in every record
+} Benchmark_t;
+
 
-static unsigned long long runCompares = 0; ///< comparisons counter
+/**
+ * @brief Simple Power-Of for sizes
+ * @param base
+ * @param exp
+ *
+ * @return base^exp, SIZE_MAX if it doesn't fit into a size_t
+ */
+size_t ipow(size_t base, unsigned exp)
+{
+  if(exp == 0) return 1;
+  unsigned i;
+  size_t tmp = base;
+  for(i = 1; i < exp; i++) tmp = siz_multiply(tmp, base);
+  return tmp;
+}
+
+/**
+ * @brief starts the time budget of a run.
+ *
+ * Only used in isolated processes: when the budget runs out SIGALRM terminates the process, which is reported as timeout.
+ */
+static void armBudget(void)
+{
+  if(runBudget <= 0) return;
+  struct itimerval it;
+  memset(&it, 0, sizeof(it));
+  it.it_value.tv_sec = runBudget / 1000;
+  it.it_value.tv_usec = ((unsigned long long)(runBudget * 1000)) % 1000000;
+  if(!it.it_value.tv_sec && !it.it_value.tv_usec) it.it_value.tv_usec = 1;
+  setitimer(ITIMER_REAL, &it, 0);
+}
 
-//We can only profile memory if we use the GNU C Standard-lib as of now
-#ifdef _GNU_SOURCE
-//store original function-pointers, to call later on
-static void* (*o_malloc)(size_t) = 0; ///< function-pointer to original malloc()
-static void* (*o_realloc)(void*, size_t) = 0; ///< function-pointer to original realloc()
-static void* (*o_calloc)(size_t, size_t) = 0; ///< function-pointer to original calloc()
-//static void  (*o_free)(void*) = 0;
+/**
+ * @brief stops the time budget of a run.
+ */
+static void disarmBudget(void)
+{
+  if(runBudget <= 0) return;
+  struct itimerval it;
+  memset(&it, 0, sizeof(it));
+  setitimer(ITIMER_REAL, &it, 0);
+}
 
 /**
- * @brief redefinition of malloc().
- * Will count allocated bytes.
- * @param size allocation size.
+ * @brief sets up the context handed to context-taking modules.
+ * @param m module.
+ * @param type type of the elements, 0 if unknown.
+ * @param n number of elements.
+ * @param size size of the elements.
+ * @param threads threads the module may use, limited to its declared maximum.
+ * @param ctx context to fill, its scratch buffer has to be freed afterwards.
  */
-void *malloc(size_t size)
+static void setupContext(Module_t *m, KeyType_t *type, size_t n, size_t size, unsigned threads, SortContext_t *ctx)
 {
-  if(!o_malloc) o_malloc = dlsym(RTLD_NEXT, "malloc");
-  if(profileMemory && recordMemory)
+  memset(ctx, 0, sizeof(SortContext_t));
+  if(type)
+  {
+    ctx->compare = type->compareCtx;
+    ctx->keyType = type->keyType;
+    ctx->keyOffset = type->keyOffset;
+  }
+  ctx->threads = threads;
+  if(m->caps && m->caps->maxThreads && ctx->threads > m->caps->maxThreads) ctx->threads = m->caps->maxThreads;
+  if(m->caps && (m->caps->flags & SORT_CAP_SCRATCH))
   {
-    totalAllocations += size;
-    //printf("Allocated %llu\n", (unsigned long long)size);
+    ctx->scratchSize = n * size;
+    ctx->scratch = plc_alloc(&placement, ctx->scratchSize?ctx->scratchSize:1, 0, sched_getcpu());
   }
-  return o_malloc(size);
 }
 
 /**
- * @brief redefinition of realloc().
- * @see malloc()
- * @param ptr pointer to memory block that should be resized.
- * @param size allocation size.
+ * @brief frees the scratch buffer of a context set up by setupContext().
+ */
+static void freeContext(SortContext_t *ctx)
+{
+  plc_free(&placement, ctx->scratch, ctx->scratchSize?ctx->scratchSize:1, 0);
+}
+
+/**
+ * @brief looks up the type-specialized entry of a library.
+ * @param handle handle of the library.
+ * @param type type of the elements.
+ * @return entry, 0 if the library doesn't export one for the type.
+ */
+static sortTypedFn_t typedEntry(void *handle, KeyType_t *type)
+{
+  char symbol[64];
+  snprintf(symbol, sizeof(symbol), SORT_TYPED_PREFIX "%s", type->name);
+  return (sortTypedFn_t)dlsym(handle, symbol);
+}
+
+/**
+ * @brief k handed to a module in the selection mode.
+ * @param m module.
+ * @param n number of elements.
+ * @return number of elements to partially sort, or index to select, which is less than n if there are elements.
+ */
+static size_t selectK(Module_t *m, size_t n)
+{
+  size_t k = selectFraction * n;
+  if(m->sortPartial) return (k > n)?n:k;
+  return (k >= n && n)?n - 1:k;
+}
+
+/**
+ * @brief calls the sort function of a module, preferring the type-specialized one, then the context-taking one.
  *
- * @todo don't recount previously allocated memory in ptr, should relatively overhead free though.
+ * In the selection mode the partial-sort or selection function gets called instead.
  */
-void *realloc(void* ptr, size_t size)
+static inline void callSort(Module_t *m, KeyType_t *type, SortContext_t *ctx, sortTypedFn_t typed, void *data, size_t n)
 {
-  if(!o_realloc) o_realloc = dlsym(RTLD_NEXT, "realloc");
-  if(profileMemory && recordMemory)
+  if(selectFraction >= 0)
   {
-    totalAllocations += size;
-    //printf("Allocated %llu\n", (unsigned long long)size);
+    if(m->sortPartial) m->sortPartial(data, n, selectK(m, n), type->size, ctx);
+    else m->sortSelect(data, n, selectK(m, n), type->size, ctx);
   }
-  return o_realloc(ptr, size);
+  else if(typed) typed(data, n);
+  else if(m->sortCtx) m->sortCtx(data, n, type->size, ctx);
+  else m->sort(data, n, type->size, type->compare);
+}
+
+static __thread Module_t *adaptedModule = 0; ///< module sortAdapter() forwards to
+
+/**
+ * @brief comparison function handing a context-taking module a plain comparison function.
+ * @param arg the plain comparison function.
+ */
+static int adaptCompare(const void *a, const void *b, void *arg)
+{
+  return ((int (*)(void*,void*))arg)((void*)a, (void*)b);
 }
 
 /**
- * @brief redefinition of calloc().
- * @see malloc()
- * @param nmemb member size.
- * @param size allocation size.
+ * @brief qsort-like sort function forwarding to adaptedModule.
+ *
+ * Lets the generators run context-taking modules, e.g. for the killer input.
  */
-void *calloc(size_t nmemb, size_t size)
+static void sortAdapter(void *data, size_t n, size_t size, int (*fcomp)(void*,void*))
 {
-  if(!o_calloc) o_calloc = dlsym(RTLD_NEXT, "calloc");
-  if(profileMemory && recordMemory)
+  Module_t *m = adaptedModule;
+  if(m->sort)
   {
-    totalAllocations += size * nmemb;
-    //printf("Allocated %llu\n", (unsigned long long)size);
+    m->sort(data, n, size, fcomp);
+    return;
   }
-  return o_calloc(nmemb, size);
+
+  SortContext_t ctx;
+  setupContext(m, 0, n, size, 1, &ctx); //the comparison functions of the generators keep their state thread-local
+  ctx.compare = adaptCompare;
+  ctx.compareArg = (void*)fcomp;
+  m->sortCtx(data, n, size, &ctx);
+  freeContext(&ctx);
 }
 
-#endif
+/**
+ * @brief runs the sorting function once on a fresh copy of the elements.
+ * @param m module to run.
+ * @param type type of the elements.
+ * @param ctx context for context-taking modules.
+ * @param typed type-specialized entry, 0 to use the generic ones.
+ * @param data pointer to original array.
+ * @param sdata pointer to the array that gets sorted.
+ * @param n size of array.
+ * @param t measured time of the run.
+ * @param pv hardware performance counters of the run, only recorded if profilePerf is set.
+ * @param mp memory usage of the run, only recorded if profileMemory is set.
+ */
+static void runSorting(Module_t *m, KeyType_t *type, SortContext_t *ctx, sortTypedFn_t typed, void *data, void *sdata, size_t n, Timing_t *t, PerfValues_t *pv, MemProfile_t *mp)
+{
+  TimeStamp_t start;
+  memcpy(sdata, data, type->size * n);
+  armBudget();
+  if(profilePerf) prf_start(&perfCounters); //outside of the timing, it is a syscall
+  tim_start(&start);
+  if(profileMemory) mem_start();
+  callSort(m, type, ctx, typed, sdata, n);
+  if(profileMemory) mem_stop(mp);
+  tim_stop(&start, t);
+  if(profilePerf) prf_stop(&perfCounters, pv);
+  disarmBudget();
+}
 
 /**
- * @brief Simple Power-Of for unsigned integers
- * @param base
- * @param exp
+ * @brief runs the external-memory sort function once, from the input file into the output file.
  *
- * @return base^exp
+ * Both files get written back and dropped from the page cache first, so every run reads its input from storage.
+ * The time includes writing the output back.
+ * @param m module to run.
+ * @param type type of the elements.
+ * @param ctx context for the comparisons.
+ * @param files input and output files.
+ * @param data mapping of the input file.
+ * @param n number of elements.
+ * @param t measured time of the run.
+ * @param pv hardware performance counters of the run, only recorded if profilePerf is set.
+ * @param mp memory usage of the run, only recorded if profileMemory is set.
+ * @param io gets the I/O of the run.
+ * @return 0 on success, -1 if the module or the I/O failed.
  */
-unsigned ipow(unsigned base, unsigned exp)
+static int runFileSorting(Module_t *m, KeyType_t *type, SortContext_t *ctx, SortFiles_t *files, void *data, size_t n, Timing_t *t, PerfValues_t *pv, MemProfile_t *mp, IoCounters_t *io)
 {
-  if(exp == 0) return 1;
-  unsigned i;
-  unsigned tmp = base;
-  for(i = 1; i < exp; i++) tmp = tmp * base;
-  return tmp;
+  TimeStamp_t start;
+  IoCounters_t before;
+  if(ftruncate(files->out, 0)) return -1;
+  io_dropCache(files->in, data, type->size * n);
+  io_dropCache(files->out, 0, 0);
+  io_counters(&before);
+  armBudget();
+  if(profilePerf) prf_start(&perfCounters);
+  tim_start(&start);
+  if(profileMemory) mem_start();
+  int ret = m->sortFile(files, n, type->size, ctx);
+  if(!ret) ret = fdatasync(files->out);
+  if(profileMemory) mem_stop(mp);
+  tim_stop(&start, t);
+  if(profilePerf) prf_stop(&perfCounters, pv);
+  disarmBudget();
+  io_counters(io);
+  io->read -= before.read;
+  io->written -= before.written;
+  io->diskRead -= before.diskRead;
+  io->diskWritten -= before.diskWritten;
+  return ret;
 }
 
 /**
- * @brief Comparison function for two integers
- * @param a generic pointer to left-hand integer.
- * @param b generic pointer to right-hand integer.
- * @return
- * - -1 when a < b
- * - 0 if a == b
- * - 1 if a > b
+ * @brief checks the output file of an external-memory module.
+ * @param type type of the elements.
+ * @param out file descriptor of the output.
+ * @param n number of elements.
+ * @param result gets validity and stability.
  */
-int intCompare(void* a, void* b)
+static void validateFile(KeyType_t *type, int out, size_t n, Result_t *result)
 {
-  runCompares++;
-  int x = *((int*)a), y = *((int*)b);
-  return (x < y)?-1:((x > y)?1:0);
+  struct stat st;
+  size_t bytes = type->size * n;
+  result->valid = 0;
+  result->stable = -1;
+  if(fstat(out, &st) || (size_t)st.st_size != bytes) return;
+  if(!n)
+  {
+    result->valid = 1;
+    return;
+  }
+  void *sorted = mmap(0, bytes, PROT_READ, MAP_SHARED, out, 0);
+  if(sorted == MAP_FAILED) return;
+  result->valid = type->isSorted(sorted, n);
+  result->stable = (result->valid && type->isStable)?type->isStable(sorted, n):-1;
+  munmap(sorted, bytes);
 }
 
 /**
- * @brief Quick check if list is sorted.
- * Quickly checks if list is sorted decendingly.
+ * @brief checks the result of a selection or partial sort.
  *
- * @param numbers pointer to array.
- * @param n array size.
- * @return
- * - 1 if it's sorted
- * - 0 otherwise
+ * A selection has to partition the elements around index k, a partial sort has to order the first k elements
+ * and partition the elements around the last of them.
+ * @param m module.
+ * @param type type of the elements.
+ * @param data the elements.
+ * @param n number of elements.
+ * @param result gets the validity.
+ */
+static void validateSelection(Module_t *m, KeyType_t *type, void *data, size_t n, Result_t *result)
+{
+  size_t k = selectK(m, n);
+  result->stable = -1;
+  if(m->sortPartial) result->valid = type->isSorted(data, k) && (!k || k == n || type->isPartitioned(data, n, k - 1));
+  else result->valid = (k >= n) || type->isPartitioned(data, n, k);
+}
+
+/**
+ * @brief counts the comparisons and swaps of a type-specialized entry.
  *
- * @todo check if all numbers from the original list are still there.
+ * The entry of the instrumented build gets run once more outside of the measurements.
+ * @param m module.
+ * @param type type of the elements.
+ * @param data pointer to original array.
+ * @param sdata pointer to the array that gets sorted.
+ * @param n size of array.
+ * @param result gets the counts.
+ * @return 1 if counted, 0 if there is no instrumented build with that entry.
  */
-int isSortedIntegers(int *numbers, size_t n)
+static int countTyped(Module_t *m, KeyType_t *type, void *data, void *sdata, size_t n, Result_t *result)
 {
-  int i;
-  int last = numbers[0];
-  for(i = 1; i < n; i++)
-  {
-    if(last > numbers[i]) return 0;
-    last = numbers[i];
-  }
+  if(!m->instrumented) return 0;
+  sortTypedFn_t typed = typedEntry(m->instrumented, type);
+  unsigned long long *compares = dlsym(m->instrumented, SORT_COMPARE_COUNTER);
+  if(!typed || !compares) return 0;
+  unsigned long long *swaps = profileSwaps?dlsym(m->instrumented, "totalSwaps"):0;
+
+  if(sdata != data) memcpy(sdata, data, type->size * n);
+  *compares = 0;
+  if(swaps) *swaps = 0;
+  armBudget();
+  typed(sdata, n);
+  disarmBudget();
+  result->compares = *compares;
+  if(swaps) result->swaps = *swaps;
   return 1;
 }
 
 /**
  * @brief commences sorting tests.
  *
- * Takes the inputed array and sorts it with the given sorting function.
+ * Takes the inputed array of elements of the given type and sorts it with the given module.
  * If there are more than one runs to do, there will be copies made of the original list, so each run gets exactly the same unsorted list.
  * If there is a pointer to a swap-counter, the swap-count will be reset to zero, all other counters are reset as well.
- * @param f function-pointer of sorting function.
- * @param numbers pointer to original array.
+ * Warm-up runs are done first and not recorded. Afterwards the time of every run is kept, so min, median, p95, mean and standard deviation can be reported.
+ * If a target confidence is set, runs are repeated until the 95% confidence interval of the mean is narrower than that or maxAveragingRuns is reached.
+ * With files the external-memory entry sorts the input file into the output file instead, its I/O gets recorded as well.
+ * @param m module to test.
+ * @param type type of the elements.
+ * @param data pointer to original array, the mapping of the input file with files.
  * @param n size of array.
- * @param output file to write the recorded data to.
+ * @param threads threads handed to parallel modules.
+ * @param files input and output files for external-memory modules, 0 to sort in memory.
+ * @param result recorded data.
  */
-void testIntegerSorting(sortFn_t f, int *numbers, size_t n, FILE* output)
+void testSorting(Module_t *m, KeyType_t *type, void *data, size_t n, unsigned threads, SortFiles_t *files, Result_t *result)
 {
-  unsigned int i;
+  unsigned int i, k;
+
+  void *sdata = data;
 
-  int *snumbers = numbers;
+  if(averagingRuns > 0 && !files)
+  {
+    sdata = plc_alloc(&placement, type->size * n, 0, sched_getcpu());
+    if(!sdata)
+    {
+      perror("Couldn't allocate the array to sort");
+      result->status = RESULT_SKIPPED;
+      return;
+    }
+    memcpy(sdata, data, type->size * n);
+  }
 
-  if(averagingRuns > 0)
+  //external-memory modules get their memory budget instead of a scratch buffer
+  SortContext_t ctx;
+  setupContext(m, type, files?0:n, type->size, threads, &ctx);
+  sortTypedFn_t typed = (m->typed && !files && selectFraction < 0)?typedEntry(m->handle, type):0;
+  int failed = 0;
+  IoCounters_t io;
+
+  unsigned int maxRuns = (targetConfidence > 0 && maxAveragingRuns > averagingRuns)?maxAveragingRuns:averagingRuns;
+  Samples_t *wallSamples = sta_createSamples(maxRuns);
+  Samples_t *cpuSamples = sta_createSamples(maxRuns);
+  Samples_t *cycleSamples = sta_createSamples(maxRuns);
+  Samples_t *perfSamples[PRF_COUNT];
+  int perfMissing[PRF_COUNT];
+  for(i = 0; i < PRF_COUNT; i++)
   {
-    snumbers = malloc(sizeof(int) * n);
-    memcpy(snumbers, numbers, sizeof(int) * n);
+    perfSamples[i] = profilePerf?sta_createSamples(maxRuns):0;
+    perfMissing[i] = !profilePerf;
+  }
+  if(profilePerf) prf_open(&perfCounters);
+
+  Timing_t t;
+  PerfValues_t pv;
+  MemProfile_t mp;
+  memset(&mp, 0, sizeof(mp));
+  for(i = 0; i < warmupRuns && averagingRuns; i++)
+  {
+    if(files) failed |= runFileSorting(m, type, &ctx, files, data, n, &t, &pv, &mp, &io);
+    else runSorting(m, type, &ctx, typed, data, sdata, n, &t, &pv, &mp);
   }
 
   runCompares = 0;
-  totalAllocations = 0;
   if(pTotalSwaps) *pTotalSwaps = 0;
 
   unsigned long long o_runCompares = 0;
-  size_t o_totalAllocations = 0;
+  MemProfile_t o_memory;
+  memset(&o_memory, 0, sizeof(o_memory));
   unsigned long long o_totalSwaps = 0;
 
   //for(i = 0; i < n; i++) printf("%d\n", numbers[i]);
-  double time = 0.f;
-  for(i = 0; i < averagingRuns; i++)
+  for(i = 0; i < maxRuns; i++)
   {
-    memcpy(snumbers, numbers, sizeof(int) * n);
-    clock_t t = clock();
-    recordMemory = 1;
-    f((void*)snumbers, n, sizeof(int), intCompare);
-    recordMemory = 0;
-    t = clock() - t;
-    time += ((double)t * 1000)/CLOCKS_PER_SEC;
+    //in adaptive mode stop as soon as the mean is known precisely enough
+    if(i >= averagingRuns && sta_confidence(wallSamples) <= targetConfidence) break;
+
+    if(files) failed |= runFileSorting(m, type, &ctx, files, data, n, &t, &pv, &mp, &io);
+    else runSorting(m, type, &ctx, typed, data, sdata, n, &t, &pv, &mp);
+    sta_addSample(wallSamples, t.wall);
+    sta_addSample(cpuSamples, t.cpu);
+    sta_addSample(cycleSamples, t.cycles);
+    for(k = 0; k < PRF_COUNT && profilePerf; k++)
+    {
+      if(pv.values[k] < 0) perfMissing[k] = 1;
+      else sta_addSample(perfSamples[k], pv.values[k]);
+    }
 
     //record these things only once, as they will be constant anyways
     if(i == 0)
     {
       o_runCompares = runCompares;
-      o_totalAllocations = totalAllocations;
+      o_memory = mp;
       if(pTotalSwaps) o_totalSwaps = *pTotalSwaps;
+      if(files)
+      {
+        result->ioRead = io.read;
+        result->ioWritten = io.written;
+        result->diskRead = io.diskRead;
+        result->diskWritten = io.diskWritten;
+      }
     }
 
     //reset for next run
     runCompares = 0;
-    totalAllocations = 0;
     if(pTotalSwaps) *pTotalSwaps = 0;
   }
 
-  if(averagingRuns)
+  sta_calculate(wallSamples, &result->wall);
+  sta_calculate(cpuSamples, &result->cpu);
+  sta_calculate(cycleSamples, &result->cycles);
+  for(i = 0; i < PRF_COUNT; i++)
   {
-    time = time / averagingRuns;  
+    Stats_t perfStats;
+    result->perf[i] = -1;
+    if(perfMissing[i] || !perfSamples[i]->count) continue;
+    sta_calculate(perfSamples[i], &perfStats);
+    result->perf[i] = perfStats.median;
   }
 
-  int valid = isSortedIntegers(snumbers, n);
-  printf("%10llu %10llu %10llu %10llu %10.04lfms \e[38;5;%um%10s\e[0m\n",
-         (unsigned long long)n,
-         o_runCompares,
-         o_totalSwaps,
-         (profileMemory)?(unsigned long long)o_totalAllocations:0,
-         time,
-         valid?82:160,
-         valid?"valid":"invalid");
-  if(output) fprintf(output, "%llu %lf %llu %llu %llu\n",
-                             (unsigned long long)n, 
-                             time,
-                             runCompares,
-                             (pTotalSwaps)?*pTotalSwaps:0,
-                             (profileMemory)?(unsigned long long)totalAllocations:0);
-  free(snumbers);
-  //printf("%llu\n", (unsigned long long)totalAllocations);
+  result->compares = o_runCompares;
+  result->swaps = o_totalSwaps;
+  result->memory = o_memory;
+  if(typed)
+  {
+    result->compares = 0;
+    result->swaps = 0;
+    countTyped(m, type, data, sdata, n, result);
+  }
+  if(files)
+  {
+    validateFile(type, files->out, n, result);
+    if(failed) result->valid = 0;
+  }
+  else if(selectFraction >= 0) validateSelection(m, type, sdata, n, result);
+  else
+  {
+    result->valid = type->isSorted(sdata, n);
+    result->stable = (result->valid && type->isStable)?type->isStable(sdata, n):-1;
+  }
+  //a module declaring stability has to keep it
+  if(!result->stable && m->caps && (m->caps->flags & SORT_CAP_STABLE)) result->valid = 0;
+  result->throughput = (result->wall.median > 0)?n / result->wall.median / 1000:0; //million elements per second
+  if(result->wall.median > 0) result->ioThroughput = (result->ioRead + result->ioWritten) / result->wall.median / 1000; //MB per second
+  //where the kernel actually put the sorted elements
+  result->hugeShare = result->localShare = -1;
+  if(plc_active(&placement) && !files)
+  {
+    result->hugeShare = plc_hugeShare(sdata, type->size * n);
+    result->localShare = plc_nodeShare(sdata, type->size * n, plc_nodeOfCpu(sched_getcpu()));
+  }
+
+  freeContext(&ctx);
+  sta_destroySamples(wallSamples);
+  sta_destroySamples(cpuSamples);
+  sta_destroySamples(cycleSamples);
+  for(i = 0; i < PRF_COUNT; i++) sta_destroySamples(perfSamples[i]);
+  if(profilePerf) prf_close(&perfCounters);
+  if(sdata != data) plc_free(&placement, sdata, type->size * n, 0);
   //for(i = 0; i < n; i++) printf("%d\n", numbers[i]);
   //free(numberList);  
 }
 
+/**
+ * @brief prints the recorded data of a data point.
+ * @param r recorded data.
+ * @param n size of array.
+ * @param output file to write the recorded data to.
+ */
+void printResult(Result_t *r, size_t n, FILE *output)
+{
+  if(r->status != RESULT_OK)
+  {
+    char status[64];
+    if(r->status == RESULT_CRASHED) snprintf(status, 63, "crashed(%s)", strsignal(r->signal));
+    else if(r->status == RESULT_TIMEOUT) snprintf(status, 63, "timeout(>%.0lfms)", runBudget);
+    else snprintf(status, 63, "skipped");
+    printf("%10llu \e[38;5;160m%s\e[0m\n", (unsigned long long)n, status);
+    if(output) fprintf(output, "# %llu %s\n", (unsigned long long)n, status);
+    return;
+  }
+
+  //unstable results are only an error for modules declaring stability
+  const char *validity = r->valid?"valid":"invalid";
+  unsigned color = r->valid?82:160;
+  if(r->stable == 1) validity = "stable";
+  else if(!r->stable)
+  {
+    validity = "unstable";
+    if(r->valid) color = 214;
+  }
+
+  printf("%10llu %10llu %10llu %10llu %10.04lfms %10.04lfms %10.04lfms %10.04lfms %10.04lfms %10.04lfms %14.0lf %10.03lf %6llu \e[38;5;%um%10s\e[0m%s",
+         (unsigned long long)n,
+         r->compares,
+         r->swaps,
+         r->memory.allocated,
+         r->wall.mean,
+         r->wall.stddev,
+         r->wall.min,
+         r->wall.median,
+         r->wall.p95,
+         r->cpu.median,
+         r->cycles.median,
+         r->throughput,
+         (unsigned long long)r->wall.count,
+         color,
+         validity,
+         (profilePerf || profileMemory || externalFolder || plc_active(&placement))?"":"\n");
+  int i;
+  for(i = 0; i < PRF_COUNT && profilePerf; i++)
+  {
+    if(r->perf[i] < 0) printf(" %14s", "n/a");
+    else printf(" %14.0lf", r->perf[i]);
+  }
+  if(externalFolder) printf(" %12llu %12llu %12llu %10.01lf%s", r->ioRead, r->ioWritten, r->diskRead + r->diskWritten, r->ioThroughput, (profileMemory || plc_active(&placement))?"":"\n");
+  if(plc_active(&placement))
+  {
+    if(r->hugeShare < 0) printf(" %7s", "n/a");
+    else printf(" %6.01lf%%", 100 * r->hugeShare);
+    if(r->localShare < 0) printf(" %7s%s", "n/a", profileMemory?"":"\n");
+    else printf(" %6.01lf%%%s", 100 * r->localShare, profileMemory?"":"\n");
+  }
+  if(profileMemory)
+  {
+    printf(" %12llu %10llu %10llu %10llu %12llu\n%10s sizes:", r->memory.peak, r->memory.allocations, r->memory.reallocations, r->memory.frees, r->memory.leaked, "");
+    mem_printHistogram(&r->memory, stdout);
+  }
+  else if(profilePerf) printf("\n");
+  if(output) fprintf(output, "%llu %lf %llu %llu %llu %lf %.0lf %lf %lf %lf %lf %llu %lf",
+                             (unsigned long long)n,
+                             r->wall.mean,
+                             r->compares,
+                             r->swaps,
+                             r->memory.allocated,
+                             r->cpu.median,
+                             r->cycles.median,
+                             r->wall.min,
+                             r->wall.median,
+                             r->wall.p95,
+                             r->wall.stddev,
+                             (unsigned long long)r->wall.count,
+                             r->throughput);
+  for(i = 0; i < PRF_COUNT && profilePerf && output; i++)
+  {
+    if(r->perf[i] < 0) fprintf(output, " NaN");
+    else fprintf(output, " %.0lf", r->perf[i]);
+  }
+  if(output && externalFolder) fprintf(output, " %llu %llu %llu %llu %lf", r->ioRead, r->ioWritten, r->diskRead, r->diskWritten, r->ioThroughput);
+  if(output && plc_active(&placement)) fprintf(output, " %lf %lf", r->hugeShare, r->localShare);
+  if(output && profileMemory)
+  {
+    fprintf(output, " %llu %llu %llu %llu %llu %llu\n# sizes:", r->memory.peak, r->memory.allocations, r->memory.reallocations, r->memory.frees, r->memory.leaked, r->memory.leakedBlocks);
+    mem_printHistogram(&r->memory, output);
+  }
+  else if(output) fprintf(output, "\n");
+}
+
 /**
  * @brief Helper Function to calculate the work-sizes.
  *
@@ -245,25 +752,715 @@ void testIntegerSorting(sortFn_t f, int *numbers, size_t n, FILE* output)
  * - 2: (sortSize0 * ipow(growth, sample))
  * - 3: sortSize0 + (sortSize0 * log10(growth*sample))
  *
+ * The cache-aware sweep(growth type 4) is calculated by siz_sweep() instead.
+ *
  * @param sortSize0 initial work-size.
  * @param sample the sample/run number.
  * @param growth growth from sample to sample.
  * @param growthType type of growth.
+ * @return the work-size, SIZE_MAX if it doesn't fit into a size_t.
+ */
+size_t calculateSortSize(size_t sortSize0, unsigned sample, unsigned growth, char growthType)
+{
+  size_t tmp = 0;
+  double grown;
+  switch(growthType)
+  {
+    case 1:
+      tmp = siz_multiply(sortSize0, siz_multiply(sample, growth)); break;
+    case 2: 
+      tmp = siz_multiply(sortSize0, ipow(growth, sample)); break;
+    case 3:
+      grown = sortSize0 + (sortSize0 * log10((double)growth*sample));
+      tmp = (grown < 0x1p64 && grown < SIZE_MAX)?(size_t)grown:SIZE_MAX; break;
+  }
+
+  return tmp;
+}
+
+/**
+ * @brief estimates the memory a benchmark needs at most.
+ *
+ * Every worker holds the keys and elements of the largest size, and while sorting a copy of the elements,
+ * a scratch buffer of their size and the extra memory of their type.
+ * @param keyTypes types to benchmark.
+ * @param keyTypeCount number of types.
+ * @param sizes sample sizes of every type, stride apart.
+ * @param stride distance of the sizes of two types.
+ * @param runs number of sizes of every type to take into account.
+ * @param workers number of workers.
+ * @return bytes, SIZE_MAX if they don't fit into a size_t.
+ */
+static size_t footprint(KeyType_t *keyTypes, size_t keyTypeCount, const size_t *sizes, size_t stride, size_t runs, unsigned workers)
+{
+  size_t k, i, maxN = 0, maxTypeSize = 0, sorting = 0;
+  for(k = 0; k < keyTypeCount; k++)
+  {
+    size_t perElement = siz_add(2 * keyTypes[k].size, keyTypes[k].extraSize);
+    if(keyTypes[k].size > maxTypeSize) maxTypeSize = keyTypes[k].size;
+    for(i = 0; i < runs; i++)
+    {
+      size_t n = sizes[k * stride + i];
+      if(n > maxN) maxN = n;
+      if(siz_multiply(n, perElement) > sorting) sorting = siz_multiply(n, perElement);
+    }
+  }
+  size_t buffers = siz_multiply(maxN, sizeof(int64_t) + maxTypeSize);
+  return siz_multiply(siz_add(buffers, sorting), workers);
+}
+
+/**
+ * @brief checks if a module can sort elements of a type.
+ * @return 1 if it can, 0 otherwise.
+ */
+int moduleSupports(Module_t *m, KeyType_t *type)
+{
+  //the typed series of ENTRY_BOTH only runs what the generic one can't show
+  if(m->typed && entryMode == ENTRY_BOTH && !typedEntry(m->handle, type)) return 0;
+  //files are sorted by the external-memory entry only, so a module is benchmarked once
+  if(externalFolder && (!m->sortFile || m->shared)) return 0;
+  //as is the selection mode by the selection entries
+  if(selectFraction >= 0 && ((!m->sortSelect && !m->sortPartial) || m->shared)) return 0;
+  if(!m->caps || !m->caps->keyTypes) return 1;
+  return (m->caps->keyTypes & type->keyType) != 0;
+}
+
+/**
+ * @brief number of thread counts a module gets benchmarked with during a thread sweep.
+ * @param m module.
+ * @return 0 if the module doesn't take part in the sweep, the largest thread count otherwise.
+ */
+unsigned sweptThreads(Module_t *m)
+{
+  if(!threadSweep || !m->caps || !(m->caps->flags & SORT_CAP_PARALLEL)) return 0;
+  if(m->caps->maxThreads && m->caps->maxThreads < threadSweep) return m->caps->maxThreads;
+  return threadSweep;
+}
+
+/**
+ * @brief prints name and declared capabilities of a module.
+ * @param m module.
+ */
+void printModule(Module_t *m)
+{
+  printf("Testing %s", m->name);
+  if(m->caps)
+  {
+    printf(" (ABI v%u%s%s%s%s%s%s)", m->abi,
+           (m->caps->flags & SORT_CAP_STABLE)?", stable":"",
+           (m->caps->flags & SORT_CAP_INPLACE)?", in-place":"",
+           (m->caps->flags & SORT_CAP_PARALLEL)?", parallel":"",
+           m->sortCtx?", context entry":"",
+           m->sortFile?", external-memory entry":"",
+           m->sortPartial?", partial-sort entry":(m->sortSelect?", selection entry":""));
+  }
+  if(externalFolder) printf(" sorting files with %lluMB of memory", (unsigned long long)(externalMemory >> 20));
+  else if(selectFraction >= 0) printf(" %s k = %g n", m->sortPartial?"partially sorting":"selecting", selectFraction);
+  else if(m->typed) printf(" using the type-specialized entries%s", m->instrumented?", instrumented build found":"");
+  printf("\n");
+}
+
+/**
+ * @brief allocates a benchmark buffer.
+ *
+ * When jobs are isolated the buffer is a shared mapping, so the child processes work on the same memory as the parent.
+ * With a path it is a shared mapping of that file, so it may be larger than the memory.
+ * Otherwise it gets the page size and NUMA node of the placement, relative to the worker's cpu.
+ * @param size size in bytes.
+ * @param path file backing the buffer, 0 for memory.
+ * @param fd gets the file descriptor of the file, -1 without one.
+ * @param cpu cpu of the worker using the buffer, negative for small buffers that don't get placed.
+ * @return pointer to the buffer or 0 if the allocation failed.
+ */
+void *allocBuffer(size_t size, const char *path, int *fd, int cpu)
+{
+  static const Placement_t unplaced = {PLC_PAGES_DEFAULT, PLC_NUMA_DEFAULT};
+  *fd = -1;
+  if(path) return io_mapFile(path, size, fd);
+  return plc_alloc((cpu < 0)?&unplaced:&placement, size, isolate, cpu);
+}
+
+/**
+ * @brief frees a buffer allocated by allocBuffer().
+ * @param buffer pointer to the buffer, may be 0.
+ * @param size size in bytes as given to allocBuffer().
+ * @param path file backing the buffer as given to allocBuffer(), it gets removed.
+ * @param fd file descriptor of the file.
+ * @param cpu as given to allocBuffer().
+ */
+void freeBuffer(void *buffer, size_t size, const char *path, int fd, int cpu)
+{
+  static const Placement_t unplaced = {PLC_PAGES_DEFAULT, PLC_NUMA_DEFAULT};
+  if(path) io_unmapFile(buffer, size, fd, path);
+  else plc_free((cpu < 0)?&unplaced:&placement, buffer, size, isolate);
+}
+
+/**
+ * @brief cpu a worker runs on.
+ * @param cpus cpus the workers get pinned to.
+ * @param cpuCount number of cpus, 0 if the workers aren't pinned.
+ * @param worker index of the worker.
+ * @return cpu, the current one of the calling thread if the workers aren't pinned.
+ */
+static int workerCpu(int *cpus, unsigned cpuCount, unsigned worker)
+{
+  return cpuCount?cpus[worker]:sched_getcpu();
+}
+
+/**
+ * @brief path of a file of a worker in external mode.
+ * @param path buffer for the path.
+ * @param size size of the buffer.
+ * @param what what the file holds, part of its name.
+ * @param worker index of the worker.
+ * @param timeDate time stamp of the benchmark, part of the name.
+ * @return path, 0 if not in external mode.
+ */
+static const char *externalPath(char *path, size_t size, const char *what, unsigned worker, const char *timeDate)
+{
+  if(!externalFolder) return 0;
+  snprintf(path, size, "%s/%s_%u_%s.dat", externalFolder, what, worker, timeDate);
+  return path;
+}
+
+/**
+ * @brief checks if a library exports any type-specialized entries.
+ * @param handle handle of the library.
+ * @return 1 if it does, 0 otherwise.
+ */
+static int hasTypedEntries(void *handle)
+{
+  KeyType_t *type;
+  for(type = key_getTypes(); type->name; type++)
+  {
+    if(typedEntry(handle, type)) return 1;
+  }
+  return 0;
+}
+
+/**
+ * @brief opens the instrumented build next to a module.
+ * @param moduleFolder folder of the module.
+ * @param fileName file name of the module, e.g. libquicksort.so.1.0.
+ * @return handle of lib<name>-instrumented.so.1.0, 0 if there is none.
+ */
+static void *openInstrumented(const char *moduleFolder, const char *fileName)
+{
+  const char *ext = strstr(fileName, ".so");
+  char *path = malloc(strlen(moduleFolder) + strlen(fileName) + strlen(SORT_INSTRUMENTED_SUFFIX) + 1);
+  if(!path) return 0;
+  sprintf(path, "%s%.*s%s%s", moduleFolder, (int)(ext - fileName), fileName, SORT_INSTRUMENTED_SUFFIX, ext);
+  void *handle = dlopen(path, RTLD_LAZY);
+  free(path);
+  return handle;
+}
+
+/**
+ * @brief loads all sort modules of a folder.
+ *
+ * A module needs to export getSortName() and getSortSymbol() with the sort function named by the latter(ABI v1),
+ * or getSortAbiVersion() and getSortCapabilities() with the context-taking sort function named by the capabilities(ABI v2).
+ * Libraries missing them are skipped, as are instrumented builds, which get opened along with their module.
+ * With ENTRY_BOTH modules exporting type-specialized entries get added a second time, once per entry.
+ * @param moduleFolder folder to search for .so files.
+ * @param count set to the number of loaded modules.
+ * @return array of the loaded modules, 0 if the folder couldn't be opened.
+ */
+Module_t *loadModules(char *moduleFolder, size_t *count)
+{
+  DIR *modDir = opendir(moduleFolder);
+  *count = 0;
+  if(!modDir)
+  {
+    perror("Opening module directory failed!");
+    return 0;
+  }
+
+  Module_t *modules = 0;
+  struct dirent *file;
+  void *libHandle = 0;
+  getSortNameFn_t sortNameFn = 0;
+  getSortSymbolFn_t sortSymbolFn = 0;
+  sortFn_t sortFn = 0;
+  //open the folder and search for .so modules
+  while((file = readdir(modDir)))
+  {
+    if(file->d_type & DT_REG && strstr(file->d_name, ".so") && !strstr(file->d_name, SORT_INSTRUMENTED_SUFFIX ".so"))
+    {
+      //found a module, so lets try opening it
+      char *fullPath = malloc(strlen(file->d_name) + strlen(moduleFolder) + 1);
+      fullPath[0] = 0;
+      strcpy(fullPath, moduleFolder);
+      strcat(fullPath, file->d_name);
+      libHandle = dlopen(fullPath, RTLD_LAZY);
+      if(!libHandle)
+      {
+        fprintf(stderr, "Loading \"%s\" failed!(%s)\n", fullPath, dlerror());
+        free(fullPath);
+        continue;
+      }
+      free(fullPath);
+
+      sortNameFn = (getSortNameFn_t)dlsym(libHandle, "getSortName");
+      if(!sortNameFn)
+      {
+        dlclose(libHandle);
+        continue;
+      }
+
+      getSortAbiVersionFn_t abiFn = (getSortAbiVersionFn_t)dlsym(libHandle, "getSortAbiVersion");
+      getSortCapabilitiesFn_t capsFn = (getSortCapabilitiesFn_t)dlsym(libHandle, "getSortCapabilities");
+      unsigned abi = abiFn?abiFn():1;
+      const SortCapabilities_t *caps = (abi >= 2 && capsFn)?capsFn():0;
+      sortCtxFn_t sortCtxFn = 0;
+      if(abi > SORT_ABI_VERSION)
+      {
+        fprintf(stderr, "\"%s\" needs module ABI v%u, only v%u is supported!\n", sortNameFn(), abi, SORT_ABI_VERSION);
+        dlclose(libHandle);
+        continue;
+      }
+      if(caps && caps->contextSymbol)
+      {
+        sortCtxFn = (sortCtxFn_t)dlsym(libHandle, caps->contextSymbol);
+        if(!sortCtxFn) fprintf(stderr, "Can't find context sort procedure!(%s)\n", dlerror());
+      }
+
+      sortFn = 0;
+      sortSymbolFn = (getSortSymbolFn_t)dlsym(libHandle, "getSortSymbol");
+      if(sortSymbolFn) sortFn = (sortFn_t)dlsym(libHandle, sortSymbolFn());
+      int typed = hasTypedEntries(libHandle);
+      if(!sortFn && !sortCtxFn)
+      {
+        if(!sortSymbolFn) fprintf(stderr, "Can't find procedure!(%s)\n", dlerror());
+        else fprintf(stderr, "Can't find sort procedure!(%s)\n", dlerror());
+        dlclose(libHandle);
+        continue;
+      }
+
+      Module_t *tmp = realloc(modules, sizeof(Module_t) * (*count + 2));
+      if(!tmp)
+      {
+        dlclose(libHandle);
+        continue;
+      }
+      modules = tmp;
+      modules[*count].handle = libHandle;
+      modules[*count].instrumented = typed?openInstrumented(moduleFolder, file->d_name):0;
+      modules[*count].shared = 0;
+      snprintf(modules[*count].name, sizeof(modules[*count].name), "%s", sortNameFn());
+      snprintf(modules[*count].library, sizeof(modules[*count].library), "%s%s", moduleFolder, file->d_name);
+      res_hashFile(modules[*count].library, modules[*count].hash);
+      modules[*count].typed = typed && (entryMode & ENTRY_TYPED);
+      modules[*count].abi = caps?abi:1;
+      modules[*count].caps = caps;
+      modules[*count].sort = sortFn;
+      modules[*count].sortCtx = sortCtxFn;
+      modules[*count].sortFile = (sortFileFn_t)dlsym(libHandle, SORT_FILE_SYMBOL);
+      modules[*count].sortSelect = (sortSelectFn_t)dlsym(libHandle, SORT_SELECT_SYMBOL);
+      modules[*count].sortPartial = (sortSelectFn_t)dlsym(libHandle, SORT_PARTIAL_SYMBOL);
+      modules[*count].hasSwaps = dlsym(libHandle, "totalSwaps") != 0;
+      (*count)++;
+
+      if(typed && entryMode == ENTRY_BOTH)
+      {
+        //the first one keeps the generic entry, the copy gets the typed one
+        modules[*count] = modules[*count - 1];
+        modules[*count - 1].typed = 0;
+        modules[*count].shared = 1;
+        snprintf(modules[*count].name, sizeof(modules[*count].name), "%s typed", sortNameFn());
+        (*count)++;
+      }
+    }
+  }
+  closedir(modDir);
+
+  if(!modules) modules = malloc(sizeof(Module_t)); //nothing found is not an error
+  return modules;
+}
+
+/**
+ * @brief unloads all modules loaded by loadModules().
+ * @param modules loaded modules.
+ * @param count number of modules.
+ */
+void unloadModules(Module_t *modules, size_t count)
+{
+  size_t i;
+  for(i = 0; i < count; i++)
+  {
+    if(modules[i].shared) continue;
+    if(modules[i].instrumented) dlclose(modules[i].instrumented);
+    dlclose(modules[i].handle);
+  }
+  free(modules);
+}
+
+/**
+ * @brief generates the input of a data point and benchmarks it.
+ * @param b benchmark.
+ * @param j data point.
+ * @param worker index of the worker running it, selects the input buffers.
+ * @param result recorded data.
+ */
+void executeJob(Benchmark_t *b, Job_t *j, unsigned worker, Result_t *result)
+{
+  Module_t *m = &b->modules[j->module];
+  KeyType_t *type = &b->keyTypes[j->type];
+  Generator_t *gen = &b->generators[j->generator];
+
+  //the swap counter is thread-local in current modules, so it has to be looked up by the thread using it
+  pTotalSwaps = (profileSwaps && m->hasSwaps)?dlsym(m->handle, "totalSwaps"):0;
+
+  GenContext_t genCtx;
+  genCtx.seed = b->seed;
+  genCtx.threads = b->genThreads;
+  genCtx.param = gen->param;
+  genCtx.sort = sortAdapter;
+  adaptedModule = m;
+
+  armBudget(); //the killer input runs the module as well
+  gen->generate(b->keys[worker], j->n, &genCtx);
+  disarmBudget();
+  void *extra = type->convert(b->data[worker], b->keys[worker], j->n);
+  if(externalFolder)
+  {
+    SortFiles_t files;
+    files.in = b->dataFiles[worker];
+    files.out = b->outFiles[worker];
+    files.memory = externalMemory;
+    files.tmpDir = externalFolder;
+    testSorting(m, type, b->data[worker], j->n, j->threads, &files, result);
+  }
+  else testSorting(m, type, b->data[worker], j->n, j->threads, 0, result);
+  result->status = RESULT_OK;
+  free(extra);
+
+  pTotalSwaps = 0;
+}
+
+/**
+ * @brief benchmarks a data point in a child process.
+ *
+ * The input buffers and the result buffer of the worker are shared mappings, so the child neither copies them nor touches
+ * copy-on-write pages while sorting. A crash or an exceeded time budget only terminates the child and is stored as status of the result.
+ * @param b benchmark.
+ * @param j data point.
+ * @param worker index of the worker running it.
+ */
+void executeIsolatedJob(Benchmark_t *b, Job_t *j, unsigned worker)
+{
+  int status;
+  Result_t *shared = b->shared[worker];
+
+  memset(shared, 0, sizeof(Result_t));
+  shared->status = RESULT_CRASHED;
+
+  fflush(stdout);
+  pid_t pid = fork();
+  if(pid == 0)
+  {
+    executeJob(b, j, worker, shared);
+    _exit(0);
+  }
+
+  memset(&j->result, 0, sizeof(Result_t));
+  if(pid < 0)
+  {
+    perror("Forking isolated job failed");
+    j->result.status = RESULT_CRASHED;
+    return;
+  }
+
+  while(waitpid(pid, &status, 0) < 0)
+  {
+    if(errno != EINTR)
+    {
+      j->result.status = RESULT_CRASHED;
+      return;
+    }
+  }
+
+  if(WIFEXITED(status) && WEXITSTATUS(status) == 0 && shared->status == RESULT_OK)
+  {
+    j->result = *shared;
+  }
+  else if(WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM && runBudget > 0)
+  {
+    j->result.status = RESULT_TIMEOUT;
+  }
+  else
+  {
+    j->result.status = RESULT_CRASHED;
+    j->result.signal = WIFSIGNALED(status)?WTERMSIG(status):0;
+  }
+}
+
+/**
+ * @brief job function of the scheduler, generates the input of a data point and benchmarks it.
+ *
+ * Once a size of a series exceeded the time budget, the larger sizes of that series are skipped.
+ * @param job index of the job.
+ * @param worker index of the worker running it, selects the input buffers.
+ * @param arg pointer to Benchmark_t.
+ */
+void runJob(size_t job, unsigned worker, void *arg)
+{
+  Benchmark_t *b = arg;
+  Job_t *j = &b->jobs[job];
+  size_t series = job / b->seriesLength;
+
+  if(!isolate)
+  {
+    executeJob(b, j, worker, &j->result);
+    return;
+  }
+
+  if(__atomic_load_n(&b->seriesTimedOut[series], __ATOMIC_ACQUIRE))
+  {
+    memset(&j->result, 0, sizeof(Result_t));
+    j->result.status = RESULT_SKIPPED;
+    return;
+  }
+
+  executeIsolatedJob(b, j, worker);
+  if(j->result.status == RESULT_TIMEOUT) __atomic_store_n(&b->seriesTimedOut[series], 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief writes a job to the results database.
+ *
+ * Every record has the same fields, the ones of options that weren't given are null.
+ * @param b benchmark.
+ * @param j finished job.
+ */
+static void writeRecord(Benchmark_t *b, Job_t *j)
+{
+  static const char *statusNames[] = {"ok", "crashed", "timeout", "skipped"};
+  Module_t *m = &b->modules[j->module];
+  KeyType_t *type = &b->keyTypes[j->type];
+  Generator_t *gen = &b->generators[j->generator];
+  Result_t *r = &j->result;
+  ResultsFile_t *rf = b->results;
+  int ok = r->status == RESULT_OK, i;
+
+  res_begin(rf);
+  res_string(rf, "date", b->timeDate);
+  res_string(rf, "host", b->env.host);
+  res_string(rf, "cpu", b->env.cpu);
+  res_integer(rf, "cpus", b->env.cpus);
+  res_integer(rf, "cores", b->env.cores);
+  res_string(rf, "kernel", b->env.kernel);
+  res_string(rf, "compiler", b->env.compiler);
+  res_string(rf, "flags", b->env.flags);
+  res_string(rf, "revision", b->env.revision);
+  res_string(rf, "module", m->name);
+  res_string(rf, "library", m->library);
+  res_string(rf, "hash", m->hash);
+  res_integer(rf, "abi", m->abi);
+  res_string(rf, "entry", m->typed?"typed":"generic");
+  res_string(rf, "type", type->name);
+  res_string(rf, "generator", gen->name);
+  res_number(rf, "param", gen->paramHelp?gen->param:NAN);
+  res_integer(rf, "seed", b->seed);
+  res_integer(rf, "n", j->n);
+  res_integer(rf, "threads", j->threads);
+  res_number(rf, "k", (selectFraction >= 0)?selectK(m, j->n):NAN);
+  res_string(rf, "status", statusNames[r->status]);
+  res_string(rf, "signal", (r->status == RESULT_CRASHED)?strsignal(r->signal):0);
+  res_integer(rf, "valid", ok && r->valid);
+  res_number(rf, "stable", (ok && r->stable >= 0)?r->stable:NAN);
+  res_number(rf, "compares", ok?r->compares:NAN);
+  res_number(rf, "swaps", (ok && profileSwaps && m->hasSwaps)?r->swaps:NAN);
+  res_number(rf, "runs", ok?r->wall.count:NAN);
+  res_number(rf, "mean_ms", ok?r->wall.mean:NAN);
+  res_number(rf, "stddev_ms", ok?r->wall.stddev:NAN);
+  res_number(rf, "min_ms", ok?r->wall.min:NAN);
+  res_number(rf, "median_ms", ok?r->wall.median:NAN);
+  res_number(rf, "p95_ms", ok?r->wall.p95:NAN);
+  res_number(rf, "cpu_ms", ok?r->cpu.median:NAN);
+  res_number(rf, "tsc_cycles", ok?r->cycles.median:NAN);
+  res_number(rf, "melem_s", ok?r->throughput:NAN);
+  for(i = 0; i < PRF_COUNT; i++) res_number(rf, prf_getName(i), (ok && profilePerf && r->perf[i] >= 0)?r->perf[i]:NAN);
+  res_number(rf, "io_read", (ok && externalFolder)?r->ioRead:NAN);
+  res_number(rf, "io_written", (ok && externalFolder)?r->ioWritten:NAN);
+  res_number(rf, "disk_read", (ok && externalFolder)?r->diskRead:NAN);
+  res_number(rf, "disk_written", (ok && externalFolder)?r->diskWritten:NAN);
+  res_number(rf, "io_mb_s", (ok && externalFolder)?r->ioThroughput:NAN);
+  res_string(rf, "pages", plc_pagesName(placement.pages));
+  res_string(rf, "numa", plc_numaName(placement.numa));
+  res_number(rf, "huge_share", (ok && plc_active(&placement) && r->hugeShare >= 0)?r->hugeShare:NAN);
+  res_number(rf, "local_share", (ok && plc_active(&placement) && r->localShare >= 0)?r->localShare:NAN);
+  res_number(rf, "allocated", ok?r->memory.allocated:NAN);
+  res_number(rf, "peak", (ok && profileMemory)?r->memory.peak:NAN);
+  res_number(rf, "blocks", (ok && profileMemory)?r->memory.allocations:NAN);
+  res_number(rf, "reallocs", (ok && profileMemory)?r->memory.reallocations:NAN);
+  res_number(rf, "frees", (ok && profileMemory)?r->memory.frees:NAN);
+  res_number(rf, "leaked", (ok && profileMemory)?r->memory.leaked:NAN);
+  res_number(rf, "leaked_blocks", (ok && profileMemory)?r->memory.leakedBlocks:NAN);
+  res_end(rf);
+}
+
+/**
+ * @brief completion callback of the scheduler, outputs the data points in order.
+ *
+ * Opens the data file with the first data point of a series, closes it with the last and adds the series to the plot scripts.
+ * @param job index of the job.
+ * @param arg pointer to Benchmark_t.
+ */
+void jobDone(size_t job, void *arg)
+{
+  Benchmark_t *b = arg;
+  Job_t *j = &b->jobs[job];
+  Module_t *m = &b->modules[j->module];
+  KeyType_t *type = &b->keyTypes[j->type];
+  Generator_t *gen = &b->generators[j->generator];
+  char strtmp[256];
+  char threads[32] = ""; //added to the names of the series of a thread sweep
+  int i;
+
+  if(sweptThreads(m)) snprintf(threads, sizeof(threads), ", threads: %u", j->threads);
+
+  if(j->first)
+  {
+    if(j->firstOfModule)
+    {
+      printModule(m);
+      if(profileSwaps && m->hasSwaps) printf("Profiling swaps.\n");
+    }
+    printf("%s %s%s:\n", type->title, gen->title, threads);
+    printf("%10s %10s %10s %10s %12s %12s %12s %12s %12s %12s %14s %10s %6s %10s", "Values", "Compares", "Swaps", "Allocs", "Mean", "Stddev", "Min", "Median", "P95", "CPU", "Cycles", "Melem/s", "Runs", "Validity");
+    for(i = 0; i < PRF_COUNT && profilePerf; i++) printf(" %14s", prf_getName(i));
+    if(externalFolder) printf(" %12s %12s %12s %10s", "Read", "Written", "Disk", "IO MB/s");
+    if(plc_active(&placement)) printf(" %7s %7s", "Huge", "Local");
+    if(profileMemory) printf(" %12s %10s %10s %10s %12s", "Peak", "Blocks", "Reallocs", "Frees", "Leaked");
+    printf("\n");
+
+    if(b->plotFolder)
+    {
+      if(sweptThreads(m)) snprintf(b->plotDataName, 127, "%s_%s_%s_t%u_%s.gpd", m->name, type->name, gen->name, j->threads, b->timeDate);
+      else snprintf(b->plotDataName, 127, "%s_%s_%s_%s.gpd", m->name, type->name, gen->name, b->timeDate);
+      snprintf(strtmp, 255, "%s/%s", b->plotFolder, b->plotDataName);
+      b->plotData = fopen(strtmp, "w");
+      if(b->plotData) fprintf(b->plotData, "# seed: %llu\n", b->seed);
+      if(b->plotData && plc_active(&placement)) fprintf(b->plotData, "# pages: %s, numa: %s\n", plc_pagesName(placement.pages), plc_numaName(placement.numa));
+      if(b->plotData && selectFraction >= 0) fprintf(b->plotData, "# %s k = %g n\n", m->sortPartial?"partial sort,":"selection,", selectFraction);
+      if(b->plotData)
+      {
+        fprintf(b->plotData, "# values mean(ms) compares swaps allocs cpu(ms) cycles min(ms) median(ms) p95(ms) stddev(ms) runs melem/s");
+        for(i = 0; i < PRF_COUNT && profilePerf; i++) fprintf(b->plotData, " %s", prf_getName(i));
+        if(externalFolder) fprintf(b->plotData, " read written disk-read disk-written io(MB/s)");
+        if(plc_active(&placement)) fprintf(b->plotData, " huge-share local-share");
+        if(profileMemory) fprintf(b->plotData, " peak blocks reallocs frees leaked leaked-blocks");
+        fprintf(b->plotData, "\n");
+      }
+    }
+  }
+
+  printResult(&j->result, j->n, b->plotData);
+  if(b->results) writeRecord(b, j);
+
+  if(j->last && b->plotData)
+  {
+    fclose(b->plotData);
+    b->plotData = 0;
+    fprintf(b->pPlotFile, "\"%s\" u 1:2:11 t \"%s Time %s %s%s\" w yerrorbars, ", b->plotDataName, m->name, type->title, gen->title, threads);
+    fprintf(b->pPlotFileComp, "\"%s\" u 1:3 t \"%s Comparisons %s %s%s\" w points,", b->plotDataName, m->name, type->title, gen->title, threads);
+    if(profileMemory && b->pPlotFileMem)
+    {
+      //the memory columns follow the 13 columns every data file has, the hardware counters, the I/O and the placement columns
+      int peak = 14 + (profilePerf?PRF_COUNT:0) + (externalFolder?5:0) + (plc_active(&placement)?2:0);
+      fprintf(b->pPlotFileMem, "\"%s\" u 1:5 t \"%s %s %s%s\" w points, ", b->plotDataName, m->name, type->title, gen->title, threads);
+      fprintf(b->pPlotFileMem, "\"%s\" u 1:%d t \"%s Peak %s %s%s\" w points, ", b->plotDataName, peak, m->name, type->title, gen->title, threads);
+    }
+    if(profileSwaps && m->hasSwaps && b->pPlotFileSwap)  fprintf(b->pPlotFileSwap, "\"%s\" u 1:4 t \"%s %s %s%s\" w points, ", b->plotDataName, m->name, type->title, gen->title, threads);
+    for(i = 0; i < PRF_COUNT; i++)
+    {
+      //the counters follow the 13 columns every data file has
+      if(b->pPlotFilePerf[i]) fprintf(b->pPlotFilePerf[i], "\"%s\" u 1:%d t \"%s %s %s%s\" w points, ", b->plotDataName, 14 + i, m->name, type->title, gen->title, threads);
+    }
+  }
+}
+
+/**
+ * @brief prints speedup and parallel efficiency of every series of the thread sweep and adds them to the plot scripts.
+ *
+ * Both are calculated from the median wall-clock time of the largest size, relative to the series with a single thread.
+ * The series of the other thread counts follow that one in the jobs.
+ * @param b benchmark.
+ */
+void reportScaling(Benchmark_t *b)
+{
+  size_t i, t;
+  char strtmp[256];
+  char dataName[128];
+
+  for(i = 0; i < b->jobCount; i++)
+  {
+    Job_t *j = &b->jobs[i];
+    Module_t *m = &b->modules[j->module];
+    unsigned threads = sweptThreads(m);
+    if(!threads || !j->last || j->threads != 1) continue;
+    KeyType_t *type = &b->keyTypes[j->type];
+    Generator_t *gen = &b->generators[j->generator];
+
+    FILE *data = 0;
+    if(b->plotFolder)
+    {
+      snprintf(dataName, 127, "%s_%s_%s_scaling_%s.gpd", m->name, type->name, gen->name, b->timeDate);
+      snprintf(strtmp, 255, "%s/%s", b->plotFolder, dataName);
+      data = fopen(strtmp, "w");
+      if(data) fprintf(data, "# seed: %llu\n# values: %llu\n# threads median(ms) speedup efficiency\n", b->seed, (unsigned long long)j->n);
+    }
+
+    printf("Scaling of %s %s %s with %llu values:\n", m->name, type->title, gen->title, (unsigned long long)j->n);
+    printf("%10s %12s %10s %10s\n", "Threads", "Median", "Speedup", "Efficiency");
+    double base = (j->result.status == RESULT_OK)?j->result.wall.median:0;
+    for(t = 0; t < threads && i + t * b->seriesLength < b->jobCount; t++)
+    {
+      Result_t *r = &b->jobs[i + t * b->seriesLength].result;
+      unsigned n = b->jobs[i + t * b->seriesLength].threads;
+      if(r->status != RESULT_OK || base <= 0 || r->wall.median <= 0)
+      {
+        printf("%10u %12s %10s %10s\n", n, "-", "-", "-");
+        if(data) fprintf(data, "# %u -\n", n);
+        continue;
+      }
+      double speedup = base / r->wall.median;
+      printf("%10u %10.04lfms %10.03lf %9.01lf%%\n", n, r->wall.median, speedup, 100 * speedup / n);
+      if(data) fprintf(data, "%u %lf %lf %lf\n", n, r->wall.median, speedup, speedup / n);
+    }
+
+    if(data)
+    {
+      fclose(data);
+      if(b->pPlotFileSpeedup) fprintf(b->pPlotFileSpeedup, "\"%s\" u 1:3 t \"%s %s %s\" w linespoints, ", dataName, m->name, type->title, gen->title);
+      if(b->pPlotFileEfficiency) fprintf(b->pPlotFileEfficiency, "\"%s\" u 1:4 t \"%s %s %s\" w linespoints, ", dataName, m->name, type->title, gen->title);
+    }
+  }
+}
+
+/**
+ * @brief closes all plot scripts and the results database of a benchmark.
+ * @param b benchmark.
  */
-unsigned calculateSortSize(unsigned sortSize0, unsigned sample, unsigned growth, char growthType)
+void closePlots(Benchmark_t *b)
 {
-  unsigned tmp = 0;
-  switch(growthType)
+  if(b->pPlotFile) fclose(b->pPlotFile);
+  if(b->pPlotFileComp) fclose(b->pPlotFileComp);
+  if(b->pPlotFileMem) fclose(b->pPlotFileMem);
+  if(b->pPlotFileSwap) fclose(b->pPlotFileSwap);
+  if(b->pPlotFileSpeedup) fclose(b->pPlotFileSpeedup);
+  if(b->pPlotFileEfficiency) fclose(b->pPlotFileEfficiency);
+  b->pPlotFile = b->pPlotFileComp = b->pPlotFileMem = b->pPlotFileSwap = 0;
+  b->pPlotFileSpeedup = b->pPlotFileEfficiency = 0;
+  res_close(b->results);
+  b->results = 0;
+  int i;
+  for(i = 0; i < PRF_COUNT; i++)
   {
-    case 1:
-      tmp = (sortSize0 * (sample * growth)); break;
-    case 2: 
-      tmp = (sortSize0 * ipow(growth, sample)); break;
-    case 3:
-      tmp = sortSize0 + (sortSize0 * log10(growth*sample)); break;
+    if(b->pPlotFilePerf[i]) fclose(b->pPlotFilePerf[i]);
+    b->pPlotFilePerf[i] = 0;
   }
-
-  return tmp;
 }
 
 /**
@@ -275,16 +1472,50 @@ void printHelp(char *cmd)
   printf("Usage:\n\t%s [<options>]\n", cmd);
   printf("Available Options:\n"
          "\t-l,--libs <folder>         - Folder in which the libraries of the sorting algorithms to be tested are stored.\n"
+         "\t-o,--results <path>        - append every data point with the machine and build to <path>.jsonl and <path>.csv.\n"
+         "\t                             (default with -p: results_<date> in the plot folder)\n"
          "\t-p,--plots <folder>        - Folder in which the plot data will be written.\n"
          "\t-s,--start-size <number>   - Start-value to base the sample size on.\n"
          "\t-r,--runs <number>         - number of test runs to perform.\n"
          "\t-g,--growth <number>       - run to run growth.\n"
-         "\t-t,--growth-type <number>  - how the sample size will grow.(1: linear, 2: exponential, 3: logarithmic)\n"
-         "\t-m,--profile-memory        - record memory usage.\n"
+         "\t-t,--growth-type <number>  - how the sample size will grow.(1: linear, 2: exponential, 3: logarithmic,\n"
+         "\t                             4: geometric sweep from the start to the end size with growth points per decade(default: 10),\n"
+         "\t                             denser around the cache sizes, which get marked in the time plot. Ignores the runs.)\n"
+         "\t-E,--end-size <number>     - with growth type 4: largest sample size.(default: 1000 times the start size)\n"
+         "\t-m,--profile-memory        - record allocated bytes, peak live bytes, allocation counts, sizes and leaks.\n"
          "\t-n,--profile-swaps         - record how many swaps were needed.\n"
          "\t-v,--verbose               - output lists.\n"
          "\t-h,--help                  - this.\n"
-         "\t-a,--average <number>      - how often to run the test to average the time.\n");
+         "\t-a,--average <number>      - how often to run the test to average the time.\n"
+         "\t-w,--warmup <number>       - runs to do before recording, they are discarded.\n"
+         "\t-c,--confidence <percent>  - repeat runs until the 95%% confidence interval is below this percentage of the mean.\n"
+         "\t-x,--max-average <number>  - maximum number of runs when repeating for a confidence.(default: 100)\n"
+         "\t-d,--distributions <list>  - comma separated list of input distributions, \"all\" for every one.(default: sorted,random)\n"
+         "\t                             a parameter can be given after a colon, e.g. fewunique:4. Available distributions:\n");
+  gen_printGenerators();
+  printf("\t-S,--seed <number>         - seed for the random distributions, to regenerate the inputs of a previous benchmark.(default: current time)\n"
+         "\t-G,--gen-threads <number>  - threads used to generate the inputs.(default: number of cpus)\n"
+         "\t-k,--key-types <list>      - comma separated list of element types, \"all\" for every one.(default: i32) Available types:\n");
+  key_printTypes();
+  printf("\t-j,--jobs <number>         - benchmarks to run concurrently, each worker gets pinned to its own physical core.(default: 1)\n"
+         "\t-C,--cpus <list>           - cpus to pin the workers to, e.g. 0-3,8.(default: one cpu of every physical core)\n"
+         "\t-i,--isolate               - run every benchmark in its own process, so crashing modules don't end the benchmark.\n"
+         "\t-T,--time-budget <ms>      - with --isolate: time a single run may take, larger sizes are skipped once it is exceeded.\n"
+         "\t-P,--threads <number>      - threads handed to parallel modules.(default: 1)\n"
+         "\t-W,--thread-sweep <number> - run parallel modules with 1 up to this many threads and report speedup and efficiency.\n"
+         "\t-e,--entry <entry>         - entries of modules exporting type-specialized ones, e.g. sort_i32: typed, generic or both.(default: typed)\n"
+         "\t-H,--perf-counters         - record cycles, instructions, branch misses, L1d, LLC and dTLB misses with hardware performance counters.\n"
+         "\t-X,--external <folder>     - keep inputs and outputs in files in this folder and benchmark the external-memory modules only,\n"
+         "\t                             so the sizes may exceed the memory. Reports bytes read and written and the I/O throughput.\n"
+         "\t-M,--memory <MB>           - with --external: memory the modules may use.(default: 64)\n"
+         "\t-R,--ram <MB>              - memory the buffers of all workers may take, the largest sizes are dropped until they fit.\n"
+         "\t                             (default: available memory, MemAvailable of /proc/meminfo)\n"
+         "\t-K,--select <fraction>     - benchmark the selection and partial-sort modules only, with k = fraction * n, e.g. 0.5 for the median.\n"
+         "\t                             Results are checked for being partitioned around k instead of sorted.\n"
+         "\t-B,--pages <pages>         - pages of the input, sort and scratch buffers: default(malloc), small(no huge pages), thp(transparent\n"
+         "\t                             huge pages) or huge(explicit huge pages from vm.nr_hugepages). Reports the share that got huge pages.\n"
+         "\t-N,--numa <placement>      - NUMA node of the buffers: default(first touch), local, interleave or remote to the worker's cpu.\n"
+         "\t                             Pins a single worker to the current cpu if no cpus are given. Reports the share on the local node.\n");
 }
 
 int main(int argc, char **argv)
@@ -293,16 +1524,33 @@ int main(int argc, char **argv)
   char outputPlotData = 0;
   char *plotFolder;
 
+  char *resultsPath = 0;
+
   char *moduleFolder = malloc(3);
   strcpy(moduleFolder, "./");
 
-  unsigned sortSize0 = 10, sortSize;
+  size_t sortSize0 = 10;
   unsigned runs = 5;
 
   unsigned runSortSizeGrowthRate = 2;
   unsigned runSortSizeGrowthType = 1;
-
-  int profileSwaps0 = 0;
+  size_t endSize = 0;
+  size_t ramBudget = 0;
+  CacheBoundary_t boundaries[SIZ_MAX_BOUNDARIES];
+  unsigned boundaryCount = 0;
+
+  char *distributions = "sorted,random";
+  Generator_t *generators = 0;
+  char *types = "i32";
+  KeyType_t *keyTypes = 0;
+  size_t keyTypeCount = 0;
+  size_t generatorCount = 0;
+  unsigned long long seed = time(0);
+  unsigned genThreads = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned workers = 1;
+  int workersSet = 0;
+  int cpus[CPU_SETSIZE];
+  unsigned cpuCount = 0;
 
 
   //create Argument List
@@ -312,9 +1560,32 @@ int main(int argc, char **argv)
   ArgParam_t *amodules =   arg_addParam(pargs, 'l', "libs");
   ArgParam_t *asortsize = arg_addParam(pargs, 's', "start-size");
   ArgParam_t *aruns = arg_addParam(pargs, 'r', "runs");
+  ArgParam_t *aendsize = arg_addParam(pargs, 'E', "end-size");
   ArgParam_t *agrowth = arg_addParam(pargs, 'g', "growth");
   ArgParam_t *agrowthtype = arg_addParam(pargs, 't', "growth-type");
   ArgParam_t *aaveraging = arg_addParam(pargs, 'a', "average");
+  ArgParam_t *awarmup = arg_addParam(pargs, 'w', "warmup");
+  ArgParam_t *aconfidence = arg_addParam(pargs, 'c', "confidence");
+  ArgParam_t *amaxaveraging = arg_addParam(pargs, 'x', "max-average");
+  ArgParam_t *adistributions = arg_addParam(pargs, 'd', "distributions");
+  ArgParam_t *aseed = arg_addParam(pargs, 'S', "seed");
+  ArgParam_t *atypes = arg_addParam(pargs, 'k', "key-types");
+  ArgParam_t *agenthreads = arg_addParam(pargs, 'G', "gen-threads");
+  ArgParam_t *ajobs = arg_addParam(pargs, 'j', "jobs");
+  ArgParam_t *acpus = arg_addParam(pargs, 'C', "cpus");
+  ArgParam_t *abudget = arg_addParam(pargs, 'T', "time-budget");
+  ArgSwitch_t *aisolate = arg_addSwitch(pargs, 'i', "isolate");
+  ArgParam_t *asortthreads = arg_addParam(pargs, 'P', "threads");
+  ArgParam_t *asweep = arg_addParam(pargs, 'W', "thread-sweep");
+  ArgParam_t *aentry = arg_addParam(pargs, 'e', "entry");
+  ArgSwitch_t *aperf = arg_addSwitch(pargs, 'H', "perf-counters");
+  ArgParam_t *aexternal = arg_addParam(pargs, 'X', "external");
+  ArgParam_t *amemory = arg_addParam(pargs, 'M', "memory");
+  ArgParam_t *aram = arg_addParam(pargs, 'R', "ram");
+  ArgParam_t *aresults = arg_addParam(pargs, 'o', "results");
+  ArgParam_t *aselect = arg_addParam(pargs, 'K', "select");
+  ArgParam_t *apages = arg_addParam(pargs, 'B', "pages");
+  ArgParam_t *anuma = arg_addParam(pargs, 'N', "numa");
   ArgSwitch_t *aprofilemem = arg_addSwitch(pargs, 'm', "profile-memory"); 
   ArgSwitch_t *aprofileswaps = arg_addSwitch(pargs, 'n', "profile-swaps");
   ArgSwitch_t *averbose = arg_addSwitch(pargs, 'v', "verbose");
@@ -339,6 +1610,12 @@ int main(int argc, char **argv)
     printf("Will output plots to \"%s\".\n", plotFolder);
   }
 
+  if(aresults->value && strlen(aresults->value))
+  {
+    resultsPath = aresults->value;
+    printf("Will append the results to \"%s.jsonl\" and \"%s.csv\".\n", resultsPath, resultsPath);
+  }
+
   if(amodules->value && strlen(amodules->value))
   {
     free(moduleFolder);
@@ -349,7 +1626,7 @@ int main(int argc, char **argv)
 
   if(asortsize->value && strlen(asortsize->value))
   {
-    sscanf(asortsize->value, "%u", &sortSize0);
+    sscanf(asortsize->value, "%zu", &sortSize0);
   }
 
   if(aruns && aruns->value && strlen(aruns->value))
@@ -362,6 +1639,160 @@ int main(int argc, char **argv)
     sscanf(aaveraging->value, "%u", &averagingRuns);
   }
 
+  if(awarmup->value && strlen(awarmup->value))
+  {
+    sscanf(awarmup->value, "%u", &warmupRuns);
+  }
+
+  if(aconfidence->value && strlen(aconfidence->value))
+  {
+    sscanf(aconfidence->value, "%lf", &targetConfidence);
+  }
+
+  if(amaxaveraging->value && strlen(amaxaveraging->value))
+  {
+    sscanf(amaxaveraging->value, "%u", &maxAveragingRuns);
+  }
+
+  if(adistributions->value && strlen(adistributions->value))
+  {
+    distributions = adistributions->value;
+  }
+
+  if(aseed->value && strlen(aseed->value))
+  {
+    sscanf(aseed->value, "%llu", &seed);
+  }
+
+  if(agenthreads->value && strlen(agenthreads->value))
+  {
+    sscanf(agenthreads->value, "%u", &genThreads);
+  }
+
+  if(atypes->value && strlen(atypes->value))
+  {
+    types = atypes->value;
+  }
+
+  if(ajobs->value && strlen(ajobs->value))
+  {
+    sscanf(ajobs->value, "%u", &workers);
+    workersSet = 1;
+  }
+
+  if(acpus->value && strlen(acpus->value))
+  {
+    cpuCount = sch_parseCpuList(acpus->value, cpus, CPU_SETSIZE);
+  }
+
+  if(aperf->switched)
+  {
+    profilePerf = 1;
+    if(!prf_probe())
+    {
+      fprintf(stderr, "Continuing without hardware performance counters.\n");
+      profilePerf = 0;
+    }
+  }
+
+  if(aentry->value && strlen(aentry->value))
+  {
+    if(!strcmp(aentry->value, "typed")) entryMode = ENTRY_TYPED;
+    else if(!strcmp(aentry->value, "generic")) entryMode = ENTRY_GENERIC;
+    else if(!strcmp(aentry->value, "both")) entryMode = ENTRY_BOTH;
+    else fprintf(stderr, "Unknown entry \"%s\", using the type-specialized ones.\n", aentry->value);
+  }
+
+  if(asortthreads->value && strlen(asortthreads->value))
+  {
+    sscanf(asortthreads->value, "%u", &sortThreads);
+    if(sortThreads < 1) sortThreads = 1;
+  }
+
+  if(asweep->value && strlen(asweep->value))
+  {
+    sscanf(asweep->value, "%u", &threadSweep);
+    if(threadSweep) printf("Will run parallel modules with 1 to %u threads.\n", threadSweep);
+  }
+
+  if(abudget->value && strlen(abudget->value))
+  {
+    sscanf(abudget->value, "%lf", &runBudget);
+  }
+
+  if(aexternal->value && strlen(aexternal->value))
+  {
+    externalFolder = aexternal->value;
+    if(amemory->value && strlen(amemory->value))
+    {
+      unsigned long long mb = 0;
+      sscanf(amemory->value, "%llu", &mb);
+      if(mb) externalMemory = mb << 20;
+    }
+    printf("Will sort files in \"%s\" with %lluMB of memory.\n", externalFolder, (unsigned long long)(externalMemory >> 20));
+  }
+
+  if(aselect->value && strlen(aselect->value))
+  {
+    sscanf(aselect->value, "%lf", &selectFraction);
+    if(externalFolder)
+    {
+      printf("Selecting can't be combined with --external, ignoring it.\n");
+      selectFraction = -1;
+    }
+    else if(selectFraction < 0 || selectFraction > 1)
+    {
+      printf("The fraction to select has to be between 0 and 1, ignoring it.\n");
+      selectFraction = -1;
+    }
+    else printf("Will select k = %g n.\n", selectFraction);
+  }
+
+  if(apages->value && strlen(apages->value))
+  {
+    placement.pages = plc_parsePages(apages->value);
+    if(placement.pages < 0)
+    {
+      fprintf(stderr, "Unknown pages \"%s\", using the default ones.\n", apages->value);
+      placement.pages = PLC_PAGES_DEFAULT;
+    }
+  }
+
+  if(anuma->value && strlen(anuma->value))
+  {
+    placement.numa = plc_parseNuma(anuma->value);
+    if(placement.numa < 0)
+    {
+      fprintf(stderr, "Unknown NUMA placement \"%s\", using first touch.\n", anuma->value);
+      placement.numa = PLC_NUMA_DEFAULT;
+    }
+    if(placement.numa == PLC_NUMA_REMOTE && plc_nodes() < 2) printf("There is a single NUMA node, remote memory is local.\n");
+  }
+
+  if(plc_active(&placement)) printf("Will place buffers on %s pages, NUMA placement: %s.\n", plc_pagesName(placement.pages), plc_numaName(placement.numa));
+
+  if(aisolate->switched)
+  {
+    isolate = 1;
+    printf("Will run every benchmark in its own process.\n");
+  }
+  else if(runBudget > 0)
+  {
+    printf("The time budget needs --isolate, ignoring it.\n");
+    runBudget = 0;
+  }
+
+  generators = gen_parseList(distributions, &generatorCount);
+  keyTypes = key_parseList(types, &keyTypeCount);
+  if(!generators || !keyTypes)
+  {
+    arg_destroyArgs(pargs);
+    free(moduleFolder);
+    free(generators);
+    free(keyTypes);
+    return 1;
+  }
+
   if(agrowth->value && strlen(agrowth->value))
   {
     sscanf(agrowth->value, "%u", &runSortSizeGrowthRate);
@@ -372,18 +1803,34 @@ int main(int argc, char **argv)
     sscanf(agrowthtype->value, "%u", &runSortSizeGrowthType);
   }
 
+  if(aendsize->value && strlen(aendsize->value))
+  {
+    sscanf(aendsize->value, "%zu", &endSize);
+  }
+
+  if(aram->value && strlen(aram->value))
+  {
+    sscanf(aram->value, "%zu", &ramBudget);
+    ramBudget = siz_multiply(ramBudget, 1 << 20);
+  }
+
+  if(runSortSizeGrowthType == 4)
+  {
+    if(!agrowth->value || !strlen(agrowth->value)) runSortSizeGrowthRate = 10;
+    if(!sortSize0) sortSize0 = 1;
+    if(endSize < sortSize0) endSize = siz_multiply(sortSize0, 1000);
+    boundaryCount = siz_cacheBoundaries(boundaries, SIZ_MAX_BOUNDARIES);
+    runs = siz_sweepLength(sortSize0, endSize, runSortSizeGrowthRate, boundaryCount);
+  }
+
   if(aprofilemem->switched)
   {
-    profileMemory = 1;
-#ifdef _GNU_SOURCE
-    printf("Will profile memory usage.\n");
-#else
-    printf("Can't profile memory usage!\n");
-#endif
+    profileMemory = mem_available();
+    if(profileMemory) printf("Will profile memory usage.\n");
+    else printf("Can't profile memory usage!\n");
   }
   if(aprofileswaps->switched) 
   {
-    profileSwaps0 = 1;
     profileSwaps = 1;
 
     printf("Will profile swaps.\n");
@@ -391,49 +1838,186 @@ int main(int argc, char **argv)
 
   arg_destroyArgs(pargs);
 
-  unsigned maxSortSize = calculateSortSize(sortSize0, runs, runSortSizeGrowthRate, runSortSizeGrowthType);
+  //one worker per physical core at most, so SMT siblings don't disturb each other
+  if(!cpuCount && workers > 1) cpuCount = sch_physicalCores(cpus, CPU_SETSIZE);
+  //nodes are placed relative to the worker's cpu, so it must not migrate
+  if(placement.numa != PLC_NUMA_DEFAULT && !cpuCount)
+  {
+    cpus[0] = sched_getcpu();
+    cpuCount = 1;
+  }
+  if(cpuCount && workers > cpuCount) workers = cpuCount;
+  if(cpuCount && !workersSet) workers = cpuCount;
+  if(workers < 1) workers = 1;
+  //the memory profile records the whole process, so nothing may run besides the profiled job, the scheduler would print
+  //and plot the finished jobs meanwhile. Isolated jobs have a process of their own.
+  if(profileMemory && !isolate && (workers > 1 || cpuCount))
+  {
+    printf("Profiling memory runs the jobs inline, one at a time, unless they are isolated.\n");
+    workers = 1;
+    cpuCount = 0;
+  }
+
+  //sample sizes of every key type, the sweep puts them relative to the cache sizes in bytes
+  size_t maxSortSize = 0, *sizes = calloc((size_t)keyTypeCount * runs + 1, sizeof(size_t));
+  size_t k;
+  unsigned long long i;
+  for(k = 0; k < keyTypeCount && sizes; k++)
+  {
+    size_t *typeSizes = sizes + k * runs;
+    if(runSortSizeGrowthType == 4) siz_sweep(sortSize0, endSize, runSortSizeGrowthRate, boundaries, boundaryCount, keyTypes[k].size, typeSizes, runs);
+    else for(i = 0; i < runs; i++) typeSizes[i] = calculateSortSize(sortSize0, i+1, runSortSizeGrowthRate, runSortSizeGrowthType);
+  }
+
+  //a size whose elements don't fit into the address space can't be benchmarked, not even by files
+  for(i = 0; sizes && i < keyTypeCount * runs; i++)
+  {
+    if(siz_multiply(sizes[i], sizeof(int64_t) + keyTypes[i / runs].size) == SIZE_MAX)
+    {
+      fprintf(stderr, "The %s elements of run %llu overflow the address space!\n", keyTypes[i / runs].title, i % runs + 1);
+      free(sizes);
+      sizes = 0;
+    }
+  }
+
+  //drop the largest sizes until every worker's buffers fit into the memory, external-memory modules only get their budget
+  if(sizes && !externalFolder)
+  {
+    size_t available = ramBudget?ramBudget:siz_availableMemory();
+    size_t fitting = runs, needed = footprint(keyTypes, keyTypeCount, sizes, runs, runs, workers);
+    while(available && fitting && footprint(keyTypes, keyTypeCount, sizes, runs, fitting, workers) > available) fitting--;
+    if(!fitting)
+    {
+      fprintf(stderr, "Even the smallest size needs %zuMiB, only %zuMiB of memory are available!\n",
+              footprint(keyTypes, keyTypeCount, sizes, runs, 1, workers) >> 20, available >> 20);
+      free(sizes);
+      sizes = 0;
+    }
+    else if(fitting < runs)
+    {
+      printf("The benchmark needs up to %zuMiB, only %zuMiB of memory are available: dropping the %zu largest sizes.\n",
+             needed >> 20, available >> 20, runs - fitting);
+      for(k = 1; k < keyTypeCount; k++) memmove(sizes + k * fitting, sizes + k * runs, fitting * sizeof(size_t));
+      runs = fitting;
+    }
+  }
+  if(!sizes)
+  {
+    free(moduleFolder);
+    free(generators);
+    free(keyTypes);
+    return 1;
+  }
+  for(i = 0; i < keyTypeCount * runs; i++) if(sizes[i] > maxSortSize) maxSortSize = sizes[i];
+
+  printf("Runs: %u\nMin. Values: %zu\nGrowth: %u\nGrowth-type: %u\nMax. Values: %zu\nSeed: %llu\n", runs, sortSize0, runSortSizeGrowthRate, runSortSizeGrowthType, maxSortSize, seed);
+  if(boundaryCount)
+  {
+    printf("Cache boundaries:");
+    for(i = 0; i < boundaryCount; i++) printf(" %s %zuKiB", boundaries[i].name, boundaries[i].size >> 10);
+    printf("\n");
+  }
 
-  printf("Runs: %u\nMin. Values: %u\nGrowth: %u\nGrowth-type: %u\nMax. Values: %u\n", runs, sortSize0, runSortSizeGrowthRate, runSortSizeGrowthType, maxSortSize);
+  tim_calibrate();
+  if(tim_getTscFrequency() > 0) printf("TSC: %.03lfMHz\n", tim_getTscFrequency() / 1000);
+  else printf("TSC: not available\n");
   
   time_t tnow = time(0);
   struct tm *now = localtime(&tnow);
   char timeDate[16];
   strftime(timeDate, 16, "%d%m%Y_%H%M%S", now);  
 
-  char strtmp[128];
-  FILE *pPlotFile = 0;
-  FILE *pPlotFileMem = 0;
-  FILE *pPlotFileSwap = 0;
-  FILE *pPlotFileComp = 0;
+  char strtmp[256];
+  Benchmark_t bench;
+  memset(&bench, 0, sizeof(bench));
+  bench.keyTypes = keyTypes;
+  bench.keyTypeCount = keyTypeCount;
+  bench.generators = generators;
+  bench.generatorCount = generatorCount;
+  bench.seed = seed;
+  bench.genThreads = genThreads;
+  bench.timeDate = timeDate;
+
+  //the plots get a results database of their own if none is given
+  if(resultsPath || outputPlotData)
+  {
+    if(!resultsPath) snprintf(strtmp, 255, "%s/results_%s", plotFolder, timeDate);
+    else snprintf(strtmp, 255, "%s", resultsPath);
+    res_environment(&bench.env);
+    bench.results = res_open(strtmp);
+    if(!bench.results) perror("Opening the results database failed");
+  }
 
   //get our GNU Plot script ready
   if(outputPlotData)
   {
-    snprintf(strtmp, 127, "%s/sorts_time_%s.gp", plotFolder, timeDate);
-    pPlotFile = fopen(strtmp, "w");
-    if(!pPlotFile)
+    bench.plotFolder = plotFolder;
+
+    snprintf(strtmp, 255, "%s/sorts_time_%s.gp", plotFolder, timeDate);
+    bench.pPlotFile = fopen(strtmp, "w");
+    snprintf(strtmp, 255, "%s/sorts_compares_%s.gp", plotFolder, timeDate);
+    bench.pPlotFileComp = fopen(strtmp, "w");
+    if(profileMemory)
     {
-      perror("Opening Plot-file failed!");
-      free(moduleFolder);
+      snprintf(strtmp, 255, "%s/sorts_memory_%s.gp", plotFolder, timeDate);
+      bench.pPlotFileMem = fopen(strtmp, "w");
+    }
+    if(profileSwaps)
+    {
+      snprintf(strtmp, 255, "%s/sorts_swaps_%s.gp", plotFolder, timeDate);
+      bench.pPlotFileSwap = fopen(strtmp, "w");
+    }
 
-      return 1;
+    int c, perfFailed = 0;
+    for(c = 0; c < PRF_COUNT && profilePerf; c++)
+    {
+      snprintf(strtmp, 255, "%s/sorts_%s_%s.gp", plotFolder, prf_getName(c), timeDate);
+      bench.pPlotFilePerf[c] = fopen(strtmp, "w");
+      if(!bench.pPlotFilePerf[c]) perfFailed = 1;
+    }
+
+    if(threadSweep)
+    {
+      snprintf(strtmp, 255, "%s/sorts_speedup_%s.gp", plotFolder, timeDate);
+      bench.pPlotFileSpeedup = fopen(strtmp, "w");
+      snprintf(strtmp, 255, "%s/sorts_efficiency_%s.gp", plotFolder, timeDate);
+      bench.pPlotFileEfficiency = fopen(strtmp, "w");
     }
-    fprintf(pPlotFile, "set title \"Sorting Algorithms Time Benchmark\"\n"
-                       "set xlabel \"Worksize(Array-elements)\"\n"
-                       "set ylabel \"Time(ms)\"\n"
-                       "set autoscale\n"
-                       "plot ");
 
-    snprintf(strtmp, 127, "%s/sorts_compares_%s.gp", plotFolder, timeDate);
-    pPlotFileComp = fopen(strtmp, "w");
-    if(!pPlotFileComp)
+    if(!bench.pPlotFile || !bench.pPlotFileComp || (profileMemory && !bench.pPlotFileMem) || (profileSwaps && !bench.pPlotFileSwap) || perfFailed ||
+       (threadSweep && (!bench.pPlotFileSpeedup || !bench.pPlotFileEfficiency)))
     {
       perror("Opening Plot-file failed!");
+      closePlots(&bench);
+      free(sizes);
       free(moduleFolder);
-      fclose(pPlotFile);
+      free(generators);
+      free(keyTypes);
       return 1;
     }
-    fprintf(pPlotFileComp, "set title \"Sorting Algorithms Comparisons Benchmark\"\n"
+
+    fprintf(bench.pPlotFile, "# seed: %llu\n", seed);
+    fprintf(bench.pPlotFile, "set title \"Sorting Algorithms Time Benchmark\"\n"
+                       "set xlabel \"Worksize(Array-elements)\"\n"
+                       "set ylabel \"Time(ms)\"\n"
+                       "set autoscale\n");
+    //mark where the elements of every type outgrow a cache level
+    if(boundaryCount) fprintf(bench.pPlotFile, "set logscale x\n");
+    for(k = 0; k < keyTypeCount; k++)
+    {
+      for(i = 0; i < boundaryCount; i++)
+      {
+        size_t n = boundaries[i].size / keyTypes[k].size;
+        if(n < sortSize0 || n > endSize) continue;
+        fprintf(bench.pPlotFile, "set arrow from %zu, graph 0 to %zu, graph 1 nohead dashtype 2\n", n, n);
+        fprintf(bench.pPlotFile, "set label \"%s%s%s\" at %zu, graph 0.98 right rotate by 90 offset -0.5,0\n",
+                boundaries[i].name, (keyTypeCount > 1)?" ":"", (keyTypeCount > 1)?keyTypes[k].title:"", n);
+      }
+    }
+    fprintf(bench.pPlotFile, "plot ");
+
+    fprintf(bench.pPlotFileComp, "# seed: %llu\n", seed);
+    fprintf(bench.pPlotFileComp, "set title \"Sorting Algorithms Comparisons Benchmark\"\n"
                        "set xlabel \"Worksize(Array-elements)\"\n"
                        "set ylabel \"Comparisons\"\n"
                        "set autoscale\n"
@@ -441,37 +2025,28 @@ int main(int argc, char **argv)
 
     if(profileMemory)
     {
-      snprintf(strtmp, 127, "%s/sorts_memory_%s.gp", plotFolder, timeDate);
-      pPlotFileMem = fopen(strtmp, "w");
-      if(!pPlotFileMem)
-      {
-        perror("Opening Plot-file failed!");
-        free(moduleFolder);
-        fclose(pPlotFile);
-        fclose(pPlotFileComp);
-        return 1;
-      }
-      fprintf(pPlotFileMem, "set title \"Sorting Algorithms Memory Benchmark\"\n"
+      fprintf(bench.pPlotFileMem, "# seed: %llu\n", seed);
+      fprintf(bench.pPlotFileMem, "set title \"Sorting Algorithms Memory Benchmark\"\n"
                          "set xlabel \"Worksize(Array-elements)\"\n"
-                         "set ylabel \"Memory Usage\"\n"
+                         "set ylabel \"Memory Usage(bytes)\"\n"
                          "set autoscale\n"
                          "plot ");
     }
 
+    for(c = 0; c < PRF_COUNT && profilePerf; c++)
+    {
+      fprintf(bench.pPlotFilePerf[c], "# seed: %llu\n", seed);
+      fprintf(bench.pPlotFilePerf[c], "set title \"Sorting Algorithms %s Benchmark\"\n"
+                         "set xlabel \"Worksize(Array-elements)\"\n"
+                         "set ylabel \"%s\"\n"
+                         "set autoscale\n"
+                         "plot ", prf_getName(c), prf_getName(c));
+    }
+
     if(profileSwaps)
     {
-      snprintf(strtmp, 127, "%s/sorts_swaps_%s.gp", plotFolder, timeDate);
-      pPlotFileSwap = fopen(strtmp, "w");
-      if(!pPlotFileSwap)
-      {
-        perror("Opening Plot-file failed!");
-        free(moduleFolder);
-        fclose(pPlotFile);
-        fclose(pPlotFileComp);
-        if(profileMemory) fclose(pPlotFileMem);
-        return 1;
-      }
-      fprintf(pPlotFileSwap, "set title \"Sorting Algorithms Swaps Benchmark\"\n"
+      fprintf(bench.pPlotFileSwap, "# seed: %llu\n", seed);
+      fprintf(bench.pPlotFileSwap, "set title \"Sorting Algorithms Swaps Benchmark\"\n"
                          "set xlabel \"Worksize(Array-elements)\"\n"
                          "set ylabel \"Swaps\"\n"
                          "set autoscale\n"
@@ -479,220 +2054,152 @@ int main(int argc, char **argv)
     }
   }
 
-  DIR *modDir = opendir(moduleFolder);
-  //free(moduleFolder);
-  if(!modDir)
+  if(outputPlotData && threadSweep)
   {
-    perror("Opening module directory failed!");
-    if(outputPlotData)
-    {
-      fclose(pPlotFile);
-      fclose(pPlotFileComp);
-      if(profileMemory) fclose(pPlotFileMem);
-      if(profileSwaps) fclose(pPlotFileSwap);
-      //remove(strtmp);
-    }
-    free(moduleFolder);
-    return 1;
+    fprintf(bench.pPlotFileSpeedup, "# seed: %llu\n", seed);
+    fprintf(bench.pPlotFileSpeedup, "set title \"Sorting Algorithms Speedup\"\n"
+                       "set xlabel \"Threads\"\n"
+                       "set ylabel \"Speedup\"\n"
+                       "set autoscale\n"
+                       "plot x t \"Ideal\" w lines, ");
+
+    fprintf(bench.pPlotFileEfficiency, "# seed: %llu\n", seed);
+    fprintf(bench.pPlotFileEfficiency, "set title \"Sorting Algorithms Parallel Efficiency\"\n"
+                       "set xlabel \"Threads\"\n"
+                       "set ylabel \"Efficiency\"\n"
+                       "set yrange [0:*]\n"
+                       "plot 1 t \"Ideal\" w lines, ");
   }
 
-  //test array for sorting numbers of random order
-  //int *randomNumbers0 = malloc(maxSortSize * sizeof(int)); //original random list
-  int *randomNumbers = malloc(maxSortSize * sizeof(int)); //copy to be sorted
-  if(!randomNumbers)
+  bench.modules = loadModules(moduleFolder, &bench.moduleCount);
+  free(moduleFolder);
+  if(!bench.modules)
   {
-    perror("Couldn't allocate random number array!");
-    if(outputPlotData)
-    {
-      fclose(pPlotFile);
-      fclose(pPlotFileComp);
-      if(profileMemory) fclose(pPlotFileMem);
-      if(profileSwaps) fclose(pPlotFileSwap);
-      //remove(strtmp);
-    }
-    free(moduleFolder);
+    closePlots(&bench);
+    free(sizes);
+    free(generators);
+    free(keyTypes);
     return 1;
   }
 
-  unsigned long long i;
-  srand(time(0));
-  for(i = 0; i < maxSortSize; i++)
-  {
-    randomNumbers[i] = rand();//randomNumbers0[i] = rand();
-  }
-
-  //memcpy(randomNumbers, randomNumbers0, sizeof(int)*maxSortSize);
+  //every module sorts every type of every distribution in every size, in this order
+  size_t m, d;
+  bench.jobCount = bench.moduleCount * keyTypeCount * generatorCount * runs * (threadSweep?threadSweep:1);
+  bench.jobs = calloc(bench.jobCount?bench.jobCount:1, sizeof(Job_t));
 
-  //int *sortedNumbers0 = malloc(maxSortSize * sizeof(int));
-  int *sortedNumbers = malloc(maxSortSize * sizeof(int));
-  if(!sortedNumbers)
+  size_t maxTypeSize = 0;
+  for(k = 0; k < keyTypeCount; k++)
   {
-    perror("Couldn't allocate random number array!");
-    if(outputPlotData)
-    {
-      fclose(pPlotFile);
-      fclose(pPlotFileComp);
-      if(profileMemory) fclose(pPlotFileMem);
-      if(profileSwaps) fclose(pPlotFileSwap);
-      //remove(strtmp);
-    }
-    free(moduleFolder);
-    free(randomNumbers);
-    return 1;
+    if(keyTypes[k].size > maxTypeSize) maxTypeSize = keyTypes[k].size;
   }
 
-  for(i = 0; i < maxSortSize; i++)
+  //keys that get filled by the generators and the elements built from them, one set per worker
+  if(workers > bench.jobCount) workers = bench.jobCount?bench.jobCount:1;
+  bench.keys = calloc(workers, sizeof(int64_t*));
+  bench.data = calloc(workers, sizeof(void*));
+  bench.shared = calloc(workers, sizeof(Result_t*));
+  bench.keyFiles = calloc(workers, sizeof(int));
+  bench.dataFiles = calloc(workers, sizeof(int));
+  bench.outFiles = calloc(workers, sizeof(int));
+  bench.seriesLength = runs?runs:1;
+  bench.seriesTimedOut = calloc(bench.jobCount / bench.seriesLength + 1, 1);
+  int allocated = sizes && bench.jobs && bench.keys && bench.data && bench.shared && bench.seriesTimedOut && bench.keyFiles && bench.dataFiles && bench.outFiles;
+  int unused;
+  for(i = 0; allocated && i < workers; i++)
   {
-    sortedNumbers[i] = i; //sortedNumbers0[i] = i;
+    bench.outFiles[i] = -1;
+    bench.keys[i] = allocBuffer(siz_multiply(maxSortSize, sizeof(int64_t)), externalPath(strtmp, sizeof(strtmp), "keys", i, timeDate), &bench.keyFiles[i], workerCpu(cpus, cpuCount, i));
+    bench.data[i] = allocBuffer(siz_multiply(maxSortSize, maxTypeSize), externalPath(strtmp, sizeof(strtmp), "input", i, timeDate), &bench.dataFiles[i], workerCpu(cpus, cpuCount, i));
+    bench.shared[i] = allocBuffer(sizeof(Result_t), 0, &unused, -1);
+    if(externalPath(strtmp, sizeof(strtmp), "output", i, timeDate)) bench.outFiles[i] = open(strtmp, O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if(!bench.keys[i] || !bench.data[i] || !bench.shared[i] || (externalFolder && bench.outFiles[i] < 0)) allocated = 0;
   }
 
-  char plotDataName[128];
-
-  struct dirent *file;
-  void *libHandle = 0;
-  getSortNameFn_t sortNameFn = 0;
-  getSortSymbolFn_t sortSymbolFn = 0;
-  sortFn_t sortFn = 0;
-  //open the folder and search for .so modules
-  while((file = readdir(modDir)))
+  if(allocated)
   {
-    if(file->d_type & DT_REG && strstr(file->d_name, ".so"))
+    Job_t *j = bench.jobs;
+    for(m = 0; m < bench.moduleCount; m++)
     {
-      //found a module, so lets try opening it
-      char *fullPath = malloc(strlen(file->d_name) + strlen(moduleFolder) + 1);
-      /*
-      fullPath[0] = '.';
-      fullPath[1] = '/';
-      fullPath[2] = 0;*/
-      fullPath[0] = 0;
-      strcpy(fullPath, moduleFolder);
-      strcat(fullPath, file->d_name);
-      libHandle = dlopen(fullPath, RTLD_LAZY);
-      if(!libHandle)
-      {
-        fprintf(stderr, "Loading \"%s\" failed!(%s)\n", fullPath, dlerror());
-        free(fullPath);
-        free(randomNumbers);
-        free(sortedNumbers);
-        continue;
-      }
-      free(fullPath);
-
-      sortNameFn = (getSortNameFn_t)dlsym(libHandle, "getSortName");
-      if(!sortNameFn)
-      {
-        dlclose(libHandle);
-        continue;
-      }
-
-      sortSymbolFn = (getSortSymbolFn_t)dlsym(libHandle, "getSortSymbol");
-      if(!sortSymbolFn)
-      {
-        fprintf(stderr, "Can't find procedure!(%s)\n", dlerror());
-        sortNameFn = 0;
-        dlclose(libHandle);
-        continue;
-      }
-
-      sortFn = (sortFn_t)dlsym(libHandle, sortSymbolFn());
-      if(!sortFn)
-      {
-        fprintf(stderr, "Can't find sort procedure!(%s)\n", dlerror());
-        sortNameFn = 0;
-        sortSymbolFn = 0;
-        dlclose(libHandle);
-        continue;
-      }
-
-      pTotalSwaps = dlsym(libHandle, "totalSwaps");
-      if(profileSwaps0 && pTotalSwaps)
-      {
-        printf("Profiling swaps.\n");
-        profileSwaps = 1;
-      }
-      else
-      {
-        profileSwaps = 0;
-      }
-
-      printf("Testing %s\n", sortNameFn());
-      printf("Pre-Sorted:\n");
-      printf("%10s %10s %10s %10s %12s %10s\n", "Values", "Compares", "Swaps", "Allocs", "Time", "Validity");
-
-      FILE* plotData = 0;
-
-      if(outputPlotData)
-      {
-        snprintf(plotDataName, 127, "%s_sorted_%s.gpd", sortNameFn(), timeDate);
-        snprintf(strtmp, 127, "%s/%s", plotFolder, plotDataName);
-        plotData = fopen(strtmp, "w");
-      }
-
-      for(i = 0; i < runs; i++)
-      {
-        sortSize = calculateSortSize(sortSize0, i+1, runSortSizeGrowthRate, runSortSizeGrowthType);
-        testIntegerSorting(sortFn, sortedNumbers, sortSize, plotData);
-        //memcpy(sortedNumbers, sortedNumbers0, sizeof(int)*sortSize); //reset the sorted parts for the next run
-      }
-
-      if(outputPlotData)
+      int firstOfModule = 1;
+      for(k = 0; k < keyTypeCount; k++)
       {
-        fclose(plotData);
-        fprintf(pPlotFile, "\"%s\" u 1:2 t \"%s Time Sorted\" w points, ", plotDataName, sortNameFn());
-        fprintf(pPlotFileComp, "\"%s\" u 1:3 t \"%s Comparisons Sorted\" w points,", plotDataName, sortNameFn());
-        if(profileMemory && pPlotFileMem) fprintf(pPlotFileMem, "\"%s\" u 1:5 t \"%s Sorted\" w points, ", plotDataName, sortNameFn());
-        if(profileSwaps && pPlotFileSwap)  fprintf(pPlotFileSwap, "\"%s\" u 1:4 t \"%s Sorted\" w points, ", plotDataName, sortNameFn());
+        if(!moduleSupports(&bench.modules[m], &keyTypes[k])) continue;
+        for(d = 0; d < generatorCount; d++)
+        {
+          //one series per thread count for parallel modules during a thread sweep
+          unsigned t, threads = sweptThreads(&bench.modules[m]);
+          for(t = threads?1:sortThreads; t <= (threads?threads:sortThreads); t++)
+          {
+            for(i = 0; i < runs; i++, j++)
+            {
+              j->firstOfModule = firstOfModule;
+              firstOfModule = 0;
+              j->module = m;
+              j->type = k;
+              j->generator = d;
+              j->n = sizes[k * runs + i];
+              j->threads = t;
+              j->first = (i == 0);
+              j->last = (i == runs - 1);
+            }
+          }
+        }
       }
+    }
+    bench.jobCount = j - bench.jobs;
 
-      printf("Random:\n");
-      printf("%10s %10s %10s %10s %12s %10s\n", "Values", "Compares", "Swaps", "Allocs", "Time", "Validity");
-
-      if(outputPlotData)
-      {
-        snprintf(plotDataName, 127, "%s_random_%s.gpd", sortNameFn(), timeDate);
-        snprintf(strtmp, 127, "%s/%s", plotFolder, plotDataName);
-        plotData = fopen(strtmp, "w");
-      }
+    //concurrent jobs generate their inputs on their own core only
+    if(workers > 1) bench.genThreads = 1;
 
-      for(i = 0; i < runs; i++)
+    if(workers > 1 || cpuCount)
+    {
+      //without known cpus, e.g. if the affinity mask couldn't be read, the workers run unpinned
+      if(cpuCount)
       {
-        sortSize = calculateSortSize(sortSize0, i+1, runSortSizeGrowthRate, runSortSizeGrowthType);
-        //*totalSwaps = 0;
-        testIntegerSorting(sortFn, randomNumbers, sortSize, plotData);
-        //printf("%llu\n", *totalSwaps);
-        //memcpy(randomNumbers, randomNumbers0, sizeof(int)*sortSize); //reset the sorted parts for the next run
+        printf("Workers: %u on cpus", workers);
+        for(i = 0; i < workers; i++) printf(" %d", cpus[i]);
+        printf("\n");
       }
-
-      if(outputPlotData)
+      else printf("Workers: %u unpinned\n", workers);
+      if(sch_run(bench.jobCount, cpuCount?cpus:0, workers, runJob, jobDone, &bench)) allocated = 0;
+    }
+    else
+    {
+      for(i = 0; i < bench.jobCount; i++)
       {
-        fclose(plotData);
-        fprintf(pPlotFile, "\"%s\" u 1:2 t \"%s Time Random\" w points, ", plotDataName, sortNameFn());
-        fprintf(pPlotFileComp, "\"%s\" u 1:3 t \"%s Comparisons Random\" w points,", plotDataName, sortNameFn());
-        if(profileMemory && pPlotFileMem) fprintf(pPlotFileMem, "\"%s\" u 1:5 t \"%s Random\" w points, ", plotDataName, sortNameFn());
-        if(profileSwaps && pPlotFileSwap)  fprintf(pPlotFileSwap, "\"%s\" u 1:4 t \"%s Random\" w points, ", plotDataName, sortNameFn());
+        runJob(i, 0, &bench);
+        jobDone(i, &bench);
       }
-
-      dlclose(libHandle);
-      sortFn = 0;
-      sortNameFn = 0;
-      sortSymbolFn = 0;
-      pTotalSwaps = 0;
     }
   }
-  closedir(modDir);
-  if(outputPlotData)
+
+  if(!allocated) perror("Couldn't allocate input arrays!");
+  else if(threadSweep) reportScaling(&bench);
+
+  closePlots(&bench);
+  for(i = 0; i < workers && bench.keys && bench.data && bench.shared && bench.keyFiles && bench.dataFiles && bench.outFiles; i++)
   {
-    fclose(pPlotFile);
-    fclose(pPlotFileComp);
-    if(profileMemory) fclose(pPlotFileMem);
-    if(profileSwaps0)  fclose(pPlotFileSwap);
+    freeBuffer(bench.keys[i], siz_multiply(maxSortSize, sizeof(int64_t)), externalPath(strtmp, sizeof(strtmp), "keys", i, timeDate), bench.keyFiles[i], workerCpu(cpus, cpuCount, i));
+    freeBuffer(bench.data[i], siz_multiply(maxSortSize, maxTypeSize), externalPath(strtmp, sizeof(strtmp), "input", i, timeDate), bench.dataFiles[i], workerCpu(cpus, cpuCount, i));
+    freeBuffer(bench.shared[i], sizeof(Result_t), 0, -1, -1);
+    if(externalPath(strtmp, sizeof(strtmp), "output", i, timeDate) && bench.outFiles[i] >= 0)
+    {
+      close(bench.outFiles[i]);
+      unlink(strtmp);
+    }
   }
-  
-  free(moduleFolder);
-  free(randomNumbers);
-  //free(randomNumbers0);
-  free(sortedNumbers);
-  //free(sortedNumbers0);
-
-  return 0;
+  free(bench.keyFiles);
+  free(bench.dataFiles);
+  free(bench.outFiles);
+  free(bench.keys);
+  free(bench.data);
+  free(bench.shared);
+  free(bench.seriesTimedOut);
+  free(bench.jobs);
+  free(sizes);
+  unloadModules(bench.modules, bench.moduleCount);
+  free(generators);
+  free(keyTypes);
+
+  return allocated?0:1;
 }
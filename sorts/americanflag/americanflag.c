@@ -0,0 +1,148 @@
+/**
+ * @file americanflag.c
+ * @author Roy Freytag
+ *
+ * in-place MSD radix sort(American flag sort) with 8 bit digits.
+ *
+ * Every level counts the digits of its range, then permutes the elements into their buckets in place
+ * by swapping each one into the next free slot of its bucket. Levels whose digit is the same for all elements
+ * go straight to the next digit, small ranges get finished with insertion sort.
+ * It needs no scratch memory besides the counts on the stack and isn't stable.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../radixkeys.h"
+#include "americanflag.h"
+
+#define DIGIT_BITS 8 ///< bits per digit
+#define BUCKETS (1 << DIGIT_BITS) ///< buckets per level
+#define INSERTION_THRESHOLD 32 ///< ranges up to this size get insertion sorted
+#define MAX_ELEMENT 256 ///< largest element size swapped through the stack, larger ones use a heap buffer
+
+/**
+ * @brief defines flagNAME(), sorting elements of size bytes by the key of type NAME at offset.
+ *
+ * tmp has to hold one element.
+ */
+#define AMERICAN_FLAG(NAME, SORT_KEY, UKEY, KEYFN) \
+  static void insertion##NAME(char *data, size_t n, size_t size, size_t offset, char *tmp) \
+  { \
+    size_t i, j; \
+    for(i = 1; i < n; i++) \
+    { \
+      UKEY k = KEYFN(data + i * size + offset); \
+      for(j = i; j > 0 && KEYFN(data + (j - 1) * size + offset) > k; j--); \
+      if(j == i) continue; \
+      memcpy(tmp, data + i * size, size); \
+      memmove(data + (j + 1) * size, data + j * size, (i - j) * size); \
+      memcpy(data + j * size, tmp, size); \
+    } \
+  } \
+  static void flag##NAME(char *data, size_t n, size_t size, size_t offset, int shift, char *tmp) \
+  { \
+    size_t counts[BUCKETS], heads[BUCKETS], tails[BUCKETS]; \
+    size_t i; \
+    int b; \
+    for(;;) \
+    { \
+      if(n <= INSERTION_THRESHOLD) \
+      { \
+        insertion##NAME(data, n, size, offset, tmp); \
+        return; \
+      } \
+      memset(counts, 0, sizeof(counts)); \
+      for(i = 0; i < n; i++) counts[(KEYFN(data + i * size + offset) >> shift) & (BUCKETS - 1)]++; \
+      if(counts[(KEYFN(data + offset) >> shift) & (BUCKETS - 1)] < n) break; \
+      if(shift == 0) return; /*all keys equal*/ \
+      shift -= DIGIT_BITS; /*trivial digit*/ \
+    } \
+    size_t sum = 0; \
+    for(b = 0; b < BUCKETS; b++) \
+    { \
+      heads[b] = sum; \
+      sum += counts[b]; \
+      tails[b] = sum; \
+    } \
+    for(b = 0; b < BUCKETS; b++) \
+    { \
+      while(heads[b] < tails[b]) \
+      { \
+        char *e = data + heads[b] * size; \
+        int d = (KEYFN(e + offset) >> shift) & (BUCKETS - 1); \
+        if(d == b) \
+        { \
+          heads[b]++; \
+          continue; \
+        } \
+        char *o = data + heads[d]++ * size; \
+        memcpy(tmp, e, size); \
+        memcpy(e, o, size); \
+        memcpy(o, tmp, size); \
+      } \
+    } \
+    if(shift == 0) return; \
+    size_t start = 0; \
+    for(b = 0; b < BUCKETS; b++) \
+    { \
+      if(counts[b] > 1) flag##NAME(data + start * size, counts[b], size, offset, shift - DIGIT_BITS, tmp); \
+      start += counts[b]; \
+    } \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    UKEY tmp; \
+    if(!data || n < 2) return; \
+    flag##NAME(data, n, sizeof(UKEY), 0, sizeof(UKEY) * 8 - DIGIT_BITS, (char*)&tmp); \
+  }
+
+RADIX_KEY_TYPES(AMERICAN_FLAG)
+
+/**
+ * @brief context-taking entry, sorts any elements with a supported key at some offset, e.g. records.
+ *
+ * Without a key type, e.g. for the killer input, it falls back to qsort_r().
+ */
+void americanFlagSortCtx(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  char stackTmp[MAX_ELEMENT];
+  char *tmp = (size <= MAX_ELEMENT)?stackTmp:malloc(size);
+  if(!tmp) return;
+  switch(ctx->keyType)
+  {
+#define FLAG_CASE(NAME, SORT_KEY, UKEY, KEYFN) \
+    case SORT_KEY: \
+      flag##NAME(data, n, size, ctx->keyOffset, sizeof(UKEY) * 8 - DIGIT_BITS, tmp); \
+      break;
+    RADIX_KEY_TYPES(FLAG_CASE)
+    default:
+      qsort_r(data, n, size, ctx->compare, ctx->compareArg);
+  }
+  if(tmp != stackTmp) free(tmp);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  RADIX_KEY_MASK,
+  1,
+  "americanFlagSortCtx"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "American Flag Radix";
+}
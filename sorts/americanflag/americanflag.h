@@ -0,0 +1,16 @@
+#ifndef __AMERICANFLAG_H_
+#define __AMERICANFLAG_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void americanFlagSortCtx(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+//type-specialized entries
+void sort_i32(void *data, size_t n);
+void sort_i64(void *data, size_t n);
+void sort_u64(void *data, size_t n);
+void sort_f32(void *data, size_t n);
+void sort_f64(void *data, size_t n);
+
+#endif /* __AMERICANFLAG_H_ */
@@ -0,0 +1,251 @@
+/**
+ * @file blockpartition.h
+ * @author Roy Freytag
+ *
+ * block partitioning(Edelkamp and Weiß, "BlockQuicksort: Avoiding Branch Mispredictions in Quicksort").
+ *
+ * Instead of swapping as soon as both scans found a misplaced element, the scans compare a whole block of
+ * BLOCK_SIZE elements on either side first and store the offsets of the misplaced ones. Storing an offset and
+ * advancing the count by the result of the comparison needs no branch, so there is nothing to mispredict.
+ * Afterwards the stored elements get swapped pairwise, until one of the blocks is used up.
+ *
+ * blockPartition() is the generic version for any element size, BLOCK_PARTITION(NAME, TYPE) defines
+ * NAME##BlockPartition() for arrays of a numeric type. Both partition the range around the pivot at its front:
+ * elements less than the pivot go left of it, the others right. The remaining range is handled like pdqsort does.
+ */
+#ifndef __BLOCKPARTITION_H__
+#define __BLOCKPARTITION_H__
+
+#include <stdlib.h>
+#include "helpers.h"
+
+#define BLOCK_SIZE 64 ///< elements per block, the offsets have to fit into an unsigned char
+
+/**
+ * @brief partitions [0, n) around the pivot at a[0].
+ * @param already set to 1 if the range was partitioned already, no element had to move.
+ * @return index of the pivot afterwards.
+ */
+static inline size_t blockPartition(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap, int *already)
+{
+  unsigned char offsetsL[BLOCK_SIZE], offsetsR[BLOCK_SIZE];
+  size_t numL = 0, numR = 0, startL = 0, startR = 0, num, i;
+  size_t first = 1, last = n; //[first, last) isn't partitioned yet
+  const char *pivot = a;
+
+  while(first < last && cmp(a + first * size, pivot, arg) < 0) first++;
+  while(last > first && cmp(a + (last - 1) * size, pivot, arg) >= 0) last--;
+  *already = first >= last;
+  if(!*already)
+  {
+    swap(a + first * size, a + (last - 1) * size, size);
+    first++;
+    last--;
+  }
+
+  while(last - first > 2 * BLOCK_SIZE)
+  {
+    if(!numL)
+    {
+      startL = 0;
+      for(i = 0; i < BLOCK_SIZE; i++)
+      {
+        offsetsL[numL] = i;
+        numL += cmp(a + (first + i) * size, pivot, arg) >= 0;
+      }
+    }
+    if(!numR)
+    {
+      startR = 0;
+      for(i = 0; i < BLOCK_SIZE; i++)
+      {
+        offsetsR[numR] = i;
+        numR += cmp(a + (last - 1 - i) * size, pivot, arg) < 0;
+      }
+    }
+    num = (numL < numR)?numL:numR;
+    for(i = 0; i < num; i++) swap(a + (first + offsetsL[startL + i]) * size, a + (last - 1 - offsetsR[startR + i]) * size, size);
+    numL -= num;
+    numR -= num;
+    startL += num;
+    startR += num;
+    if(!numL) first += BLOCK_SIZE;
+    if(!numR) last -= BLOCK_SIZE;
+  }
+
+  //at most one block is left over, the rest gets split into blocks of fitting size
+  size_t sizeL, sizeR;
+  size_t unknown = last - first - ((numL || numR)?BLOCK_SIZE:0);
+  if(numR)
+  {
+    sizeL = unknown;
+    sizeR = BLOCK_SIZE;
+  }
+  else if(numL)
+  {
+    sizeL = BLOCK_SIZE;
+    sizeR = unknown;
+  }
+  else
+  {
+    sizeL = unknown / 2;
+    sizeR = unknown - sizeL;
+  }
+  if(unknown && !numL)
+  {
+    startL = 0;
+    for(i = 0; i < sizeL; i++)
+    {
+      offsetsL[numL] = i;
+      numL += cmp(a + (first + i) * size, pivot, arg) >= 0;
+    }
+  }
+  if(unknown && !numR)
+  {
+    startR = 0;
+    for(i = 0; i < sizeR; i++)
+    {
+      offsetsR[numR] = i;
+      numR += cmp(a + (last - 1 - i) * size, pivot, arg) < 0;
+    }
+  }
+  num = (numL < numR)?numL:numR;
+  for(i = 0; i < num; i++) swap(a + (first + offsetsL[startL + i]) * size, a + (last - 1 - offsetsR[startR + i]) * size, size);
+  numL -= num;
+  numR -= num;
+  startL += num;
+  startR += num;
+  if(!numL) first += sizeL;
+  if(!numR) last -= sizeR;
+
+  //the misplaced elements of the last block go to the other end of it
+  if(numL)
+  {
+    while(numL--) swap(a + (first + offsetsL[startL + numL]) * size, a + --last * size, size);
+    first = last;
+  }
+  if(numR)
+  {
+    while(numR--) swap(a + (last - 1 - offsetsR[startR + numR]) * size, a + first++ * size, size);
+  }
+
+  swap(a, a + (first - 1) * size, size);
+  return first - 1;
+}
+
+/**
+ * @brief defines NAME##BlockPartition(TYPE *a, size_t n, int *already), the same as blockPartition() with the comparison inlined.
+ */
+#define BLOCK_PARTITION(NAME, TYPE) \
+  static inline void NAME##BlockSwap(TYPE *x, TYPE *y) \
+  { \
+    TYPE tmp = *x; \
+    COUNT_SWAP(); \
+    *x = *y; \
+    *y = tmp; \
+  } \
+  static inline size_t NAME##BlockPartition(TYPE *a, size_t n, int *already) \
+  { \
+    unsigned char offsetsL[BLOCK_SIZE], offsetsR[BLOCK_SIZE]; \
+    size_t numL = 0, numR = 0, startL = 0, startR = 0, num, i; \
+    size_t first = 1, last = n; \
+    TYPE pivot = a[0]; \
+    while(first < last && (COUNT_COMPARE(), a[first] < pivot)) first++; \
+    while(last > first && (COUNT_COMPARE(), !(a[last - 1] < pivot))) last--; \
+    *already = first >= last; \
+    if(!*already) \
+    { \
+      NAME##BlockSwap(a + first, a + last - 1); \
+      first++; \
+      last--; \
+    } \
+    while(last - first > 2 * BLOCK_SIZE) \
+    { \
+      if(!numL) \
+      { \
+        startL = 0; \
+        for(i = 0; i < BLOCK_SIZE; i++) \
+        { \
+          COUNT_COMPARE(); \
+          offsetsL[numL] = i; \
+          numL += !(a[first + i] < pivot); \
+        } \
+      } \
+      if(!numR) \
+      { \
+        startR = 0; \
+        for(i = 0; i < BLOCK_SIZE; i++) \
+        { \
+          COUNT_COMPARE(); \
+          offsetsR[numR] = i; \
+          numR += a[last - 1 - i] < pivot; \
+        } \
+      } \
+      num = (numL < numR)?numL:numR; \
+      for(i = 0; i < num; i++) NAME##BlockSwap(a + first + offsetsL[startL + i], a + last - 1 - offsetsR[startR + i]); \
+      numL -= num; \
+      numR -= num; \
+      startL += num; \
+      startR += num; \
+      if(!numL) first += BLOCK_SIZE; \
+      if(!numR) last -= BLOCK_SIZE; \
+    } \
+    size_t sizeL, sizeR; \
+    size_t unknown = last - first - ((numL || numR)?BLOCK_SIZE:0); \
+    if(numR) \
+    { \
+      sizeL = unknown; \
+      sizeR = BLOCK_SIZE; \
+    } \
+    else if(numL) \
+    { \
+      sizeL = BLOCK_SIZE; \
+      sizeR = unknown; \
+    } \
+    else \
+    { \
+      sizeL = unknown / 2; \
+      sizeR = unknown - sizeL; \
+    } \
+    if(unknown && !numL) \
+    { \
+      startL = 0; \
+      for(i = 0; i < sizeL; i++) \
+      { \
+        COUNT_COMPARE(); \
+        offsetsL[numL] = i; \
+        numL += !(a[first + i] < pivot); \
+      } \
+    } \
+    if(unknown && !numR) \
+    { \
+      startR = 0; \
+      for(i = 0; i < sizeR; i++) \
+      { \
+        COUNT_COMPARE(); \
+        offsetsR[numR] = i; \
+        numR += a[last - 1 - i] < pivot; \
+      } \
+    } \
+    num = (numL < numR)?numL:numR; \
+    for(i = 0; i < num; i++) NAME##BlockSwap(a + first + offsetsL[startL + i], a + last - 1 - offsetsR[startR + i]); \
+    numL -= num; \
+    numR -= num; \
+    startL += num; \
+    startR += num; \
+    if(!numL) first += sizeL; \
+    if(!numR) last -= sizeR; \
+    if(numL) \
+    { \
+      while(numL--) NAME##BlockSwap(a + first + offsetsL[startL + numL], a + --last); \
+      first = last; \
+    } \
+    if(numR) \
+    { \
+      while(numR--) NAME##BlockSwap(a + last - 1 - offsetsR[startR + numR], a + first++); \
+    } \
+    NAME##BlockSwap(a, a + first - 1); \
+    return first - 1; \
+  }
+
+#endif
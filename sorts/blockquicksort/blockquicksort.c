@@ -0,0 +1,253 @@
+/**
+ * @file blockquicksort.c
+ * @author Roy Freytag
+ *
+ * BlockQuicksort(Edelkamp and Weiß, "BlockQuicksort: Avoiding Branch Mispredictions in Quicksort").
+ *
+ * An introsort partitioning with blockPartition(), so the partitioning has no branches depending on the comparisons.
+ * Pivots are the median of three, or the ninther of elements spread over larger ranges.
+ * As all elements equal to the pivot end up right of it, an unbalanced partitioning triggers the duplicate check of the paper:
+ * the right part gets scanned for elements equal to the pivot, which are moved next to it and left out of the recursion. The scan stops as soon as less than a quarter
+ * of the scanned elements were equal. Ranges recursing deeper than 2 log n get heapsorted.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../introsort.h"
+#include "../blockpartition.h"
+#include "blockquicksort.h"
+
+#define NINTHER_THRESHOLD 128 ///< ranges above this size take the pivot as median of three medians of three(ninther)
+#define DUPLICATE_SLACK 16 ///< scanned elements the duplicate check allows before requiring a quarter of them to be equal
+
+/**
+ * @brief 1 if the element at x is less than the one at y.
+ */
+static inline int less(SortContext_t *ctx, const char *x, const char *y)
+{
+  return ctx->compare(x, y, ctx->compareArg) < 0;
+}
+
+/**
+ * @brief sorts the elements at a, b and c.
+ */
+static void sort3(char *a, char *b, char *c, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  if(less(ctx, b, a)) swap(a, b, size);
+  if(less(ctx, c, b))
+  {
+    swap(b, c, size);
+    if(less(ctx, b, a)) swap(a, b, size);
+  }
+}
+
+/**
+ * @brief moves the elements equal to the pivot at a[pos] right next to it, see the file description.
+ * @return index after the last element equal to the pivot.
+ */
+static size_t gatherDuplicates(char *a, size_t n, size_t pos, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  size_t i, eq = pos + 1;
+  for(i = pos + 1; i < n && i - pos <= 4 * (eq - pos) + DUPLICATE_SLACK; i++)
+  {
+    //the right part holds no element less than the pivot
+    if(!less(ctx, a + pos * size, a + i * size))
+    {
+      if(i != eq) swap(a + eq * size, a + i * size, size);
+      eq++;
+    }
+  }
+  return eq;
+}
+
+/**
+ * @brief introsort, recursing into the smaller part and looping on the larger one, so the stack stays at O(log n).
+ */
+static void blockIntroSort(char *a, size_t n, size_t size, SortContext_t *ctx, swapFn_t swap, unsigned depth)
+{
+  while(n > INTRO_INSERTION)
+  {
+    if(!depth--)
+    {
+      introHeapSort(a, n, size, ctx->compare, ctx->compareArg, swap);
+      return;
+    }
+
+    char *m = a + (n / 2) * size, *z = a + (n - 1) * size;
+    if(n > NINTHER_THRESHOLD)
+    {
+      size_t e = (n / 8) * size;
+      sort3(a, a + e, a + 2 * e, size, ctx, swap);
+      sort3(m - e, m, m + e, size, ctx, swap);
+      sort3(z - 2 * e, z - e, z, size, ctx, swap);
+      sort3(a + e, m, z - e, size, ctx, swap);
+    }
+    else sort3(a, m, z, size, ctx, swap);
+    swap(a, m, size);
+
+    int already;
+    size_t lo = blockPartition(a, n, size, ctx->compare, ctx->compareArg, swap, &already);
+    size_t hi = (lo < n / 8)?gatherDuplicates(a, n, lo, size, ctx, swap):lo + 1; //the parts left to sort are [0, lo) and [hi, n)
+
+    if(lo < n - hi)
+    {
+      blockIntroSort(a, lo, size, ctx, swap, depth);
+      a += hi * size;
+      n -= hi;
+    }
+    else
+    {
+      blockIntroSort(a + hi * size, n - hi, size, ctx, swap, depth);
+      n = lo;
+    }
+  }
+  introInsertion(a, n, size, ctx->compare, ctx->compareArg, swap);
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void blockQuickSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  blockIntroSort(data, n, size, ctx, pswapSelect(data, size), introDepthLimit(n));
+}
+
+/**
+ * @brief defines the type-specialized entry sort_NAME, the same BlockQuicksort with the comparison inlined.
+ */
+#define BLOCKQUICKSORT_TYPED(NAME, TYPE) \
+  BLOCK_PARTITION(NAME, TYPE) \
+  static inline int NAME##Less(TYPE x, TYPE y) \
+  { \
+    COUNT_COMPARE(); \
+    return x < y; \
+  } \
+  static inline void NAME##Sort3(TYPE *x, TYPE *y, TYPE *z) \
+  { \
+    if(NAME##Less(*y, *x)) NAME##BlockSwap(x, y); \
+    if(NAME##Less(*z, *y)) \
+    { \
+      NAME##BlockSwap(y, z); \
+      if(NAME##Less(*y, *x)) NAME##BlockSwap(x, y); \
+    } \
+  } \
+  static void NAME##Insertion(TYPE *a, size_t n) \
+  { \
+    size_t i, j; \
+    for(i = 1; i < n; i++) \
+    { \
+      TYPE v = a[i]; \
+      for(j = i; j > 0 && NAME##Less(v, a[j - 1]); j--) \
+      { \
+        COUNT_SWAP(); \
+        a[j] = a[j - 1]; \
+      } \
+      a[j] = v; \
+    } \
+  } \
+  static void NAME##SiftDown(TYPE *a, size_t root, size_t n) \
+  { \
+    size_t child; \
+    while((child = 2 * root + 1) < n) \
+    { \
+      if(child + 1 < n && NAME##Less(a[child], a[child + 1])) child++; \
+      if(!NAME##Less(a[root], a[child])) return; \
+      NAME##BlockSwap(a + root, a + child); \
+      root = child; \
+    } \
+  } \
+  static void NAME##HeapSort(TYPE *a, size_t n) \
+  { \
+    size_t i; \
+    for(i = n / 2; i > 0; i--) NAME##SiftDown(a, i - 1, n); \
+    for(i = n - 1; i > 0; i--) \
+    { \
+      NAME##BlockSwap(a, a + i); \
+      NAME##SiftDown(a, 0, i); \
+    } \
+  } \
+  static void NAME##IntroSort(TYPE *a, size_t n, unsigned depth) \
+  { \
+    while(n > INTRO_INSERTION) \
+    { \
+      if(!depth--) \
+      { \
+        NAME##HeapSort(a, n); \
+        return; \
+      } \
+      size_t m = n / 2, e = n / 8; \
+      if(n > NINTHER_THRESHOLD) \
+      { \
+        NAME##Sort3(a, a + e, a + 2 * e); \
+        NAME##Sort3(a + m - e, a + m, a + m + e); \
+        NAME##Sort3(a + n - 1 - 2 * e, a + n - 1 - e, a + n - 1); \
+        NAME##Sort3(a + e, a + m, a + n - 1 - e); \
+      } \
+      else NAME##Sort3(a, a + m, a + n - 1); \
+      NAME##BlockSwap(a, a + m); \
+      int already; \
+      size_t lo = NAME##BlockPartition(a, n, &already), hi = lo + 1, i; \
+      if(lo < n / 8) \
+      { \
+        for(i = lo + 1; i < n && i - lo <= 4 * (hi - lo) + DUPLICATE_SLACK; i++) \
+        { \
+          if(!NAME##Less(a[lo], a[i])) \
+          { \
+            if(i != hi) NAME##BlockSwap(a + hi, a + i); \
+            hi++; \
+          } \
+        } \
+      } \
+      if(lo < n - hi) \
+      { \
+        NAME##IntroSort(a, lo, depth); \
+        a += hi; \
+        n -= hi; \
+      } \
+      else \
+      { \
+        NAME##IntroSort(a + hi, n - hi, depth); \
+        n = lo; \
+      } \
+    } \
+    NAME##Insertion(a, n); \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    NAME##IntroSort(data, n, introDepthLimit(n)); \
+  }
+
+BLOCKQUICKSORT_TYPED(i32, int32_t)
+BLOCKQUICKSORT_TYPED(i64, int64_t)
+BLOCKQUICKSORT_TYPED(u64, uint64_t)
+BLOCKQUICKSORT_TYPED(f32, float)
+BLOCKQUICKSORT_TYPED(f64, double)
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "blockQuickSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "BlockQuicksort";
+}
@@ -11,13 +11,14 @@ void sort(void *data, size_t n, size_t s, int (*fcomp)(void*, void*))
   if(n == 0) return;
 
   size_t i, j;
+  swapFn_t swap = pswapSelect(data, s);
   for(i = 0; i < n-1; i++)
   {
     for(j = i+1; j < n; j++)
     {
       if(fcomp(voidAdd(data, i, s), voidAdd(data, j, s)) > 0)
       {
-        pswap(voidAdd(data, i, s), voidAdd(data, j, s), s);
+        swap(voidAdd(data, i, s), voidAdd(data, j, s), s);
       }
     }
   }
@@ -0,0 +1,400 @@
+/**
+ * @file externalsort.c
+ * @author Roy Freytag
+ *
+ * external merge sort for files larger than the memory.
+ *
+ * Run generation reads chunks of half the memory budget, sorts them with a stable bottom-up merge sort using the other
+ * half as merge buffer and writes them one after another into a temporary file. The runs then get merged k at a time,
+ * every run and the output get an equal share of the memory as buffer, so all reads and writes are large and sequential.
+ * k is as large as possible while the buffers stay at least MIN_BLOCK bytes, so most inputs need a single merge pass.
+ * The merges pick the smallest head of the runs with a loser tree, which needs log2(k) comparisons per element.
+ * Ties go to the run with the lower index, so the sort is stable.
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../gallopmerge.h"
+#include "externalsort.h"
+
+#define MIN_BLOCK (1 << 20) ///< smallest buffer per run of a merge in bytes, smaller ones make the I/O too short to stream
+#define MIN_ELEMENTS 64 ///< smallest memory budget in elements, smaller ones get raised to it
+
+/**
+ * a run being merged
+ */
+typedef struct
+{
+  char *buffer; ///< buffered part of the run
+  size_t pos; ///< index of the head in buffer
+  size_t len; ///< elements in buffer, pos == len means the run is exhausted
+  off_t next; ///< file offset of the first element not yet buffered
+  off_t end; ///< file offset behind the run
+} Stream_t;
+
+/**
+ * state of a k-way merge
+ */
+typedef struct
+{
+  size_t size; ///< element size
+  int (*cmp)(const void*, const void*, void*); ///< comparison function
+  void *arg; ///< argument for cmp
+  int in; ///< file holding the runs
+  Stream_t *streams; ///< the runs
+  size_t *tree; ///< losers of the internal nodes 1..k - 1, tree[0] is the winner
+  size_t k; ///< number of runs
+  size_t block; ///< buffer size in elements
+} Merge_t;
+
+/**
+ * @brief reads from a file until all bytes are read.
+ * @return 0 on success, -1 on errors or a premature end of the file.
+ */
+static int readFull(int fd, void *buffer, size_t bytes, off_t offset)
+{
+  char *p = buffer;
+  while(bytes)
+  {
+    ssize_t r = pread(fd, p, bytes, offset);
+    if(r < 0 && errno == EINTR) continue;
+    if(r <= 0) return -1;
+    p += r;
+    bytes -= r;
+    offset += r;
+  }
+  return 0;
+}
+
+/**
+ * @brief writes to a file until all bytes are written.
+ * @return 0 on success, -1 on errors.
+ */
+static int writeFull(int fd, const void *buffer, size_t bytes, off_t offset)
+{
+  const char *p = buffer;
+  while(bytes)
+  {
+    ssize_t w = pwrite(fd, p, bytes, offset);
+    if(w < 0 && errno == EINTR) continue;
+    if(w <= 0) return -1;
+    p += w;
+    bytes -= w;
+    offset += w;
+  }
+  return 0;
+}
+
+/**
+ * @brief creates a temporary file, which is removed as soon as it gets closed.
+ * @return file descriptor, -1 on failure.
+ */
+static int createTemp(const char *dir)
+{
+  char path[4096];
+  snprintf(path, sizeof(path), "%s/externalsortXXXXXX", dir?dir:"/tmp");
+  int fd = mkstemp(path);
+  if(fd >= 0) unlink(path);
+  return fd;
+}
+
+/**
+ * @brief stable bottom-up merge sort of a buffer.
+ *
+ * Blocks of the minimum run length get sorted by binary insertion sort, extending the runs found at their start,
+ * then neighbouring blocks get merged with doubling widths.
+ */
+static void sortBuffer(MergeState_t *ms, char *a, size_t n)
+{
+  size_t size = ms->size, lo, width, minRun = minRunLength(n);
+  for(lo = 0; lo < n; lo += minRun)
+  {
+    size_t len = (n - lo < minRun)?n - lo:minRun;
+    binaryInsertionSort(ms, a + lo * size, len, countRun(ms, a + lo * size, len));
+  }
+  for(width = minRun; width < n; width *= 2)
+  {
+    for(lo = 0; lo + width < n; lo += 2 * width)
+    {
+      size_t nb = (n - lo - width < width)?n - lo - width:width;
+      mergeRuns(ms, a + lo * size, width, nb);
+    }
+  }
+}
+
+/**
+ * @brief context-taking entry, sorts in memory.
+ */
+void externalSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  MergeState_t ms;
+  mergeInit(&ms, data, size, ctx);
+  sortBuffer(&ms, data, n);
+  mergeFree(&ms);
+}
+
+/**
+ * @brief buffers the next block of a run.
+ * @return 0 on success, -1 on read errors.
+ */
+static int refill(Merge_t *mg, Stream_t *s)
+{
+  size_t bytes = mg->block * mg->size;
+  if(s->end - s->next < (off_t)bytes) bytes = s->end - s->next;
+  s->pos = 0;
+  s->len = bytes / mg->size;
+  if(!bytes) return 0;
+  if(readFull(mg->in, s->buffer, bytes, s->next)) return -1;
+  s->next += bytes;
+  return 0;
+}
+
+/**
+ * @brief 1 if the head of run a comes before the one of run b, exhausted runs come last.
+ */
+static inline int streamLess(Merge_t *mg, size_t a, size_t b)
+{
+  Stream_t *x = &mg->streams[a], *y = &mg->streams[b];
+  if(x->pos == x->len) return 0;
+  if(y->pos == y->len) return 1;
+  int c = mg->cmp(x->buffer + x->pos * mg->size, y->buffer + y->pos * mg->size, mg->arg);
+  return c < 0 || (c == 0 && a < b);
+}
+
+/**
+ * @brief plays the initial tournament, the leaf of run i is node k + i.
+ * @param winners buffer of 2k entries for the winners of the nodes.
+ */
+static void treeInit(Merge_t *mg, size_t *winners)
+{
+  size_t i;
+  for(i = 0; i < mg->k; i++) winners[mg->k + i] = i;
+  for(i = mg->k - 1; i >= 1; i--)
+  {
+    size_t a = winners[2 * i], b = winners[2 * i + 1];
+    int aWins = streamLess(mg, a, b);
+    winners[i] = aWins?a:b;
+    mg->tree[i] = aWins?b:a;
+  }
+  mg->tree[0] = winners[1];
+}
+
+/**
+ * @brief replays the matches on the path of a run after its head changed.
+ */
+static inline void treeReplay(Merge_t *mg, size_t run)
+{
+  size_t node = (mg->k + run) / 2;
+  for(; node >= 1; node /= 2)
+  {
+    if(streamLess(mg, mg->tree[node], run))
+    {
+      size_t tmp = mg->tree[node];
+      mg->tree[node] = run;
+      run = tmp;
+    }
+  }
+  mg->tree[0] = run;
+}
+
+/**
+ * @brief merges k adjacent runs of a file into another file.
+ * @param mg merge state, its k and streams have to be set up.
+ * @param bounds file offsets of the runs in elements, k + 1 entries.
+ * @param out file descriptor of the output, the merged run starts at the offset of the first run.
+ * @param buffer output buffer of block elements.
+ * @param winners buffer of 2k entries for treeInit().
+ * @return 0 on success, -1 on I/O errors.
+ */
+static int mergeGroup(Merge_t *mg, const size_t *bounds, int out, char *buffer, size_t *winners)
+{
+  size_t i, size = mg->size, len = 0;
+  off_t offset = (off_t)bounds[0] * size;
+  for(i = 0; i < mg->k; i++)
+  {
+    mg->streams[i].next = (off_t)bounds[i] * size;
+    mg->streams[i].end = (off_t)bounds[i + 1] * size;
+    if(refill(mg, &mg->streams[i])) return -1;
+  }
+  treeInit(mg, winners);
+
+  for(;;)
+  {
+    size_t run = mg->tree[0];
+    Stream_t *s = &mg->streams[run];
+    if(s->pos == s->len) break; //the winner is exhausted, so all are
+    memcpy(buffer + len * size, s->buffer + s->pos * size, size);
+    s->pos++;
+    if(++len == mg->block)
+    {
+      if(writeFull(out, buffer, len * size, offset)) return -1;
+      offset += len * size;
+      len = 0;
+    }
+    if(s->pos == s->len && refill(mg, s)) return -1;
+    treeReplay(mg, run);
+  }
+  return writeFull(out, buffer, len * size, offset);
+}
+
+/**
+ * @brief merges the runs of a file k at a time until a single run is left, the last pass writes into the output.
+ * @param mg merge state with size, cmp and arg set.
+ * @param memory buffer of the memory budget.
+ * @param bounds file offsets of the runs in elements, runs + 1 entries, gets overwritten.
+ * @return 0 on success, -1 on failure.
+ */
+static int mergePasses(Merge_t *mg, SortFiles_t *files, char *memory, size_t bytes, size_t *bounds, size_t runs, int src)
+{
+  size_t i, g, maxK = bytes / MIN_BLOCK;
+  maxK = (maxK > 3)?maxK - 1:2;
+  if(maxK > runs) maxK = runs;
+  mg->streams = malloc(maxK * sizeof(Stream_t));
+  mg->tree = malloc(maxK * sizeof(size_t));
+  size_t *winners = malloc(2 * maxK * sizeof(size_t));
+  int dst = -1, ret = -1;
+  if(!mg->streams || !mg->tree || !winners) goto done;
+
+  while(runs > 1)
+  {
+    size_t k = (runs < maxK)?runs:maxK;
+    int final = (runs <= k);
+    if(!final && dst < 0 && (dst = createTemp(files->tmpDir)) < 0) goto done;
+
+    //the output gets a share as well
+    mg->block = bytes / ((k + 1) * mg->size);
+    if(!mg->block) mg->block = 1;
+    for(i = 0; i < k; i++) mg->streams[i].buffer = memory + i * mg->block * mg->size;
+    char *buffer = memory + k * mg->block * mg->size;
+
+    mg->in = src;
+    posix_fadvise(src, 0, 0, POSIX_FADV_SEQUENTIAL);
+    size_t groups = 0;
+    for(g = 0; g < runs; g += k, groups++)
+    {
+      mg->k = (runs - g < k)?runs - g:k;
+      if(mergeGroup(mg, bounds + g, final?files->out:dst, buffer, winners)) goto done;
+      bounds[groups] = bounds[g];
+    }
+    bounds[groups] = bounds[runs];
+    runs = groups;
+
+    if(!final)
+    {
+      //the merged runs aren't needed anymore, freeing their space keeps the disk usage at twice the input
+      if(ftruncate(src, 0)) goto done;
+      int tmp = src;
+      src = dst;
+      dst = tmp;
+    }
+  }
+  ret = 0;
+
+done:
+  if(dst >= 0) close(dst);
+  close(src);
+  free(mg->streams);
+  free(mg->tree);
+  free(winners);
+  return ret;
+}
+
+/**
+ * @brief external-memory entry, see sortFileFn_t.
+ */
+int sortFile(SortFiles_t *files, size_t n, size_t size, SortContext_t *ctx)
+{
+  size_t bytes = files->memory;
+  if(bytes < MIN_ELEMENTS * size) bytes = MIN_ELEMENTS * size;
+  char *memory = malloc(bytes);
+  size_t *bounds = 0;
+  if(!memory) return -1;
+
+  //half of the memory holds a run, the other half is its merge buffer
+  size_t runElements = bytes / (2 * size);
+  SortContext_t local = *ctx;
+  local.scratch = memory + runElements * size;
+  local.scratchSize = bytes - runElements * size;
+  MergeState_t ms;
+  int ret = -1;
+  mergeInit(&ms, memory, size, &local);
+
+  posix_fadvise(files->in, 0, 0, POSIX_FADV_SEQUENTIAL);
+  if(n <= runElements)
+  {
+    if(readFull(files->in, memory, n * size, 0)) goto done;
+    sortBuffer(&ms, memory, n);
+    ret = writeFull(files->out, memory, n * size, 0);
+    goto done;
+  }
+
+  size_t r, runs = (n + runElements - 1) / runElements;
+  bounds = malloc((runs + 1) * sizeof(size_t));
+  int tmp = createTemp(files->tmpDir);
+  if(!bounds || tmp < 0)
+  {
+    if(tmp >= 0) close(tmp);
+    goto done;
+  }
+  for(r = 0; r < runs; r++)
+  {
+    size_t lo = r * runElements, len = (n - lo < runElements)?n - lo:runElements;
+    bounds[r] = lo;
+    if(readFull(files->in, memory, len * size, (off_t)lo * size))
+    {
+      close(tmp);
+      goto done;
+    }
+    sortBuffer(&ms, memory, len);
+    if(writeFull(tmp, memory, len * size, (off_t)lo * size))
+    {
+      close(tmp);
+      goto done;
+    }
+  }
+  bounds[runs] = n;
+
+  Merge_t mg;
+  mg.size = size;
+  mg.cmp = ctx->compare;
+  mg.arg = ctx->compareArg;
+  ret = mergePasses(&mg, files, memory, bytes, bounds, runs, tmp);
+
+done:
+  mergeFree(&ms);
+  free(bounds);
+  free(memory);
+  return ret;
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_STABLE | SORT_CAP_SCRATCH,
+  0,
+  1,
+  "externalSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "External Mergesort";
+}
@@ -0,0 +1,10 @@
+#ifndef __EXTERNALSORT_H_
+#define __EXTERNALSORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void externalSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+int sortFile(SortFiles_t *files, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __EXTERNALSORT_H_ */
@@ -0,0 +1,134 @@
+/**
+ * @file floydrivest.c
+ * @author Roy Freytag
+ *
+ * Floyd-Rivest selection(Floyd and Rivest, "Algorithm 489: The Algorithm SELECT").
+ *
+ * Ranges of more than SAMPLE_THRESHOLD elements first recursively select k in a sample around it, sized so that the
+ * final k lies between the sample's bounds with high probability. The partition around the element at k then leaves
+ * only a small range, so selection takes n + min(k, n - k) + o(n) comparisons on average, fewer than any quickselect.
+ * The partition exchanges from both ends with the pivot as sentinel at one of them. The context entry sorts by
+ * selecting the median and recursing into both halves.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <math.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../select.h"
+#include "floydrivest.h"
+
+#define SAMPLE_THRESHOLD 600 ///< ranges larger than this get sampled first, the value of the original paper
+
+/**
+ * @brief selects k in the range [left, right] of indices.
+ *
+ * The pivot is partitioned in place: p follows it through the swaps, so no copy of it is needed.
+ */
+static void floydRivest(SelectState_t *ss, char *a, ssize_t left, ssize_t right, ssize_t k)
+{
+  size_t size = ss->size;
+  while(right > left)
+  {
+    if(right - left > SAMPLE_THRESHOLD)
+    {
+      double n = right - left + 1, i = k - left + 1;
+      double z = log(n);
+      double s = 0.5 * exp(2 * z / 3);
+      double sd = 0.5 * sqrt(z * s * (n - s) / n) * ((i < n / 2)?-1:1);
+      ssize_t newLeft = k - (ssize_t)(i * s / n - sd), newRight = k + (ssize_t)((n - i) * s / n + sd);
+      floydRivest(ss, a, (newLeft > left)?newLeft:left, (newRight < right)?newRight:right, k);
+    }
+
+    ssize_t i = left, j = right, p = left;
+    ss->swap(a + left * size, a + k * size, size);
+    if(selectLess(ss, a + left * size, a + right * size))
+    {
+      ss->swap(a + right * size, a + left * size, size);
+      p = right;
+    }
+    while(i < j)
+    {
+      ss->swap(a + i * size, a + j * size, size);
+      if(i == p) p = j;
+      else if(j == p) p = i;
+      i++;
+      j--;
+      while(selectLess(ss, a + i * size, a + p * size)) i++;
+      while(selectLess(ss, a + p * size, a + j * size)) j--;
+    }
+    if(p == left) ss->swap(a + left * size, a + j * size, size);
+    else
+    {
+      j++;
+      ss->swap(a + j * size, a + right * size, size);
+    }
+    if(j <= k) left = j + 1;
+    if(k <= j) right = j - 1;
+  }
+}
+
+/**
+ * @brief sorts a range by selecting its median, recursing into the left half, the larger or equal one, and looping on the right one.
+ */
+static void medianSort(SelectState_t *ss, char *a, size_t n)
+{
+  size_t size = ss->size;
+  while(n > SELECT_INSERTION)
+  {
+    size_t m = n / 2;
+    floydRivest(ss, a, 0, n - 1, m);
+    medianSort(ss, a, m);
+    a += (m + 1) * size;
+    n -= m + 1;
+  }
+  selectInsertion(ss, a, n);
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void floydRivestSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  medianSort(&ss, data, n);
+}
+
+/**
+ * @brief selection entry, see sortSelectFn_t.
+ */
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx)
+{
+  if(!data || k >= n) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  floydRivest(&ss, data, 0, n - 1, k);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "floydRivestSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Floyd-Rivest";
+}
@@ -0,0 +1,10 @@
+#ifndef __FLOYDRIVEST_H_
+#define __FLOYDRIVEST_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void floydRivestSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx);
+
+#endif /* __FLOYDRIVEST_H_ */
@@ -0,0 +1,467 @@
+/**
+ * @file gallopmerge.h
+ * @author Roy Freytag
+ *
+ * run detection and galloping merges for natural merge sorts like TimSort and powersort.
+ *
+ * countRun() finds the run at the start of a range, strictly descending runs get reversed, which keeps the sort stable.
+ * Short runs get extended to a minimum length by binaryInsertionSort(). mergeRuns() merges two adjacent runs:
+ * the parts of both runs that are in place already are cut off by galloping first, then the shorter run is copied
+ * into the merge buffer and merged with the other one. Whenever one run wins often in a row, the merge switches to
+ * galloping(exponential, then binary search) to move whole blocks at once. minGallop adapts to how well that pays off.
+ *
+ * The merge buffer is the scratch buffer of the context if there is one and grows as needed otherwise,
+ * it is reused by all merges of a sort call. If it can't grow, the runs get merged in place by the rotations of
+ * stablemerge.h, and without the buffer of a single element the insertion sort rotates elements into place, so a sort
+ * never has to give up for lack of memory.
+ * All functions keep equal elements in their order.
+ */
+#ifndef __GALLOPMERGE_H__
+#define __GALLOPMERGE_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include "../sorting_lib.h"
+#include "helpers.h"
+#include "stablemerge.h"
+
+#define MIN_GALLOP 7 ///< wins in a row after which a merge starts galloping
+#define MAX_RUNS 85 ///< pending runs the stack of a merge sort can hold, enough for 2^64 elements
+#define MIN_MERGE 64 ///< runs get extended to a length between MIN_MERGE / 2 and MIN_MERGE
+
+/**
+ * state of the merges of a sort call
+ */
+typedef struct
+{
+  size_t size; ///< element size
+  int (*cmp)(const void*, const void*, void*); ///< comparison function
+  void *arg; ///< argument for cmp
+  swapFn_t swap; ///< swap kernel, for in-place merges
+  char *buffer; ///< merge buffer
+  size_t capacity; ///< elements fitting into buffer
+  int owned; ///< 1 if buffer was allocated by mergeReserve() and has to be freed
+  char *one; ///< buffer of a single element for the insertion sort, 0 if it couldn't be allocated
+  size_t minGallop; ///< current number of wins in a row to start galloping
+} MergeState_t;
+
+/**
+ * @brief 1 if the element at x is less than the one at y.
+ */
+static inline int mergeLess(MergeState_t *ms, const char *x, const char *y)
+{
+  return ms->cmp(x, y, ms->arg) < 0;
+}
+
+/**
+ * @brief sets up the state for a sort call, using the scratch buffer of the context if it has one.
+ */
+static inline void mergeInit(MergeState_t *ms, void *data, size_t size, SortContext_t *ctx)
+{
+  ms->size = size;
+  ms->cmp = ctx->compare;
+  ms->arg = ctx->compareArg;
+  ms->swap = pswapSelect(data, size);
+  ms->buffer = ctx->scratch;
+  ms->capacity = ctx->scratch?ctx->scratchSize / size:0;
+  ms->owned = 0;
+  ms->minGallop = MIN_GALLOP;
+  ms->one = malloc(size);
+}
+
+/**
+ * @brief frees the buffers of the state.
+ */
+static inline void mergeFree(MergeState_t *ms)
+{
+  if(ms->owned) free(ms->buffer);
+  free(ms->one);
+}
+
+/**
+ * @brief makes sure the merge buffer holds at least n elements.
+ * @return 0 on success, -1 if it couldn't grow.
+ */
+static inline int mergeReserve(MergeState_t *ms, size_t n)
+{
+  if(n <= ms->capacity) return 0;
+  size_t capacity = ms->capacity * 2;
+  if(capacity < n) capacity = n;
+  char *tmp = ms->owned?realloc(ms->buffer, capacity * ms->size):malloc(capacity * ms->size);
+  if(!tmp) return -1;
+  ms->buffer = tmp;
+  ms->capacity = capacity;
+  ms->owned = 1;
+  return 0;
+}
+
+/**
+ * @brief length of the shortest run a range of n elements gets split into, so the number of runs is a power of 2 or slightly less.
+ */
+static inline size_t minRunLength(size_t n)
+{
+  size_t r = 0;
+  while(n >= MIN_MERGE)
+  {
+    r |= n & 1;
+    n >>= 1;
+  }
+  return n + r;
+}
+
+/**
+ * @brief finds the run at the start of a range.
+ *
+ * A strictly descending run gets reversed, so afterwards the run is ascending.
+ * @return length of the run.
+ */
+static inline size_t countRun(MergeState_t *ms, char *a, size_t n)
+{
+  size_t size = ms->size, i = 1;
+  if(n < 2) return n;
+  if(mergeLess(ms, a + size, a))
+  {
+    for(i = 2; i < n && mergeLess(ms, a + i * size, a + (i - 1) * size); i++);
+    stableReverse(a, i, ms->size, ms->swap);
+  }
+  else
+  {
+    for(i = 2; i < n && !mergeLess(ms, a + i * size, a + (i - 1) * size); i++);
+  }
+  return i;
+}
+
+/**
+ * @brief binary insertion sort of a range whose first sorted elements are sorted already.
+ */
+static inline void binaryInsertionSort(MergeState_t *ms, char *a, size_t n, size_t sorted)
+{
+  size_t size = ms->size, i;
+  for(i = sorted?sorted:1; i < n; i++)
+  {
+    size_t lo = 0, hi = i;
+    while(lo < hi) //the last position the element can go to, so equal elements stay in order
+    {
+      size_t m = lo + (hi - lo) / 2;
+      if(mergeLess(ms, a + i * size, a + m * size)) hi = m;
+      else lo = m + 1;
+    }
+    if(lo == i) continue;
+    if(!ms->one)
+    {
+      stableRotate(a + lo * size, i - lo + 1, i - lo, size, ms->swap);
+      continue;
+    }
+    memcpy(ms->one, a + i * size, size);
+    memmove(a + (lo + 1) * size, a + lo * size, (i - lo) * size);
+    memcpy(a + lo * size, ms->one, size);
+  }
+}
+
+/**
+ * @brief finds the position of key in a sorted range, left of all elements equal to it.
+ *
+ * Searches exponentially from hint first, then binary.
+ * @return k, so a[k - 1] < key <= a[k].
+ */
+static inline size_t gallopLeft(MergeState_t *ms, const char *key, const char *a, size_t n, size_t hint)
+{
+  size_t size = ms->size;
+  ssize_t last = 0, ofs = 1, max;
+  if(mergeLess(ms, a + hint * size, key))
+  {
+    max = n - hint;
+    while(ofs < max && mergeLess(ms, a + (hint + ofs) * size, key))
+    {
+      last = ofs;
+      ofs = (ofs << 1) + 1;
+    }
+    if(ofs > max) ofs = max;
+    last += hint;
+    ofs += hint;
+  }
+  else
+  {
+    max = hint + 1;
+    while(ofs < max && !mergeLess(ms, a + (hint - ofs) * size, key))
+    {
+      last = ofs;
+      ofs = (ofs << 1) + 1;
+    }
+    if(ofs > max) ofs = max;
+    ssize_t k = last;
+    last = hint - ofs;
+    ofs = hint - k;
+  }
+  //a[last] < key <= a[ofs]
+  last++;
+  while(last < ofs)
+  {
+    ssize_t m = last + (ofs - last) / 2;
+    if(mergeLess(ms, a + m * size, key)) last = m + 1;
+    else ofs = m;
+  }
+  return ofs;
+}
+
+/**
+ * @brief finds the position of key in a sorted range, right of all elements equal to it.
+ *
+ * Searches exponentially from hint first, then binary.
+ * @return k, so a[k - 1] <= key < a[k].
+ */
+static inline size_t gallopRight(MergeState_t *ms, const char *key, const char *a, size_t n, size_t hint)
+{
+  size_t size = ms->size;
+  ssize_t last = 0, ofs = 1, max;
+  if(mergeLess(ms, key, a + hint * size))
+  {
+    max = hint + 1;
+    while(ofs < max && mergeLess(ms, key, a + (hint - ofs) * size))
+    {
+      last = ofs;
+      ofs = (ofs << 1) + 1;
+    }
+    if(ofs > max) ofs = max;
+    ssize_t k = last;
+    last = hint - ofs;
+    ofs = hint - k;
+  }
+  else
+  {
+    max = n - hint;
+    while(ofs < max && !mergeLess(ms, key, a + (hint + ofs) * size))
+    {
+      last = ofs;
+      ofs = (ofs << 1) + 1;
+    }
+    if(ofs > max) ofs = max;
+    last += hint;
+    ofs += hint;
+  }
+  //a[last] <= key < a[ofs]
+  last++;
+  while(last < ofs)
+  {
+    ssize_t m = last + (ofs - last) / 2;
+    if(mergeLess(ms, key, a + m * size)) ofs = m;
+    else last = m + 1;
+  }
+  return ofs;
+}
+
+/**
+ * @brief merges the runs a[0, na) and a[na, na + nb) with na <= nb, the left run goes into the merge buffer.
+ *
+ * Expects a[na] < a[0] and a[na - 1] > a[na + nb - 1], as left by mergeRuns().
+ */
+static inline void mergeLo(MergeState_t *ms, char *a, size_t na, size_t nb)
+{
+  size_t size = ms->size, minGallop = ms->minGallop, k;
+  size_t countA, countB;
+  char *buf = ms->buffer;
+  char *pa = buf, *pb = a + na * size, *dest = a;
+
+  memcpy(buf, a, na * size);
+  memcpy(dest, pb, size);
+  dest += size;
+  pb += size;
+  if(!--nb) goto done;
+  if(na == 1) goto lastA;
+
+  for(;;)
+  {
+    countA = countB = 0;
+    //one element at a time, until one run wins often in a row
+    do
+    {
+      if(mergeLess(ms, pb, pa))
+      {
+        memcpy(dest, pb, size);
+        dest += size;
+        pb += size;
+        countB++;
+        countA = 0;
+        if(!--nb) goto done;
+      }
+      else
+      {
+        memcpy(dest, pa, size);
+        dest += size;
+        pa += size;
+        countA++;
+        countB = 0;
+        if(--na == 1) goto lastA;
+      }
+    }
+    while((countA | countB) < minGallop);
+
+    //galloping, as long as it moves enough elements at once
+    minGallop++;
+    do
+    {
+      minGallop -= minGallop > 1;
+      ms->minGallop = minGallop;
+      k = countA = gallopRight(ms, pb, pa, na, 0);
+      if(k)
+      {
+        memcpy(dest, pa, k * size);
+        dest += k * size;
+        pa += k * size;
+        na -= k;
+        if(na == 1) goto lastA;
+        if(!na) goto done; //only possible if the comparison function is inconsistent
+      }
+      memcpy(dest, pb, size);
+      dest += size;
+      pb += size;
+      if(!--nb) goto done;
+
+      k = countB = gallopLeft(ms, pa, pb, nb, 0);
+      if(k)
+      {
+        memmove(dest, pb, k * size);
+        dest += k * size;
+        pb += k * size;
+        nb -= k;
+        if(!nb) goto done;
+      }
+      memcpy(dest, pa, size);
+      dest += size;
+      pa += size;
+      if(--na == 1) goto lastA;
+    }
+    while(countA >= MIN_GALLOP || countB >= MIN_GALLOP);
+    minGallop++; //penalty for leaving galloping mode
+    ms->minGallop = minGallop;
+  }
+
+done:
+  if(na) memcpy(dest, pa, na * size);
+  return;
+
+lastA: //the last element of the left run is the greatest, the rest of the right run goes first
+  memmove(dest, pb, nb * size);
+  memcpy(dest + nb * size, pa, size);
+}
+
+/**
+ * @brief merges the runs a[0, na) and a[na, na + nb) with na > nb, the right run goes into the merge buffer.
+ *
+ * Merges from the end. Expects a[na] < a[0] and a[na - 1] > a[na + nb - 1], as left by mergeRuns().
+ */
+static inline void mergeHi(MergeState_t *ms, char *a, size_t na, size_t nb)
+{
+  size_t size = ms->size, minGallop = ms->minGallop, k;
+  size_t countA, countB;
+  char *buf = ms->buffer;
+  char *dest = a + (na + nb - 1) * size; //next position to fill, from the end
+  char *pa = a + (na - 1) * size, *pb = buf + (nb - 1) * size; //last elements of the runs
+
+  memcpy(buf, a + na * size, nb * size);
+  memcpy(dest, pa, size);
+  dest -= size;
+  pa -= size;
+  if(!--na) goto done;
+  if(nb == 1) goto firstB;
+
+  for(;;)
+  {
+    countA = countB = 0;
+    do
+    {
+      if(mergeLess(ms, pb, pa))
+      {
+        memcpy(dest, pa, size);
+        dest -= size;
+        pa -= size;
+        countA++;
+        countB = 0;
+        if(!--na) goto done;
+      }
+      else
+      {
+        memcpy(dest, pb, size);
+        dest -= size;
+        pb -= size;
+        countB++;
+        countA = 0;
+        if(--nb == 1) goto firstB;
+      }
+    }
+    while((countA | countB) < minGallop);
+
+    minGallop++;
+    do
+    {
+      minGallop -= minGallop > 1;
+      ms->minGallop = minGallop;
+      k = countA = na - gallopRight(ms, pb, a, na, na - 1);
+      if(k)
+      {
+        dest -= k * size;
+        pa -= k * size;
+        memmove(dest + size, pa + size, k * size);
+        na -= k;
+        if(!na) goto done;
+      }
+      memcpy(dest, pb, size);
+      dest -= size;
+      pb -= size;
+      if(--nb == 1) goto firstB;
+
+      k = countB = nb - gallopLeft(ms, pa, buf, nb, nb - 1);
+      if(k)
+      {
+        dest -= k * size;
+        pb -= k * size;
+        memcpy(dest + size, pb + size, k * size);
+        nb -= k;
+        if(nb == 1) goto firstB;
+        if(!nb) goto done; //only possible if the comparison function is inconsistent
+      }
+      memcpy(dest, pa, size);
+      dest -= size;
+      pa -= size;
+      if(!--na) goto done;
+    }
+    while(countA >= MIN_GALLOP || countB >= MIN_GALLOP);
+    minGallop++;
+    ms->minGallop = minGallop;
+  }
+
+done:
+  if(nb) memcpy(dest - (nb - 1) * size, buf, nb * size);
+  return;
+
+firstB: //the first element of the right run is the smallest, the rest of the left run goes last
+  dest -= na * size;
+  pa -= na * size;
+  memmove(dest + size, pa + size, na * size);
+  memcpy(dest, pb, size);
+}
+
+/**
+ * @brief merges the adjacent runs a[0, na) and a[na, na + nb).
+ */
+static inline void mergeRuns(MergeState_t *ms, char *a, size_t na, size_t nb)
+{
+  size_t size = ms->size;
+  char *b = a + na * size;
+
+  //elements of the left run not greater than the first of the right one are in place already
+  size_t k = gallopRight(ms, b, a, na, 0);
+  a += k * size;
+  na -= k;
+  if(!na) return;
+  //as are elements of the right run not less than the last of the left one
+  nb = gallopLeft(ms, a + (na - 1) * size, b, nb, nb - 1);
+  if(!nb) return;
+
+  if(mergeReserve(ms, (na < nb)?na:nb)) stableMergeInPlace(a, na, nb, size, ms->cmp, ms->arg, ms->swap);
+  else if(na <= nb) mergeLo(ms, a, na, nb);
+  else mergeHi(ms, a, na, nb);
+}
+
+#endif
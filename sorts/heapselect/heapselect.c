@@ -0,0 +1,62 @@
+/**
+ * @file heapselect.c
+ * @author Roy Freytag
+ *
+ * heap-based top-k, as std::partial_sort does it.
+ *
+ * Keeps the k smallest elements seen so far in a max-heap at the front, every further element that is less than its
+ * root replaces the root. Sorting the heap leaves them in order, which takes O(n log k) time and a single pass over
+ * the input. With k = n it is heapsort, which is the context entry.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../select.h"
+#include "heapselect.h"
+
+/**
+ * @brief context-taking entry.
+ */
+void heapSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  sortPartial(data, n, n, size, ctx);
+}
+
+/**
+ * @brief partial-sort entry, see sortSelectFn_t.
+ */
+void sortPartial(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2 || !k) return;
+  if(k > n) k = n;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  heapSelect(&ss, data, n, k);
+  heapSortHeap(&ss, data, k);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "heapSelectSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Heap Top-k";
+}
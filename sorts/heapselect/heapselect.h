@@ -0,0 +1,10 @@
+#ifndef __HEAPSELECT_H_
+#define __HEAPSELECT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void heapSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+void sortPartial(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx);
+
+#endif /* __HEAPSELECT_H_ */
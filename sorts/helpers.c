@@ -8,10 +8,13 @@
 #define _GNU_SOURCE
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
-#include <dlfcn.h>
+#include <pthread.h>
 #include "helpers.h"
 
+#define SWAP_CHUNK 64 ///< size of the stack buffer used to exchange large elements chunk by chunk
+
 /**
  * pointer arithmetic for generic pointers
  * @param i generic pointer
@@ -26,36 +29,287 @@ void* voidAdd(void *i, size_t size, ssize_t a)
   return i+(a*size);
 }
 
-unsigned long long totalSwaps = 0; ///< swap counter
+/**
+ * swap counter.
+ *
+ * Thread-local, so the benchmark can run the same module on several threads at once.
+ * It keeps the default TLS model, because the modules get dlopen'ed: initial-exec variables take from the static
+ * TLS surplus, and once enough modules are loaded dlopen() fails with "cannot allocate memory in static TLS block".
+ */
+__thread unsigned long long totalSwaps = 0;
+
+/**
+ * comparison counter of instrumented builds.
+ *
+ * Only COUNT_COMPARE() in builds with SORT_INSTRUMENTED defined touches it.
+ */
+__thread unsigned long long sortCompares = 0;
+
+/**
+ * swaps two 4 byte elements.
+ * @see pswap()
+ */
+void pswap4(void *l, void *r, size_t size)
+{
+  (void)size;
+  if(l == r) return;
+  totalSwaps++;
+  uint32_t a, b;
+  memcpy(&a, l, 4);
+  memcpy(&b, r, 4);
+  memcpy(l, &b, 4);
+  memcpy(r, &a, 4);
+}
+
+/**
+ * swaps two 8 byte elements.
+ * @see pswap()
+ */
+void pswap8(void *l, void *r, size_t size)
+{
+  (void)size;
+  if(l == r) return;
+  totalSwaps++;
+  uint64_t a, b;
+  memcpy(&a, l, 8);
+  memcpy(&b, r, 8);
+  memcpy(l, &b, 8);
+  memcpy(r, &a, 8);
+}
+
+/**
+ * swaps two 16 byte elements.
+ * @see pswap()
+ */
+void pswap16(void *l, void *r, size_t size)
+{
+  (void)size;
+  if(l == r) return;
+  totalSwaps++;
+  uint64_t a[2], b[2];
+  memcpy(a, l, 16);
+  memcpy(b, r, 16);
+  memcpy(l, b, 16);
+  memcpy(r, a, 16);
+}
+
+/**
+ * swaps two elements word by word.
+ *
+ * both pointers have to be aligned to sizeof(unsigned long) and size has to be a multiple of it.
+ * @see pswap()
+ */
+void pswapWords(void *l, void *r, size_t size)
+{
+  if(l == r) return;
+  totalSwaps++;
+  unsigned long *a = l, *b = r, tmp;
+  size_t i;
+  for(i = 0; i < size / sizeof(unsigned long); i++)
+  {
+    tmp = a[i];
+    a[i] = b[i];
+    b[i] = tmp;
+  }
+}
+
+/**
+ * swaps two elements of arbitrary size and alignment.
+ *
+ * the elements are exchanged in chunks through a small stack buffer, so no allocation is needed.
+ * @see pswap()
+ */
+void pswapBytes(void *l, void *r, size_t size)
+{
+  if(l == r) return;
+  totalSwaps++;
+  unsigned char tmp[SWAP_CHUNK];
+  unsigned char *a = l, *b = r;
+  size_t chunk;
+  while(size)
+  {
+    chunk = (size < SWAP_CHUNK)?size:SWAP_CHUNK;
+    memcpy(tmp, a, chunk);
+    memcpy(a, b, chunk);
+    memcpy(b, tmp, chunk);
+    a += chunk;
+    b += chunk;
+    size -= chunk;
+  }
+}
+
+/**
+ * selects the fastest swap kernel for the given element size.
+ *
+ * Meant to be called once per sort call, the returned kernel can then be used for every swap on that array.
+ * @param base pointer to the array that is going to be sorted
+ * @param size size of the elements
+ * @return swap kernel suited for elements of size bytes in base
+ */
+swapFn_t pswapSelect(void *base, size_t size)
+{
+  switch(size)
+  {
+    case 4: return pswap4;
+    case 8: return pswap8;
+    case 16: return pswap16;
+  }
+  if(size % sizeof(unsigned long) == 0 && (uintptr_t)base % sizeof(unsigned long) == 0) return pswapWords;
+  return pswapBytes;
+}
 
-#ifdef _GNU_SOURCE
-static void* (*o_malloc)(size_t) = 0;
-#endif
 /**
  * swaps elements from l to r.
  *
- * both pointers need to point to of same size types
+ * both pointers need to point to of same size types.
+ * Selects the kernel on every call, use pswapSelect() once per sort instead when swapping a lot.
  * @param l left side
  * @param r right side
  * @param size size of the elements
  */
 void pswap(void *l, void *r, size_t size)
 {
-#ifdef _GNU_SOURCE
-  if(!o_malloc) o_malloc = dlsym(RTLD_NEXT, "malloc");
-#endif
   /*void tmp = *l;
   *l = *r;
   *r = tmp;*/
-  if(l == r) return;
-  totalSwaps++;
-#ifdef _GNU_SOURCE
-  void *tmp = o_malloc(size);
-#else
-  void *tmp = malloc(size);
-#endif
-  memcpy(tmp, l, size);
-  memcpy(l, r, size);
-  memcpy(r, tmp, size);
-  free(tmp);
+  swapFn_t swap = pswapSelect(l, size);
+  if(swap == pswapWords && (uintptr_t)r % sizeof(unsigned long)) swap = pswapBytes;
+  swap(l, r, size);
+}
+
+/**
+ * threads started by runThreads()
+ */
+typedef struct
+{
+  threadFn_t fn; ///< function to run
+  void *arg; ///< its argument
+  unsigned threads; ///< number of threads that actually got started
+  int released; ///< set to one once threads is final
+  pthread_mutex_t lock; ///< protects released
+  pthread_cond_t release; ///< signals released
+} ThreadGroup_t;
+
+/**
+ * a thread started by runThreads()
+ */
+typedef struct
+{
+  ThreadGroup_t *group; ///< group of the thread
+  unsigned thread; ///< index of the thread
+} ThreadStart_t;
+
+/**
+ * @brief waits until all threads of the group are started, then runs the function.
+ */
+static void *threadMain(void *arg)
+{
+  ThreadStart_t *start = arg;
+  ThreadGroup_t *g = start->group;
+  pthread_mutex_lock(&g->lock);
+  while(!g->released) pthread_cond_wait(&g->release, &g->lock);
+  pthread_mutex_unlock(&g->lock);
+  g->fn(start->thread, g->threads, g->arg);
+  return 0;
+}
+
+/**
+ * runs a function on several threads and waits for all of them.
+ *
+ * The calling thread runs thread 0. If not all threads can be created, the function is told the number that could be,
+ * so it may synchronize its threads without deadlocking.
+ * @param threads number of threads to run fn on.
+ * @param fn function to run, gets the index of the thread, the number of threads and arg.
+ * @param arg argument of fn.
+ * @return number of threads fn ran on.
+ */
+unsigned runThreads(unsigned threads, threadFn_t fn, void *arg)
+{
+  if(threads <= 1)
+  {
+    fn(0, 1, arg);
+    return 1;
+  }
+
+  pthread_t *ids = malloc(threads * sizeof(pthread_t));
+  ThreadStart_t *starts = malloc(threads * sizeof(ThreadStart_t));
+  if(!ids || !starts)
+  {
+    free(ids);
+    free(starts);
+    fn(0, 1, arg);
+    return 1;
+  }
+
+  ThreadGroup_t g;
+  g.fn = fn;
+  g.arg = arg;
+  g.released = 0;
+  pthread_mutex_init(&g.lock, 0);
+  pthread_cond_init(&g.release, 0);
+
+  unsigned i, started = 1;
+  for(i = 1; i < threads; i++, started++)
+  {
+    starts[i].group = &g;
+    starts[i].thread = i;
+    if(pthread_create(&ids[i], 0, threadMain, &starts[i])) break;
+  }
+
+  pthread_mutex_lock(&g.lock);
+  g.threads = started;
+  g.released = 1;
+  pthread_cond_broadcast(&g.release);
+  pthread_mutex_unlock(&g.lock);
+
+  fn(0, started, arg);
+  for(i = 1; i < started; i++) pthread_join(ids[i], 0);
+
+  pthread_cond_destroy(&g.release);
+  pthread_mutex_destroy(&g.lock);
+  free(ids);
+  free(starts);
+  return started;
+}
+
+/**
+ * @brief initializes a barrier.
+ */
+void barrierInit(Barrier_t *b)
+{
+  pthread_mutex_init(&b->lock, 0);
+  pthread_cond_init(&b->done, 0);
+  b->waiting = 0;
+  b->generation = 0;
+}
+
+/**
+ * @brief waits until all threads reached the barrier.
+ * @param b barrier.
+ * @param threads number of threads, as passed to the function run by runThreads().
+ */
+void barrierWait(Barrier_t *b, unsigned threads)
+{
+  pthread_mutex_lock(&b->lock);
+  unsigned generation = b->generation;
+  if(++b->waiting == threads)
+  {
+    b->waiting = 0;
+    b->generation++;
+    pthread_cond_broadcast(&b->done);
+  }
+  else
+  {
+    while(generation == b->generation) pthread_cond_wait(&b->done, &b->lock);
+  }
+  pthread_mutex_unlock(&b->lock);
+}
+
+/**
+ * @brief destroys a barrier.
+ */
+void barrierDestroy(Barrier_t *b)
+{
+  pthread_cond_destroy(&b->done);
+  pthread_mutex_destroy(&b->lock);
 }
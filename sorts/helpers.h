@@ -9,8 +9,48 @@
 #define __HELPERS_H__
 
 #include <stdlib.h>
+#include <pthread.h>
+#include "simdkernels.h" //vectorized kernels, e.g. simdPartition_i32(), modules using them link simdkernels.c as well
+
+typedef void (*swapFn_t)(void*, void*, size_t); ///< Function-pointer type definition for the swap kernels
+
+extern __thread unsigned long long totalSwaps;
+extern __thread unsigned long long sortCompares;
+
+//type-specialized entries have no comparison function to count with, builds with SORT_INSTRUMENTED defined count here instead
+#ifdef SORT_INSTRUMENTED
+#define COUNT_COMPARE() (sortCompares++) ///< counts a comparison of a type-specialized entry
+#define COUNT_SWAP() (totalSwaps++) ///< counts a swap of a type-specialized entry
+#else
+#define COUNT_COMPARE() ((void)0)
+#define COUNT_SWAP() ((void)0)
+#endif
+
+typedef void (*threadFn_t)(unsigned thread, unsigned threads, void *arg); ///< Function-pointer type definition for functions run by runThreads()
+
+/**
+ * barrier for the threads of runThreads(), the number of threads is given on waiting
+ */
+typedef struct
+{
+  pthread_mutex_t lock; ///< protects the barrier
+  pthread_cond_t done; ///< signals a new generation
+  unsigned waiting; ///< threads waiting in the current generation
+  unsigned generation; ///< number of times the barrier opened
+} Barrier_t;
 
 void* voidAdd(void *i, size_t size, ssize_t a);
+unsigned runThreads(unsigned threads, threadFn_t fn, void *arg);
+void barrierInit(Barrier_t *b);
+void barrierWait(Barrier_t *b, unsigned threads);
+void barrierDestroy(Barrier_t *b);
 void pswap(void *l, void *r, size_t size);
 
+swapFn_t pswapSelect(void *base, size_t size);
+void pswap4(void *l, void *r, size_t size);
+void pswap8(void *l, void *r, size_t size);
+void pswap16(void *l, void *r, size_t size);
+void pswapWords(void *l, void *r, size_t size);
+void pswapBytes(void *l, void *r, size_t size);
+
 #endif
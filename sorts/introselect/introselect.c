@@ -0,0 +1,84 @@
+/**
+ * @file introselect.c
+ * @author Roy Freytag
+ *
+ * introselect(Musser, "Introspective Sorting and Selection Algorithms"), as std::nth_element does it.
+ *
+ * A quickselect partitioning around the median of the first, middle and last element. Once it needed more than
+ * 2 log2(n) partitions, the remaining range gets selected by heapSelectNth() instead, which bounds the worst case
+ * to O(n log n). The context entry is the introsort it comes from, introSort() of introsort.h.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../select.h"
+#include "introselect.h"
+
+/**
+ * @brief context-taking entry.
+ */
+void introSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  introSort(data, n, size, ss.cmp, ss.arg, ss.swap, introDepthLimit(n));
+}
+
+/**
+ * @brief selection entry, see sortSelectFn_t.
+ */
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx)
+{
+  if(!data || k >= n) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  char *a = data;
+  unsigned depth = introDepthLimit(n);
+  while(n > SELECT_INSERTION)
+  {
+    if(!depth--)
+    {
+      heapSelectNth(&ss, a, n, k);
+      return;
+    }
+    selectMedian3(&ss, a, n);
+    size_t p = selectPartition(&ss, a, n);
+    if(k == p) return;
+    if(k < p) n = p;
+    else
+    {
+      a += (p + 1) * size;
+      n -= p + 1;
+      k -= p + 1;
+    }
+  }
+  selectInsertion(&ss, a, n);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "introSelectSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Introselect";
+}
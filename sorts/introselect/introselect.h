@@ -0,0 +1,10 @@
+#ifndef __INTROSELECT_H_
+#define __INTROSELECT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void introSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx);
+
+#endif /* __INTROSELECT_H_ */
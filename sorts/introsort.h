@@ -0,0 +1,139 @@
+/**
+ * @file introsort.h
+ * @author Roy Freytag
+ *
+ * building blocks of the quicksort family, for elements of any size compared by a comparison function with an argument.
+ *
+ * introDepthLimit() is the partitioning depth after which a range gets heapsorted, introInsertion() sorts the ranges of
+ * up to INTRO_INSERTION elements, so all modules share both the cutoffs and the way they count.
+ * introSort() puts them together with a median of three and a partition whose scans both stop at equal elements, so
+ * runs of equal keys get split in half. It is the sequential sort of the parallel modules.
+ */
+#ifndef __INTROSORT_H__
+#define __INTROSORT_H__
+
+#include <stdlib.h>
+#include "helpers.h"
+
+#define INTRO_INSERTION 16 ///< ranges up to this size get insertion sorted instead of partitioned
+
+/**
+ * @brief 2 * floor(log2(n)), the partitioning depth after which a range gets heapsorted.
+ */
+static inline unsigned introDepthLimit(size_t n)
+{
+  unsigned limit = 0;
+  for(; n > 1; n >>= 1) limit += 2;
+  return limit;
+}
+
+/**
+ * @brief insertion sort for small ranges.
+ */
+static inline void introInsertion(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i;
+  for(i = 1; i < n; i++)
+  {
+    char *p = a + i * size;
+    for(; p > a && cmp(p, p - size, arg) < 0; p -= size) swap(p, p - size, size);
+  }
+}
+
+/**
+ * @brief restores the max-heap property below node root of a heap of n elements.
+ */
+static inline void introSiftDown(char *a, size_t root, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t child;
+  while((child = 2 * root + 1) < n)
+  {
+    if(child + 1 < n && cmp(a + child * size, a + (child + 1) * size, arg) < 0) child++;
+    if(cmp(a + root * size, a + child * size, arg) >= 0) return;
+    swap(a + root * size, a + child * size, size);
+    root = child;
+  }
+}
+
+/**
+ * @brief heapsort, the fallback for ranges that recursed too deep.
+ */
+static inline void introHeapSort(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i;
+  for(i = n / 2; i > 0; i--) introSiftDown(a, i - 1, n, size, cmp, arg, swap);
+  for(i = n - 1; i > 0; i--)
+  {
+    swap(a, a + i * size, size);
+    introSiftDown(a, 0, i, size, cmp, arg, swap);
+  }
+}
+
+/**
+ * @brief moves the median of the first, middle and last element of a range to its front.
+ *
+ * The largest of them ends up last, so the scan for larger elements of introPartition() stops there.
+ */
+static inline void introMedian3(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  char *m = a + n / 2 * size, *z = a + (n - 1) * size;
+  if(cmp(m, a, arg) < 0) swap(m, a, size);
+  if(cmp(z, m, arg) < 0)
+  {
+    swap(z, m, size);
+    if(cmp(m, a, arg) < 0) swap(m, a, size);
+  }
+  swap(a, m, size);
+}
+
+/**
+ * @brief partitions a range around its first element.
+ * @return index the first element ends up at, no element before it is greater and none after it is less.
+ */
+static inline size_t introPartition(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i = 0, j = n;
+  for(;;)
+  {
+    do i++; while(i < n && cmp(a + i * size, a, arg) < 0);
+    do j--; while(cmp(a, a + j * size, arg) < 0);
+    if(i >= j) break;
+    swap(a + i * size, a + j * size, size);
+  }
+  swap(a, a + j * size, size);
+  return j;
+}
+
+/**
+ * @brief introsort of a range, recursing into the smaller part and looping on the larger one.
+ *
+ * Partitions around the median of three until the range is short enough for insertion sort,
+ * ranges still unsorted after depth partitions get heapsorted.
+ */
+static inline void introSort(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap, unsigned depth)
+{
+  while(n > INTRO_INSERTION)
+  {
+    if(!depth--)
+    {
+      introHeapSort(a, n, size, cmp, arg, swap);
+      return;
+    }
+    introMedian3(a, n, size, cmp, arg, swap);
+    size_t p = introPartition(a, n, size, cmp, arg, swap);
+    if(p < n - p - 1)
+    {
+      introSort(a, p, size, cmp, arg, swap, depth);
+      a += (p + 1) * size;
+      n -= p + 1;
+    }
+    else
+    {
+      introSort(a + (p + 1) * size, n - p - 1, size, cmp, arg, swap, depth);
+      n = p;
+    }
+  }
+  introInsertion(a, n, size, cmp, arg, swap);
+}
+
+#endif
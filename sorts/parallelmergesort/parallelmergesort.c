@@ -0,0 +1,224 @@
+/**
+ * @file parallelmergesort.c
+ * @author Roy Freytag
+ *
+ * parallel merge sort with merge path partitioning.
+ *
+ * Every thread sorts a slice of the elements with a sequential stable merge sort, then the sorted runs get merged
+ * pairwise, round by round. In every round each merge gets split evenly between all threads: thread t writes the
+ * output elements [t * len / threads, (t + 1) * len / threads) and finds where its part starts in both runs
+ * by a binary search along the cross diagonal of the merge matrix(merge path). So every thread does the same
+ * amount of work, no matter how the runs interleave. Ties are taken from the left run, which keeps the sort stable.
+ * Without memory for the scratch buffer the elements get sorted sequentially by stablemerge.h's merge sort, which
+ * merges in place by rotations, so the sort stays stable under memory pressure.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../stablemerge.h"
+#include "parallelmergesort.h"
+
+#define INSERTION_THRESHOLD 16 ///< runs up to this size get insertion sorted
+
+/**
+ * state shared by the threads of a sort call
+ */
+typedef struct
+{
+  char *data; ///< elements
+  char *scratch; ///< buffer of n elements
+  size_t n; ///< number of elements
+  size_t size; ///< size of an element
+  SortContext_t *ctx; ///< comparison function
+  char *result; ///< buffer holding the sorted elements in the end, data or scratch
+  Barrier_t barrier; ///< separates the rounds
+} Shared_t;
+
+/**
+ * @brief stable insertion sort.
+ * @param tmp buffer of one element, 0 to move the elements into place by adjacent swaps.
+ */
+static void insertionSort(char *a, size_t n, size_t size, SortContext_t *ctx, char *tmp)
+{
+  size_t i, j;
+  for(i = 1; i < n; i++)
+  {
+    for(j = i; j > 0 && ctx->compare(a + (j - 1) * size, a + i * size, ctx->compareArg) > 0; j--);
+    if(j == i) continue;
+    if(!tmp)
+    {
+      size_t k;
+      for(k = i; k > j; k--) pswap(a + (k - 1) * size, a + k * size, size);
+      continue;
+    }
+    memcpy(tmp, a + i * size, size);
+    memmove(a + (j + 1) * size, a + j * size, (i - j) * size);
+    memcpy(a + j * size, tmp, size);
+  }
+}
+
+/**
+ * @brief merges the elements [a, a + na) and [b, b + nb) into out, stopping after count elements.
+ */
+static void merge(const char *a, size_t na, const char *b, size_t nb, char *out, size_t count, size_t size, SortContext_t *ctx)
+{
+  const char *ea = a + na * size, *eb = b + nb * size;
+  while(count && a < ea && b < eb)
+  {
+    if(ctx->compare(b, a, ctx->compareArg) < 0)
+    {
+      memcpy(out, b, size);
+      b += size;
+    }
+    else
+    {
+      memcpy(out, a, size);
+      a += size;
+    }
+    out += size;
+    count--;
+  }
+  while(count && a < ea)
+  {
+    size_t c = (size_t)(ea - a) / size;
+    if(c > count) c = count;
+    memcpy(out, a, c * size);
+    out += c * size;
+    a += c * size;
+    count -= c;
+  }
+  if(count && b < eb) memcpy(out, b, ((size_t)(eb - b) / size < count?(size_t)(eb - b) / size:count) * size);
+}
+
+/**
+ * @brief sequential stable merge sort of a slice, the result ends up in a.
+ * @param tmp buffer of n elements.
+ * @param one buffer of one element, may be 0.
+ */
+static void mergeSort(char *a, char *tmp, size_t n, size_t size, SortContext_t *ctx, char *one)
+{
+  if(n <= INSERTION_THRESHOLD)
+  {
+    insertionSort(a, n, size, ctx, one);
+    return;
+  }
+  size_t h = n / 2;
+  mergeSort(a, tmp, h, size, ctx, one);
+  mergeSort(a + h * size, tmp + h * size, n - h, size, ctx, one);
+  if(ctx->compare(a + h * size, a + (h - 1) * size, ctx->compareArg) >= 0) return; //already in order
+  merge(a, h, a + h * size, n - h, tmp, n, size, ctx);
+  memcpy(a, tmp, n * size);
+}
+
+/**
+ * @brief finds how many elements of the left run come first in the merged output up to diagonal d.
+ *
+ * The rest of the d elements come from the right run.
+ */
+static size_t mergePath(const char *a, size_t na, const char *b, size_t nb, size_t d, size_t size, SortContext_t *ctx)
+{
+  size_t lo = (d > nb)?d - nb:0, hi = (d < na)?d:na;
+  while(lo < hi)
+  {
+    size_t i = (lo + hi) / 2; //take i from a and d - i from b
+    if(ctx->compare(b + (d - i - 1) * size, a + i * size, ctx->compareArg) < 0) hi = i;
+    else lo = i + 1;
+  }
+  return lo;
+}
+
+/**
+ * @brief work of a single thread, see the file description.
+ */
+static void worker(unsigned thread, unsigned threads, void *arg)
+{
+  Shared_t *s = arg;
+  size_t size = s->size;
+  size_t begin = s->n * thread / threads, end = s->n * (thread + 1) / threads;
+  char one[256];
+  char *tmpOne = (size <= sizeof(one))?one:malloc(size);
+
+  mergeSort(s->data + begin * size, s->scratch + begin * size, end - begin, size, s->ctx, tmpOne);
+  if(tmpOne && tmpOne != one) free(tmpOne);
+  barrierWait(&s->barrier, threads);
+
+  //merge the runs of the threads pairwise, the runs of a round start at the slice boundaries of every width-th thread
+  char *src = s->data, *dst = s->scratch;
+  unsigned width, r;
+  for(width = 1; width < threads; width *= 2)
+  {
+    for(r = 0; r < threads; r += 2 * width)
+    {
+      size_t lo = s->n * r / threads;
+      size_t mid = s->n * ((r + width < threads)?r + width:threads) / threads;
+      size_t hi = s->n * ((r + 2 * width < threads)?r + 2 * width:threads) / threads;
+      size_t len = hi - lo;
+      size_t d0 = len * thread / threads, d1 = len * (thread + 1) / threads;
+      const char *a = src + lo * size, *b = src + mid * size;
+      size_t na = mid - lo, nb = hi - mid;
+      size_t i0 = mergePath(a, na, b, nb, d0, size, s->ctx);
+      merge(a + i0 * size, na - i0, b + (d0 - i0) * size, nb - (d0 - i0), dst + (lo + d0) * size, d1 - d0, size, s->ctx);
+    }
+    char *t = src;
+    src = dst;
+    dst = t;
+    barrierWait(&s->barrier, threads);
+  }
+  if(thread == 0) s->result = src;
+}
+
+/**
+ * @brief context-taking entry, sorts with ctx->threads threads.
+ */
+void parallelMergeSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  unsigned threads = ctx->threads?ctx->threads:1;
+  if(threads > n) threads = n;
+  Shared_t s;
+  s.data = data;
+  s.n = n;
+  s.size = size;
+  s.ctx = ctx;
+  s.scratch = (ctx->scratchSize >= n * size)?ctx->scratch:malloc(n * size);
+  if(!s.scratch)
+  {
+    stableMergeSort(data, n, size, ctx->compare, ctx->compareArg, pswapSelect(data, size), 0);
+    return;
+  }
+
+  barrierInit(&s.barrier);
+  runThreads(threads, worker, &s);
+  barrierDestroy(&s.barrier);
+  if(s.result != s.data) memcpy(data, s.result, n * size);
+
+  if(s.scratch != ctx->scratch) free(s.scratch);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_STABLE | SORT_CAP_PARALLEL | SORT_CAP_SCRATCH,
+  0,
+  0,
+  "parallelMergeSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Parallel Mergesort";
+}
@@ -0,0 +1,9 @@
+#ifndef __PARALLELMERGESORT_H_
+#define __PARALLELMERGESORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void parallelMergeSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __PARALLELMERGESORT_H_ */
@@ -0,0 +1,273 @@
+/**
+ * @file parallelquicksort.c
+ * @author Roy Freytag
+ *
+ * work-stealing parallel quicksort.
+ *
+ * Every thread owns a deque of ranges. It partitions the range it works on, pushes the larger part onto the bottom
+ * of its deque and goes on with the smaller one, until the range is small enough to be sorted sequentially.
+ * Threads running out of work take ranges from their own bottom first, then steal from the top of the others,
+ * where the largest ranges are. Ranges recursing too deep get sorted sequentially as well.
+ * The sequential sort is the introsort of introsort.h, continuing with the depth budget the range has left, so past
+ * the depth limit it heap sorts and short ranges get insertion sorted.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../introsort.h"
+#include "parallelquicksort.h"
+
+#define GRAIN 8192 ///< ranges up to this size get sorted sequentially
+
+/**
+ * range of elements to sort
+ */
+typedef struct
+{
+  size_t lo; ///< index of the first element
+  size_t n; ///< number of elements
+  unsigned depth; ///< partitioning depth
+} Task_t;
+
+/**
+ * ranges of a thread
+ */
+typedef struct
+{
+  Task_t *tasks; ///< ranges, the oldest at top
+  size_t top; ///< index of the oldest range
+  size_t bottom; ///< index after the newest range
+  size_t capacity; ///< size of tasks
+  pthread_mutex_t lock; ///< protects the deque
+} Deque_t;
+
+/**
+ * state shared by the threads of a sort call
+ */
+typedef struct
+{
+  char *data; ///< elements
+  size_t size; ///< size of an element
+  SortContext_t *ctx; ///< comparison function
+  Deque_t *deques; ///< one deque per thread
+  unsigned threads; ///< number of deques
+  unsigned maxDepth; ///< depth at which ranges get sorted sequentially
+  atomic_size_t pending; ///< ranges pushed or being worked on
+} Shared_t;
+
+/**
+ * @brief pushes a range onto the bottom of a deque.
+ * @return 0 on success, -1 if the deque couldn't grow.
+ */
+static int pushBottom(Deque_t *d, Task_t *t)
+{
+  int res = 0;
+  pthread_mutex_lock(&d->lock);
+  if(d->bottom == d->capacity)
+  {
+    size_t capacity = d->capacity?d->capacity * 2:64;
+    Task_t *tmp = realloc(d->tasks, capacity * sizeof(Task_t));
+    if(tmp)
+    {
+      d->tasks = tmp;
+      d->capacity = capacity;
+    }
+    else res = -1;
+  }
+  if(!res) d->tasks[d->bottom++] = *t;
+  pthread_mutex_unlock(&d->lock);
+  return res;
+}
+
+/**
+ * @brief takes the newest range from a deque.
+ * @return 1 if there was one, 0 otherwise.
+ */
+static int popBottom(Deque_t *d, Task_t *t)
+{
+  int res = 0;
+  pthread_mutex_lock(&d->lock);
+  if(d->bottom > d->top)
+  {
+    *t = d->tasks[--d->bottom];
+    res = 1;
+  }
+  if(d->bottom == d->top) d->bottom = d->top = 0;
+  pthread_mutex_unlock(&d->lock);
+  return res;
+}
+
+/**
+ * @brief takes the oldest range from a deque.
+ * @return 1 if there was one, 0 otherwise.
+ */
+static int stealTop(Deque_t *d, Task_t *t)
+{
+  int res = 0;
+  if(!pthread_mutex_trylock(&d->lock))
+  {
+    if(d->bottom > d->top)
+    {
+      *t = d->tasks[d->top++];
+      res = 1;
+    }
+    if(d->bottom == d->top) d->bottom = d->top = 0;
+    pthread_mutex_unlock(&d->lock);
+  }
+  return res;
+}
+
+/**
+ * @brief partitions a range around the median of its first, middle and last element.
+ * @return index of the pivot afterwards.
+ */
+static size_t partition(Shared_t *s, size_t lo, size_t n, swapFn_t swap)
+{
+  size_t size = s->size;
+  int (*cmp)(const void*, const void*, void*) = s->ctx->compare;
+  void *arg = s->ctx->compareArg;
+  char *a = s->data + lo * size;
+  char *m = a + (n / 2) * size, *z = a + (n - 1) * size;
+
+  //median of three to the front
+  if(cmp(m, a, arg) < 0) swap(m, a, size);
+  if(cmp(z, m, arg) < 0)
+  {
+    swap(z, m, size);
+    if(cmp(m, a, arg) < 0) swap(m, a, size);
+  }
+  swap(a, m, size);
+
+  size_t i = 0, j = n;
+  for(;;)
+  {
+    do i++; while(i < n && cmp(a + i * size, a, arg) < 0);
+    do j--; while(cmp(a + j * size, a, arg) > 0);
+    if(i >= j) break;
+    swap(a + i * size, a + j * size, size);
+  }
+  swap(a, a + j * size, size);
+  return lo + j;
+}
+
+/**
+ * @brief sorts a range on the calling thread.
+ * @param depth partitions left before the range gets heap sorted.
+ */
+static void sequentialSort(Shared_t *s, size_t lo, size_t n, unsigned depth)
+{
+  introSort(s->data + lo * s->size, n, s->size, s->ctx->compare, s->ctx->compareArg, pswapSelect(s->data, s->size), depth);
+}
+
+/**
+ * @brief sorts a range, pushing off parts for other threads.
+ */
+static void sortTask(Shared_t *s, Deque_t *own, Task_t t, swapFn_t swap)
+{
+  while(t.n > GRAIN && t.depth < s->maxDepth)
+  {
+    size_t p = partition(s, t.lo, t.n, swap);
+    Task_t left = {t.lo, p - t.lo, t.depth + 1};
+    Task_t right = {p + 1, t.lo + t.n - p - 1, t.depth + 1};
+    Task_t *larger = (left.n > right.n)?&left:&right;
+    Task_t *smaller = (left.n > right.n)?&right:&left;
+
+    atomic_fetch_add(&s->pending, 1);
+    if(pushBottom(own, larger))
+    {
+      atomic_fetch_sub(&s->pending, 1);
+      sortTask(s, own, *larger, swap);
+    }
+    t = *smaller;
+  }
+  if(t.n > 1) sequentialSort(s, t.lo, t.n, (t.depth < s->maxDepth)?s->maxDepth - t.depth:0);
+}
+
+/**
+ * @brief work loop of a thread.
+ */
+static void worker(unsigned thread, unsigned threads, void *arg)
+{
+  Shared_t *s = arg;
+  Deque_t *own = &s->deques[thread];
+  swapFn_t swap = pswapSelect(s->data, s->size);
+  Task_t t = {0, 0, 0};
+  unsigned i;
+  for(;;)
+  {
+    int found = popBottom(own, &t);
+    for(i = 1; i < threads && !found; i++) found = stealTop(&s->deques[(thread + i) % threads], &t);
+    if(found)
+    {
+      sortTask(s, own, t, swap);
+      atomic_fetch_sub(&s->pending, 1);
+    }
+    else if(!atomic_load(&s->pending)) break;
+    else sched_yield();
+  }
+}
+
+/**
+ * @brief context-taking entry, sorts with ctx->threads threads.
+ */
+void parallelQuickSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  unsigned threads = ctx->threads?ctx->threads:1;
+  Shared_t s;
+  s.data = data;
+  s.size = size;
+  s.ctx = ctx;
+  s.threads = threads;
+  s.maxDepth = 2 + introDepthLimit(n);
+  size_t i;
+  s.deques = calloc(threads, sizeof(Deque_t));
+  if(!s.deques)
+  {
+    sequentialSort(&s, 0, n, s.maxDepth);
+    return;
+  }
+  for(i = 0; i < threads; i++) pthread_mutex_init(&s.deques[i].lock, 0);
+
+  Task_t all = {0, n, 0};
+  atomic_init(&s.pending, 1);
+  if(pushBottom(&s.deques[0], &all)) sequentialSort(&s, 0, n, s.maxDepth);
+  else runThreads(threads, worker, &s);
+
+  for(i = 0; i < threads; i++)
+  {
+    pthread_mutex_destroy(&s.deques[i].lock);
+    free(s.deques[i].tasks);
+  }
+  free(s.deques);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_PARALLEL,
+  0,
+  0,
+  "parallelQuickSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Parallel Quicksort";
+}
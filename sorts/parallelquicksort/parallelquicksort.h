@@ -0,0 +1,9 @@
+#ifndef __PARALLELQUICKSORT_H_
+#define __PARALLELQUICKSORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void parallelQuickSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __PARALLELQUICKSORT_H_ */
@@ -0,0 +1,379 @@
+/**
+ * @file pdqsort.c
+ * @author Roy Freytag
+ *
+ * pattern-defeating quicksort(Orson Peters, "Pattern-defeating Quicksort").
+ *
+ * An introsort partitioning with blockPartition(), which adapts to patterns in the input:
+ * - if a range is partitioned already, a partial insertion sort tries to finish it, giving up after a few moves.
+ *   So sorted and nearly sorted input takes linear time.
+ * - if the pivot equals the element left of the range, which was a pivot of an earlier partitioning, all elements
+ *   equal to it get partitioned to the left and skipped. So few distinct keys take linear time per key.
+ * - unbalanced partitionings swap a few elements around to break up the pattern causing them, after log n of them
+ *   the range gets heapsorted.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../introsort.h"
+#include "../blockpartition.h"
+#include "pdqsort.h"
+
+#define INSERTION_THRESHOLD 24 ///< ranges below this size get insertion sorted
+#define NINTHER_THRESHOLD 128 ///< ranges above this size take the pivot as median of three medians of three(ninther)
+#define PARTIAL_INSERTION_LIMIT 8 ///< moves after which the partial insertion sort gives up
+
+/**
+ * @brief floor(log2(n)), the number of unbalanced partitionings after which a range gets heapsorted.
+ */
+static unsigned log2Floor(size_t n)
+{
+  unsigned log = 0;
+  for(; n > 1; n >>= 1) log++;
+  return log;
+}
+
+/**
+ * @brief 1 if the element at x is less than the one at y.
+ */
+static inline int less(SortContext_t *ctx, const char *x, const char *y)
+{
+  return ctx->compare(x, y, ctx->compareArg) < 0;
+}
+
+/**
+ * @brief sorts the elements at a, b and c.
+ */
+static void sort3(char *a, char *b, char *c, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  if(less(ctx, b, a)) swap(a, b, size);
+  if(less(ctx, c, b))
+  {
+    swap(b, c, size);
+    if(less(ctx, b, a)) swap(a, b, size);
+  }
+}
+
+/**
+ * @brief insertion sort giving up after PARTIAL_INSERTION_LIMIT moves.
+ * @return 1 if the range got sorted.
+ */
+static int partialInsertionSort(char *a, size_t n, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  size_t i, j, moves = 0;
+  for(i = 1; i < n; i++)
+  {
+    for(j = i; j > 0 && less(ctx, a + j * size, a + (j - 1) * size); j--) swap(a + (j - 1) * size, a + j * size, size);
+    moves += i - j;
+    if(moves > PARTIAL_INSERTION_LIMIT) return 0;
+  }
+  return 1;
+}
+
+/**
+ * @brief moves the median of three, or the ninther for larger ranges, to the front of the range.
+ */
+static void choosePivot(char *a, size_t n, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  size_t h = n / 2;
+  if(n > NINTHER_THRESHOLD)
+  {
+    sort3(a, a + h * size, a + (n - 1) * size, size, ctx, swap);
+    sort3(a + size, a + (h - 1) * size, a + (n - 2) * size, size, ctx, swap);
+    sort3(a + 2 * size, a + (h + 1) * size, a + (n - 3) * size, size, ctx, swap);
+    sort3(a + (h - 1) * size, a + h * size, a + (h + 1) * size, size, ctx, swap);
+    swap(a, a + h * size, size);
+  }
+  else sort3(a + h * size, a, a + (n - 1) * size, size, ctx, swap);
+}
+
+/**
+ * @brief partitions around the pivot at a[0], elements equal to it go left.
+ *
+ * Only used if the element left of the range is equal to the pivot, so no element is less than it.
+ * @return index of the pivot afterwards, all elements up to it are equal.
+ */
+static size_t partitionLeft(char *a, size_t n, size_t size, SortContext_t *ctx, swapFn_t swap)
+{
+  size_t i = 0, j = n;
+  while(less(ctx, a, a + --j * size)); //stops at the pivot at the latest
+  if(j + 1 == n) while(i < j && !less(ctx, a, a + ++i * size));
+  else while(!less(ctx, a, a + ++i * size)); //stops at the element right of j
+  while(i < j)
+  {
+    swap(a + i * size, a + j * size, size);
+    while(less(ctx, a, a + --j * size));
+    while(!less(ctx, a, a + ++i * size));
+  }
+  swap(a, a + j * size, size);
+  return j;
+}
+
+/**
+ * @brief swaps some elements of the parts of an unbalanced partitioning, to break up the pattern.
+ */
+static void breakPatterns(char *a, size_t n, size_t pos, size_t size, swapFn_t swap)
+{
+  size_t l = pos, r = n - pos - 1;
+  if(l >= INSERTION_THRESHOLD)
+  {
+    swap(a, a + (l / 4) * size, size);
+    swap(a + (pos - 1) * size, a + (pos - l / 4) * size, size);
+    if(l > NINTHER_THRESHOLD)
+    {
+      swap(a + size, a + (l / 4 + 1) * size, size);
+      swap(a + 2 * size, a + (l / 4 + 2) * size, size);
+      swap(a + (pos - 2) * size, a + (pos - (l / 4 + 1)) * size, size);
+      swap(a + (pos - 3) * size, a + (pos - (l / 4 + 2)) * size, size);
+    }
+  }
+  if(r >= INSERTION_THRESHOLD)
+  {
+    swap(a + (pos + 1) * size, a + (pos + 1 + r / 4) * size, size);
+    swap(a + (n - 1) * size, a + (n - r / 4) * size, size);
+    if(r > NINTHER_THRESHOLD)
+    {
+      swap(a + (pos + 2) * size, a + (pos + 2 + r / 4) * size, size);
+      swap(a + (pos + 3) * size, a + (pos + 3 + r / 4) * size, size);
+      swap(a + (n - 2) * size, a + (n - (1 + r / 4)) * size, size);
+      swap(a + (n - 3) * size, a + (n - (2 + r / 4)) * size, size);
+    }
+  }
+}
+
+/**
+ * @brief sorts a range, recursing into the left part and looping on the right one.
+ * @param bad unbalanced partitionings allowed before heapsorting.
+ * @param leftmost 1 if there is no element left of the range.
+ */
+static void pdqLoop(char *a, size_t n, size_t size, SortContext_t *ctx, swapFn_t swap, unsigned bad, int leftmost)
+{
+  for(;;)
+  {
+    if(n < INSERTION_THRESHOLD)
+    {
+      introInsertion(a, n, size, ctx->compare, ctx->compareArg, swap);
+      return;
+    }
+
+    choosePivot(a, n, size, ctx, swap);
+
+    //the element left of the range was a pivot, if it equals this one, the equal elements are done
+    if(!leftmost && !less(ctx, a - size, a))
+    {
+      size_t pos = partitionLeft(a, n, size, ctx, swap);
+      a += (pos + 1) * size;
+      n -= pos + 1;
+      continue;
+    }
+
+    int already;
+    size_t pos = blockPartition(a, n, size, ctx->compare, ctx->compareArg, swap, &already);
+    size_t l = pos, r = n - pos - 1;
+
+    if(l < n / 8 || r < n / 8)
+    {
+      if(!--bad)
+      {
+        introHeapSort(a, n, size, ctx->compare, ctx->compareArg, swap);
+        return;
+      }
+      breakPatterns(a, n, pos, size, swap);
+    }
+    else if(already && partialInsertionSort(a, l, size, ctx, swap) && partialInsertionSort(a + (pos + 1) * size, r, size, ctx, swap)) return;
+
+    pdqLoop(a, l, size, ctx, swap, bad, leftmost);
+    a += (pos + 1) * size;
+    n = r;
+    leftmost = 0;
+  }
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void pdqSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  pdqLoop(data, n, size, ctx, pswapSelect(data, size), log2Floor(n), 1);
+}
+
+/**
+ * @brief defines the type-specialized entry sort_NAME, the same pdqsort with the comparison inlined.
+ */
+#define PDQSORT_TYPED(NAME, TYPE) \
+  BLOCK_PARTITION(NAME, TYPE) \
+  static inline int NAME##Less(TYPE x, TYPE y) \
+  { \
+    COUNT_COMPARE(); \
+    return x < y; \
+  } \
+  static inline void NAME##Sort3(TYPE *x, TYPE *y, TYPE *z) \
+  { \
+    if(NAME##Less(*y, *x)) NAME##BlockSwap(x, y); \
+    if(NAME##Less(*z, *y)) \
+    { \
+      NAME##BlockSwap(y, z); \
+      if(NAME##Less(*y, *x)) NAME##BlockSwap(x, y); \
+    } \
+  } \
+  static size_t NAME##Insertion(TYPE *a, size_t n, size_t limit) \
+  { \
+    size_t i, j, moves = 0; \
+    for(i = 1; i < n; i++) \
+    { \
+      TYPE v = a[i]; \
+      for(j = i; j > 0 && NAME##Less(v, a[j - 1]); j--) \
+      { \
+        COUNT_SWAP(); \
+        a[j] = a[j - 1]; \
+      } \
+      a[j] = v; \
+      moves += i - j; \
+      if(moves > limit) return 0; \
+    } \
+    return 1; \
+  } \
+  static void NAME##SiftDown(TYPE *a, size_t root, size_t n) \
+  { \
+    size_t child; \
+    while((child = 2 * root + 1) < n) \
+    { \
+      if(child + 1 < n && NAME##Less(a[child], a[child + 1])) child++; \
+      if(!NAME##Less(a[root], a[child])) return; \
+      NAME##BlockSwap(a + root, a + child); \
+      root = child; \
+    } \
+  } \
+  static void NAME##HeapSort(TYPE *a, size_t n) \
+  { \
+    size_t i; \
+    for(i = n / 2; i > 0; i--) NAME##SiftDown(a, i - 1, n); \
+    for(i = n - 1; i > 0; i--) \
+    { \
+      NAME##BlockSwap(a, a + i); \
+      NAME##SiftDown(a, 0, i); \
+    } \
+  } \
+  static size_t NAME##PartitionLeft(TYPE *a, size_t n) \
+  { \
+    TYPE pivot = a[0]; \
+    size_t i = 0, j = n; \
+    while(NAME##Less(pivot, a[--j])); \
+    if(j + 1 == n) while(i < j && !NAME##Less(pivot, a[++i])); \
+    else while(!NAME##Less(pivot, a[++i])); \
+    while(i < j) \
+    { \
+      NAME##BlockSwap(a + i, a + j); \
+      while(NAME##Less(pivot, a[--j])); \
+      while(!NAME##Less(pivot, a[++i])); \
+    } \
+    NAME##BlockSwap(a, a + j); \
+    return j; \
+  } \
+  static void NAME##Loop(TYPE *a, size_t n, unsigned bad, int leftmost) \
+  { \
+    for(;;) \
+    { \
+      if(n < INSERTION_THRESHOLD) \
+      { \
+        NAME##Insertion(a, n, SIZE_MAX); \
+        return; \
+      } \
+      size_t h = n / 2; \
+      if(n > NINTHER_THRESHOLD) \
+      { \
+        NAME##Sort3(a, a + h, a + n - 1); \
+        NAME##Sort3(a + 1, a + h - 1, a + n - 2); \
+        NAME##Sort3(a + 2, a + h + 1, a + n - 3); \
+        NAME##Sort3(a + h - 1, a + h, a + h + 1); \
+        NAME##BlockSwap(a, a + h); \
+      } \
+      else NAME##Sort3(a + h, a, a + n - 1); \
+      if(!leftmost && !NAME##Less(a[-1], a[0])) \
+      { \
+        size_t pos = NAME##PartitionLeft(a, n); \
+        a += pos + 1; \
+        n -= pos + 1; \
+        continue; \
+      } \
+      int already; \
+      size_t pos = NAME##BlockPartition(a, n, &already); \
+      size_t l = pos, r = n - pos - 1; \
+      if(l < n / 8 || r < n / 8) \
+      { \
+        if(!--bad) \
+        { \
+          NAME##HeapSort(a, n); \
+          return; \
+        } \
+        if(l >= INSERTION_THRESHOLD) \
+        { \
+          NAME##BlockSwap(a, a + l / 4); \
+          NAME##BlockSwap(a + pos - 1, a + pos - l / 4); \
+          if(l > NINTHER_THRESHOLD) \
+          { \
+            NAME##BlockSwap(a + 1, a + l / 4 + 1); \
+            NAME##BlockSwap(a + 2, a + l / 4 + 2); \
+            NAME##BlockSwap(a + pos - 2, a + pos - (l / 4 + 1)); \
+            NAME##BlockSwap(a + pos - 3, a + pos - (l / 4 + 2)); \
+          } \
+        } \
+        if(r >= INSERTION_THRESHOLD) \
+        { \
+          NAME##BlockSwap(a + pos + 1, a + pos + 1 + r / 4); \
+          NAME##BlockSwap(a + n - 1, a + n - r / 4); \
+          if(r > NINTHER_THRESHOLD) \
+          { \
+            NAME##BlockSwap(a + pos + 2, a + pos + 2 + r / 4); \
+            NAME##BlockSwap(a + pos + 3, a + pos + 3 + r / 4); \
+            NAME##BlockSwap(a + n - 2, a + n - (1 + r / 4)); \
+            NAME##BlockSwap(a + n - 3, a + n - (2 + r / 4)); \
+          } \
+        } \
+      } \
+      else if(already && NAME##Insertion(a, l, PARTIAL_INSERTION_LIMIT) && NAME##Insertion(a + pos + 1, r, PARTIAL_INSERTION_LIMIT)) return; \
+      NAME##Loop(a, l, bad, leftmost); \
+      a += pos + 1; \
+      n = r; \
+      leftmost = 0; \
+    } \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    NAME##Loop(data, n, log2Floor(n), 1); \
+  }
+
+PDQSORT_TYPED(i32, int32_t)
+PDQSORT_TYPED(i64, int64_t)
+PDQSORT_TYPED(u64, uint64_t)
+PDQSORT_TYPED(f32, float)
+PDQSORT_TYPED(f64, double)
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "pdqSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "pdqsort";
+}
@@ -0,0 +1,130 @@
+/**
+ * @file powersort.c
+ * @author Roy Freytag
+ *
+ * powersort(Munro and Wild, "Nearly-Optimal Mergesorts").
+ *
+ * Finds natural runs like TimSort, extending short ones by binary insertion sort, but decides the merges differently:
+ * every boundary between two runs gets a power, the depth of the node splitting their midpoints in a perfectly balanced
+ * merge tree over [0, n). Before a run gets pushed, the runs on the stack with a greater power than its left boundary
+ * get merged. The resulting merge tree is within 2 comparisons per element of the optimal one for the run lengths.
+ * The merges gallop, see gallopmerge.h.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../gallopmerge.h"
+#include "powersort.h"
+
+/**
+ * a pending run
+ */
+typedef struct
+{
+  size_t base; ///< index of the first element
+  size_t len; ///< number of elements
+  unsigned power; ///< power of the boundary to the next run
+} Run_t;
+
+/**
+ * @brief power of the boundary between the runs [s1, s1 + n1) and [s1 + n1, s1 + n1 + n2) of n elements.
+ *
+ * Compares the bits of the binary fractions midpoint / n of both runs, the power is the first bit in which they differ.
+ */
+static unsigned nodePower(size_t s1, size_t n1, size_t n2, size_t n)
+{
+  unsigned power = 0;
+  size_t a = 2 * s1 + n1; //twice the midpoints
+  size_t b = a + n1 + n2;
+  for(;;)
+  {
+    power++;
+    if(a >= n)
+    {
+      a -= n;
+      b -= n;
+    }
+    else if(b >= n) break;
+    a <<= 1;
+    b <<= 1;
+  }
+  return power;
+}
+
+/**
+ * @brief merges the runs i and i + 1 of the stack.
+ */
+static void mergeAt(MergeState_t *ms, char *a, Run_t *runs, size_t *count, size_t i)
+{
+  mergeRuns(ms, a + runs[i].base * ms->size, runs[i].len, runs[i + 1].len);
+  runs[i].len += runs[i + 1].len;
+  runs[i].power = runs[i + 1].power;
+  if(i + 2 < *count) runs[i + 1] = runs[i + 2];
+  (*count)--;
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void powerSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  MergeState_t ms;
+  mergeInit(&ms, data, size, ctx);
+
+  char *a = data;
+  Run_t runs[MAX_RUNS];
+  size_t count = 0, lo = 0, minRun = minRunLength(n);
+  while(lo < n)
+  {
+    size_t len = countRun(&ms, a + lo * size, n - lo);
+    if(len < minRun)
+    {
+      size_t force = (n - lo < minRun)?n - lo:minRun;
+      binaryInsertionSort(&ms, a + lo * size, force, len);
+      len = force;
+    }
+    if(count)
+    {
+      unsigned power = nodePower(runs[count - 1].base, runs[count - 1].len, len, n);
+      while(count > 1 && runs[count - 2].power > power) mergeAt(&ms, a, runs, &count, count - 2);
+      runs[count - 1].power = power;
+    }
+    runs[count].base = lo;
+    runs[count].len = len;
+    runs[count].power = 0;
+    count++;
+    lo += len;
+  }
+
+  while(count > 1) mergeAt(&ms, a, runs, &count, count - 2);
+
+  mergeFree(&ms);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_STABLE | SORT_CAP_SCRATCH,
+  0,
+  1,
+  "powerSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Powersort";
+}
@@ -0,0 +1,9 @@
+#ifndef __POWERSORT_H_
+#define __POWERSORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void powerSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __POWERSORT_H_ */
@@ -0,0 +1,102 @@
+/**
+ * @file quickselect.c
+ * @author Roy Freytag
+ *
+ * quickselect(Hoare's FIND).
+ *
+ * Partitions around the middle element and continues with the side holding index k only, which takes O(n) time on average
+ * and O(n^2) in the worst case. The context entry is the quicksort it comes from, recursing into the smaller side.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../select.h"
+#include "quickselect.h"
+
+/**
+ * @brief partitions a range of more than one element around its middle element.
+ * @return final index of the pivot.
+ */
+static size_t partitionMiddle(SelectState_t *ss, char *a, size_t n)
+{
+  ss->swap(a, a + n / 2 * ss->size, ss->size);
+  return selectPartition(ss, a, n);
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void quickSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  char *a = data;
+  while(n > SELECT_INSERTION)
+  {
+    size_t p = partitionMiddle(&ss, a, n);
+    if(p < n - p - 1)
+    {
+      quickSelectSort(a, p, size, ctx);
+      a += (p + 1) * size;
+      n -= p + 1;
+    }
+    else
+    {
+      quickSelectSort(a + (p + 1) * size, n - p - 1, size, ctx);
+      n = p;
+    }
+  }
+  selectInsertion(&ss, a, n);
+}
+
+/**
+ * @brief selection entry, see sortSelectFn_t.
+ */
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx)
+{
+  if(!data || k >= n) return;
+
+  SelectState_t ss;
+  selectInit(&ss, data, size, ctx);
+  char *a = data;
+  while(n > SELECT_INSERTION)
+  {
+    size_t p = partitionMiddle(&ss, a, n);
+    if(k == p) return;
+    if(k < p) n = p;
+    else
+    {
+      a += (p + 1) * size;
+      n -= p + 1;
+      k -= p + 1;
+    }
+  }
+  selectInsertion(&ss, a, n);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  0,
+  1,
+  "quickSelectSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Quickselect";
+}
@@ -0,0 +1,10 @@
+#ifndef __QUICKSELECT_H_
+#define __QUICKSELECT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void quickSelectSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+void sortSelect(void *data, size_t n, size_t k, size_t size, SortContext_t *ctx);
+
+#endif /* __QUICKSELECT_H_ */
@@ -2,46 +2,297 @@
 #include <stdio.h>
 #include <errno.h>
 #include <string.h>
+#include <stdint.h>
 #include "../helpers.h"
+#include "../introsort.h"
+#include "../simdkernels.h"
 #include "quicksort.h"
 
+#define NINTHER_THRESHOLD 128 ///< ranges above this size take the pivot as median of three medians of three(ninther)
 
-static void quickSortPartition(void* array, size_t size, int s, int e, int (*fcomp)(void*,void*))
+/**
+ * @brief sorts the elements at a, b and c.
+ */
+static void sort3(char *a, char *b, char *c, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
 {
+  if(cmp(b, a, arg) < 0) swap(a, b, size);
+  if(cmp(c, b, arg) < 0)
+  {
+    swap(b, c, size);
+    if(cmp(b, a, arg) < 0) swap(a, b, size);
+  }
+}
 
-  if((e - s) <= 0) return;
+/**
+ * @brief moves the pivot to the front of the range.
+ *
+ * Takes the median of the first, middle and last element, or the ninther for larger ranges.
+ * @return 1 if the samples contained equal keys, which hints at many duplicates.
+ */
+static int choosePivot(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  char *m = a + (n / 2) * size, *z = a + (n - 1) * size;
+  if(n > NINTHER_THRESHOLD)
+  {
+    size_t e = n / 8;
+    sort3(a, a + e * size, a + 2 * e * size, size, cmp, arg, swap);
+    sort3(m - e * size, m, m + e * size, size, cmp, arg, swap);
+    sort3(z - 2 * e * size, z - e * size, z, size, cmp, arg, swap);
+    sort3(a + e * size, m, z - e * size, size, cmp, arg, swap);
+    swap(a, m, size);
+    return !cmp(a + e * size, a, arg) || !cmp(a, z - e * size, arg);
+  }
+  sort3(a, m, z, size, cmp, arg, swap);
+  swap(a, m, size);
+  return !cmp(m, a, arg) || !cmp(a, z, arg);
+}
 
-  int p = (e - s) / 2 + s;
-  pswap(voidAdd(array, size, p), voidAdd(array, size, e), size);
-  void *pval = voidAdd(array, size, e);
+/**
+ * @brief Hoare partitioning around the pivot at the front of the range.
+ *
+ * Both scans stop at keys equal to the pivot, so runs of equal keys still get split in the middle.
+ * @return index of the pivot afterwards.
+ */
+static size_t partitionHoare(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i = 0, j = n;
+  for(;;)
+  {
+    do i++; while(i < n && cmp(a + i * size, a, arg) < 0);
+    do j--; while(cmp(a + j * size, a, arg) > 0); //stops at the pivot at the latest
+    if(i >= j) break;
+    swap(a + i * size, a + j * size, size);
+  }
+  swap(a, a + j * size, size);
+  return j;
+}
+
+/**
+ * @brief three-way partitioning(Dijkstra) around the pivot at the front of the range.
+ *
+ * Afterwards [0, *lt) is less than the pivot, [*lt, *gt) equal to it and [*gt, n) greater.
+ * The first element of the equal part is always a copy of the pivot, so it gets compared against.
+ */
+static void partition3(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap, size_t *lt, size_t *gt)
+{
+  size_t l = 0, i = 1, g = n;
+  while(i < g)
+  {
+    int c = cmp(a + i * size, a + l * size, arg);
+    if(c < 0)
+    {
+      swap(a + l * size, a + i * size, size);
+      l++;
+      i++;
+    }
+    else if(c > 0) swap(a + i * size, a + --g * size, size);
+    else i++;
+  }
+  *lt = l;
+  *gt = g;
+}
 
-  int si = s;
-  int i;
-  for(i = s; i <= e-1; i++)
+/**
+ * @brief introsort, recursing into the smaller part and looping on the larger one, so the stack stays at O(log n).
+ */
+static void sortRange(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap, unsigned depth)
+{
+  while(n > INTRO_INSERTION)
   {
-    if(fcomp(voidAdd(array, size, i), pval) < 0)
+    if(!depth--)
+    {
+      introHeapSort(a, n, size, cmp, arg, swap);
+      return;
+    }
+
+    size_t lo, hi; //the parts left to sort are [0, lo) and [hi, n)
+    if(choosePivot(a, n, size, cmp, arg, swap)) partition3(a, n, size, cmp, arg, swap, &lo, &hi);
+    else
     {
-      pswap(voidAdd(array, size, si), voidAdd(array, size, i), size);
-      si++;
+      lo = partitionHoare(a, n, size, cmp, arg, swap);
+      hi = lo + 1;
+    }
+
+    if(lo < n - hi)
+    {
+      sortRange(a, lo, size, cmp, arg, swap, depth);
+      a += hi * size;
+      n -= hi;
+    }
+    else
+    {
+      sortRange(a + hi * size, n - hi, size, cmp, arg, swap, depth);
+      n = lo;
     }
   }
-  pswap(voidAdd(array, size, si), voidAdd(array, size, e), size);
-  p = si;
+  introInsertion(a, n, size, cmp, arg, swap);
+}
 
-  quickSortPartition(array, size, s, p-1, fcomp);
-  quickSortPartition(array, size, p+1, e, fcomp);
+/**
+ * @brief calls the two-argument comparison function of the generic entry, which gets passed as the argument.
+ */
+static int compareLegacy(const void *x, const void *y, void *arg)
+{
+  return (*(int (**)(void*, void*))arg)((void*)x, (void*)y);
 }
 
 void sort(void *data, size_t n, size_t s, int (*fcomp)(void*, void*))
 {
   if(!data) return;
-  if(n == 0) return;
-
-  quickSortPartition(data, s, 0, n-1, fcomp);
+  if(n < 2) return;
 
-  //return data;
+  sortRange(data, n, s, compareLegacy, &fcomp, pswapSelect(data, s), introDepthLimit(n));
 }
 
+/**
+ * @brief defines the type-specialized entry sort_NAME, the same introsort with the comparison inlined.
+ *
+ * Ranges up to SMALL_MAX elements get sorted by SMALL, the SIMD sorting networks for the key types simdkernels.c has them for.
+ */
+#define QUICKSORT_TYPED(NAME, TYPE, SMALL_MAX, SMALL) \
+  static inline void NAME##Swap(TYPE *x, TYPE *y) \
+  { \
+    TYPE tmp = *x; \
+    COUNT_SWAP(); \
+    *x = *y; \
+    *y = tmp; \
+  } \
+  static inline int NAME##Less(TYPE x, TYPE y) \
+  { \
+    COUNT_COMPARE(); \
+    return x < y; \
+  } \
+  static inline void NAME##Sort3(TYPE *x, TYPE *y, TYPE *z) \
+  { \
+    if(NAME##Less(*y, *x)) NAME##Swap(x, y); \
+    if(NAME##Less(*z, *y)) \
+    { \
+      NAME##Swap(y, z); \
+      if(NAME##Less(*y, *x)) NAME##Swap(x, y); \
+    } \
+  } \
+  static inline void NAME##Insertion(TYPE *a, size_t n) \
+  { \
+    size_t i, j; \
+    for(i = 1; i < n; i++) \
+    { \
+      TYPE v = a[i]; \
+      for(j = i; j > 0 && NAME##Less(v, a[j - 1]); j--) \
+      { \
+        COUNT_SWAP(); \
+        a[j] = a[j - 1]; \
+      } \
+      a[j] = v; \
+    } \
+  } \
+  static void NAME##SiftDown(TYPE *a, size_t root, size_t n) \
+  { \
+    size_t child; \
+    while((child = 2 * root + 1) < n) \
+    { \
+      if(child + 1 < n && NAME##Less(a[child], a[child + 1])) child++; \
+      if(!NAME##Less(a[root], a[child])) return; \
+      NAME##Swap(a + root, a + child); \
+      root = child; \
+    } \
+  } \
+  static void NAME##HeapSort(TYPE *a, size_t n) \
+  { \
+    size_t i; \
+    for(i = n / 2; i > 0; i--) NAME##SiftDown(a, i - 1, n); \
+    for(i = n - 1; i > 0; i--) \
+    { \
+      NAME##Swap(a, a + i); \
+      NAME##SiftDown(a, 0, i); \
+    } \
+  } \
+  static void NAME##IntroSort(TYPE *a, size_t n, unsigned depth) \
+  { \
+    while(n > SMALL_MAX) \
+    { \
+      if(!depth--) \
+      { \
+        NAME##HeapSort(a, n); \
+        return; \
+      } \
+      size_t m = n / 2, e = n / 8, lo, hi; \
+      int duplicates; \
+      if(n > NINTHER_THRESHOLD) \
+      { \
+        NAME##Sort3(a, a + e, a + 2 * e); \
+        NAME##Sort3(a + m - e, a + m, a + m + e); \
+        NAME##Sort3(a + n - 1 - 2 * e, a + n - 1 - e, a + n - 1); \
+        NAME##Sort3(a + e, a + m, a + n - 1 - e); \
+        NAME##Swap(a, a + m); \
+        duplicates = !NAME##Less(a[e], a[0]) || !NAME##Less(a[0], a[n - 1 - e]); \
+      } \
+      else \
+      { \
+        NAME##Sort3(a, a + m, a + n - 1); \
+        NAME##Swap(a, a + m); \
+        duplicates = !NAME##Less(a[m], a[0]) || !NAME##Less(a[0], a[n - 1]); \
+      } \
+      TYPE pivot = a[0]; \
+      if(duplicates) \
+      { \
+        size_t i = 1; \
+        lo = 0; \
+        hi = n; \
+        while(i < hi) \
+        { \
+          if(NAME##Less(a[i], pivot)) NAME##Swap(a + lo++, a + i++); \
+          else if(NAME##Less(pivot, a[i])) NAME##Swap(a + i, a + --hi); \
+          else i++; \
+        } \
+      } \
+      else \
+      { \
+        size_t i = 0, j = n; \
+        for(;;) \
+        { \
+          do i++; while(i < n && NAME##Less(a[i], pivot)); \
+          do j--; while(NAME##Less(pivot, a[j])); \
+          if(i >= j) break; \
+          NAME##Swap(a + i, a + j); \
+        } \
+        NAME##Swap(a, a + j); \
+        lo = j; \
+        hi = j + 1; \
+      } \
+      if(lo < n - hi) \
+      { \
+        NAME##IntroSort(a, lo, depth); \
+        a += hi; \
+        n -= hi; \
+      } \
+      else \
+      { \
+        NAME##IntroSort(a + hi, n - hi, depth); \
+        n = lo; \
+      } \
+    } \
+    SMALL(a, n); \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    NAME##IntroSort(data, n, introDepthLimit(n)); \
+  }
+
+#ifdef SORT_INSTRUMENTED
+//the sorting networks count no comparisons, so the instrumented build insertion sorts the small ranges of all types
+QUICKSORT_TYPED(i32, int32_t, INTRO_INSERTION, i32Insertion)
+QUICKSORT_TYPED(i64, int64_t, INTRO_INSERTION, i64Insertion)
+QUICKSORT_TYPED(f32, float, INTRO_INSERTION, f32Insertion)
+QUICKSORT_TYPED(f64, double, INTRO_INSERTION, f64Insertion)
+#else
+QUICKSORT_TYPED(i32, int32_t, SIMD_SMALL_MAX, simdSmallSort_i32)
+QUICKSORT_TYPED(i64, int64_t, SIMD_SMALL_MAX, simdSmallSort_i64)
+QUICKSORT_TYPED(f32, float, SIMD_SMALL_MAX, simdSmallSort_f32)
+QUICKSORT_TYPED(f64, double, SIMD_SMALL_MAX, simdSmallSort_f64)
+#endif
+QUICKSORT_TYPED(u64, uint64_t, INTRO_INSERTION, u64Insertion)
+
 char* getSortName(void)
 {
   return "Quicksort";
@@ -50,4 +301,4 @@ char* getSortName(void)
 char* getSortSymbol(void)
 {
   return "sort";
-}
\ No newline at end of file
+}
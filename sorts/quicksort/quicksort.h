@@ -7,4 +7,11 @@
 //void quickSortPartition(void** array, int s, int e, int (*fcomp)(void*,void*));
 void sort(void *data, size_t n, size_t s, int (*fcomp)(void*, void*));
 
+//type-specialized entries
+void sort_i32(void *data, size_t n);
+void sort_i64(void *data, size_t n);
+void sort_u64(void *data, size_t n);
+void sort_f32(void *data, size_t n);
+void sort_f64(void *data, size_t n);
+
 #endif /* QUICKSORT_H_ */
@@ -0,0 +1,66 @@
+/**
+ * @file radixkeys.h
+ * @author Roy Freytag
+ *
+ * key transforms for radix sorts.
+ *
+ * Every key gets turned into an unsigned integer of the same width, which orders like the key,
+ * so the radix sorts only have to deal with unsigned digits:
+ * - signed integers get their sign bit flipped.
+ * - floats get all bits flipped if negative, only the sign bit otherwise(no NaNs).
+ *
+ * RADIX_KEY_TYPES(X) calls X(NAME, SORT_KEY, UKEY, KEYFN) for every supported key type,
+ * KEYFN loads the transformed key from an unaligned pointer.
+ */
+#ifndef __RADIXKEYS_H__
+#define __RADIXKEYS_H__
+
+#include <stdint.h>
+#include <string.h>
+
+static inline uint32_t radixKeyU32(const void *p)
+{
+  uint32_t u;
+  memcpy(&u, p, sizeof(u));
+  return u;
+}
+
+static inline uint64_t radixKeyU64(const void *p)
+{
+  uint64_t u;
+  memcpy(&u, p, sizeof(u));
+  return u;
+}
+
+static inline uint32_t radixKeyI32(const void *p)
+{
+  return radixKeyU32(p) ^ 0x80000000U;
+}
+
+static inline uint64_t radixKeyI64(const void *p)
+{
+  return radixKeyU64(p) ^ 0x8000000000000000ULL;
+}
+
+static inline uint32_t radixKeyF32(const void *p)
+{
+  uint32_t u = radixKeyU32(p);
+  return u ^ ((uint32_t)-(int32_t)(u >> 31) | 0x80000000U);
+}
+
+static inline uint64_t radixKeyF64(const void *p)
+{
+  uint64_t u = radixKeyU64(p);
+  return u ^ ((uint64_t)-(int64_t)(u >> 63) | 0x8000000000000000ULL);
+}
+
+#define RADIX_KEY_TYPES(X) \
+  X(i32, SORT_KEY_I32, uint32_t, radixKeyI32) \
+  X(i64, SORT_KEY_I64, uint64_t, radixKeyI64) \
+  X(u64, SORT_KEY_U64, uint64_t, radixKeyU64) \
+  X(f32, SORT_KEY_F32, uint32_t, radixKeyF32) \
+  X(f64, SORT_KEY_F64, uint64_t, radixKeyF64)
+
+#define RADIX_KEY_MASK (SORT_KEY_I32 | SORT_KEY_I64 | SORT_KEY_U64 | SORT_KEY_F32 | SORT_KEY_F64) ///< key types RADIX_KEY_TYPES() covers
+
+#endif
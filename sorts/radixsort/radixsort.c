@@ -0,0 +1,138 @@
+/**
+ * @file radixsort.c
+ * @author Roy Freytag
+ *
+ * LSD radix sort with DIGIT_BITS bit digits.
+ *
+ * One pass over the elements counts the digits of all passes at once, every pass afterwards only scatters.
+ * Passes whose digit is the same for all elements get skipped, e.g. the upper digits of small keys.
+ * The elements move between the input and a scratch buffer of the same size, so the sort is stable.
+ * Elements without a key the digits can be taken from go to stablemerge.h's merge sort, which is stable as well.
+ * Built once per digit width, see the makefile.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../stablemerge.h"
+#include "../radixkeys.h"
+#include "radixsort.h"
+
+#ifndef DIGIT_BITS
+#define DIGIT_BITS 8 ///< bits per digit
+#endif
+
+#define DIGIT_MASK ((1U << DIGIT_BITS) - 1) ///< mask of a single digit
+#define STR(x) #x
+#define XSTR(x) STR(x)
+
+/**
+ * @brief defines radixNAME(), sorting elements of size bytes by the key of type NAME at offset.
+ *
+ * The typed entries call it with constant sizes, so the compiler can specialize it.
+ */
+#define LSD_RADIX(NAME, SORT_KEY, UKEY, KEYFN) \
+  static inline int radix##NAME(char *data, char *scratch, size_t n, size_t size, size_t offset) \
+  { \
+    enum { PASSES = (sizeof(UKEY) * 8 + DIGIT_BITS - 1) / DIGIT_BITS }; \
+    size_t *counts = calloc((size_t)PASSES << DIGIT_BITS, sizeof(size_t)); \
+    char *tmp = scratch?scratch:malloc(n * size); \
+    size_t i; \
+    unsigned p; \
+    if(!counts || !tmp) \
+    { \
+      free(counts); \
+      if(!scratch) free(tmp); \
+      return -1; \
+    } \
+    for(i = 0; i < n; i++) \
+    { \
+      UKEY k = KEYFN(data + i * size + offset); \
+      for(p = 0; p < PASSES; p++) counts[(p << DIGIT_BITS) | ((k >> (p * DIGIT_BITS)) & DIGIT_MASK)]++; \
+    } \
+    char *src = data, *dst = tmp; \
+    UKEY first = KEYFN(data + offset); \
+    for(p = 0; p < PASSES; p++) \
+    { \
+      size_t *c = counts + ((size_t)p << DIGIT_BITS); \
+      unsigned shift = p * DIGIT_BITS; \
+      if(c[(first >> shift) & DIGIT_MASK] == n) continue; /*trivial digit*/ \
+      size_t sum = 0, d; \
+      for(d = 0; d <= DIGIT_MASK; d++) \
+      { \
+        size_t t = c[d]; \
+        c[d] = sum; \
+        sum += t; \
+      } \
+      for(i = 0; i < n; i++) \
+      { \
+        const char *e = src + i * size; \
+        memcpy(dst + c[(KEYFN(e + offset) >> shift) & DIGIT_MASK]++ * size, e, size); \
+      } \
+      char *t = src; \
+      src = dst; \
+      dst = t; \
+    } \
+    if(src != data) memcpy(data, src, n * size); \
+    free(counts); \
+    if(!scratch) free(tmp); \
+    return 0; \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    radix##NAME(data, 0, n, sizeof(UKEY), 0); \
+  }
+
+RADIX_KEY_TYPES(LSD_RADIX)
+
+/**
+ * @brief context-taking entry, sorts any elements with a supported key at some offset, e.g. records.
+ *
+ * Without a key type, e.g. for the killer input, or without memory for the scratch buffer it falls back to a merge sort,
+ * merging in place if there is no buffer at all, so the elements stay stable.
+ */
+void radixSortCtx(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  char *scratch = (ctx->scratchSize >= n * size)?ctx->scratch:0;
+  int res = -1;
+  switch(ctx->keyType)
+  {
+#define LSD_CASE(NAME, SORT_KEY, UKEY, KEYFN) \
+    case SORT_KEY: \
+      res = radix##NAME(data, scratch, n, size, ctx->keyOffset); \
+      break;
+    RADIX_KEY_TYPES(LSD_CASE)
+  }
+  if(!res) return;
+
+  char *buffer = scratch?scratch:malloc(n * size);
+  stableMergeSort(data, n, size, ctx->compare, ctx->compareArg, pswapSelect(data, size), buffer);
+  if(buffer != scratch) free(buffer);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_STABLE | SORT_CAP_SCRATCH,
+  RADIX_KEY_MASK,
+  1,
+  "radixSortCtx"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "LSD Radix " XSTR(DIGIT_BITS) "bit";
+}
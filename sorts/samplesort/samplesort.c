@@ -0,0 +1,228 @@
+/**
+ * @file samplesort.c
+ * @author Roy Freytag
+ *
+ * parallel samplesort.
+ *
+ * A random sample of the elements gets sorted and every OVERSAMPLING-th element of it becomes a splitter,
+ * dividing the keys into BUCKETS_PER_THREAD buckets per thread. Every thread classifies a slice of the elements
+ * by binary search over the splitters and counts its buckets, the counts give every thread its place in every bucket.
+ * Then the threads copy their elements into their buckets in the scratch buffer, afterwards each bucket gets
+ * sorted on its own by the introsort of introsort.h and copied back. Threads take the buckets one by one, so heavy
+ * buckets don't stall the others.
+ *
+ * If the sample repeats a splitter, its key is frequent: the splitters get deduplicated and every one of them gets an
+ * equality bucket of the elements equal to it next to the bucket of the elements between it and the next one.
+ * Equality buckets are sorted already, so few distinct keys don't end up in a single bucket sorted by a single thread.
+ * A single thread runs the same phases, only arrays up to SEQUENTIAL_LIMIT elements get sorted by the introsort directly.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../introsort.h"
+#include "samplesort.h"
+
+#define OVERSAMPLING 32 ///< sample elements per bucket
+#define BUCKETS_PER_THREAD 4 ///< buckets per thread, more of them balance the last phase better
+#define SEQUENTIAL_LIMIT 16384 ///< arrays up to this size get sorted sequentially
+
+/**
+ * state shared by the threads of a sort call
+ */
+typedef struct
+{
+  char *data; ///< elements
+  char *scratch; ///< buffer of n elements the buckets are gathered in
+  size_t n; ///< number of elements
+  size_t size; ///< size of an element
+  SortContext_t *ctx; ///< comparison function
+  char *splitters; ///< sorted splitters, distinct if equality is set
+  unsigned splitterCount; ///< number of splitters
+  int equality; ///< 1 if every splitter has an equality bucket, the odd ones
+  unsigned buckets; ///< number of buckets
+  uint16_t *oracle; ///< bucket of every element
+  size_t *counts; ///< elements per thread and bucket, later the offsets in scratch
+  size_t *bucketStart; ///< first element of every bucket in scratch, plus the end
+  atomic_uint nextBucket; ///< next bucket to sort in the last phase
+  Barrier_t barrier; ///< separates the phases
+} Shared_t;
+
+/**
+ * @brief finds the bucket of an element.
+ *
+ * Elements equal to a splitter go to its equality bucket if there are such, to the bucket right of it otherwise.
+ */
+static inline unsigned classify(Shared_t *s, const char *e)
+{
+  unsigned lo = 0, hi = s->splitterCount; //searching the splitters, hi is an exclusive bound
+  while(lo < hi)
+  {
+    unsigned mid = (lo + hi) / 2;
+    if(s->ctx->compare(e, s->splitters + mid * s->size, s->ctx->compareArg) < 0) hi = mid;
+    else lo = mid + 1;
+  }
+  //lo splitters are less or equal
+  if(!s->equality) return lo;
+  if(lo && !s->ctx->compare(e, s->splitters + (lo - 1) * s->size, s->ctx->compareArg)) return 2 * lo - 1;
+  return 2 * lo;
+}
+
+/**
+ * @brief sorts a range on the calling thread.
+ */
+static void sequentialSort(char *a, size_t n, size_t size, SortContext_t *ctx)
+{
+  introSort(a, n, size, ctx->compare, ctx->compareArg, pswapSelect(a, size), introDepthLimit(n));
+}
+
+/**
+ * @brief work of a single thread, see the file description.
+ */
+static void worker(unsigned thread, unsigned threads, void *arg)
+{
+  Shared_t *s = arg;
+  size_t begin = s->n * thread / threads, end = s->n * (thread + 1) / threads;
+  size_t *counts = s->counts + (size_t)thread * s->buckets;
+  size_t i;
+  unsigned b, t;
+
+  //classify
+  for(i = begin; i < end; i++)
+  {
+    b = classify(s, s->data + i * s->size);
+    s->oracle[i] = b;
+    counts[b]++;
+  }
+  barrierWait(&s->barrier, threads);
+
+  //the first thread turns the counts into offsets, bucket by bucket and thread by thread
+  if(thread == 0)
+  {
+    size_t sum = 0;
+    for(b = 0; b < s->buckets; b++)
+    {
+      s->bucketStart[b] = sum;
+      for(t = 0; t < threads; t++)
+      {
+        size_t c = s->counts[(size_t)t * s->buckets + b];
+        s->counts[(size_t)t * s->buckets + b] = sum;
+        sum += c;
+      }
+    }
+    s->bucketStart[s->buckets] = sum;
+  }
+  barrierWait(&s->barrier, threads);
+
+  //distribute
+  for(i = begin; i < end; i++) memcpy(s->scratch + counts[s->oracle[i]]++ * s->size, s->data + i * s->size, s->size);
+  barrierWait(&s->barrier, threads);
+
+  //sort the buckets
+  while((b = atomic_fetch_add(&s->nextBucket, 1)) < s->buckets)
+  {
+    size_t start = s->bucketStart[b], count = s->bucketStart[b + 1] - start;
+    if(!s->equality || !(b & 1)) sequentialSort(s->scratch + start * s->size, count, s->size, s->ctx);
+    memcpy(s->data + start * s->size, s->scratch + start * s->size, count * s->size);
+  }
+}
+
+/**
+ * @brief context-taking entry, sorts with ctx->threads threads.
+ */
+void sampleSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  unsigned threads = ctx->threads?ctx->threads:1;
+  if(n <= SEQUENTIAL_LIMIT)
+  {
+    sequentialSort(data, n, size, ctx);
+    return;
+  }
+
+  Shared_t s;
+  s.data = data;
+  s.n = n;
+  s.size = size;
+  s.ctx = ctx;
+  //buckets without equality buckets, which at most double them
+  unsigned buckets = threads * BUCKETS_PER_THREAD;
+  if(buckets > UINT16_MAX / 2) buckets = UINT16_MAX / 2;
+  size_t samples = (size_t)buckets * OVERSAMPLING;
+  s.scratch = (ctx->scratchSize >= n * size)?ctx->scratch:malloc(n * size);
+  char *sample = malloc(samples * size);
+  s.splitters = malloc(buckets * size);
+  s.oracle = malloc(n * sizeof(uint16_t));
+  s.counts = calloc((size_t)threads * (2 * buckets + 1), sizeof(size_t));
+  s.bucketStart = malloc((2 * buckets + 2) * sizeof(size_t));
+  if(!s.scratch || !sample || !s.splitters || !s.oracle || !s.counts || !s.bucketStart)
+  {
+    sequentialSort(data, n, size, ctx);
+  }
+  else
+  {
+    //take a random sample, a fixed seed keeps the runs comparable
+    uint64_t x = 0x9e3779b97f4a7c15ULL;
+    size_t i;
+    for(i = 0; i < samples; i++)
+    {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+      memcpy(sample + i * size, (char*)data + (x % n) * size, size);
+    }
+    sequentialSort(sample, samples, size, ctx);
+
+    //repeated splitters are kept once and get equality buckets
+    s.splitterCount = 0;
+    s.equality = 0;
+    for(i = 1; i < buckets; i++)
+    {
+      char *splitter = sample + i * OVERSAMPLING * size;
+      if(s.splitterCount && !ctx->compare(splitter, s.splitters + (s.splitterCount - 1) * size, ctx->compareArg)) s.equality = 1;
+      else memcpy(s.splitters + s.splitterCount++ * size, splitter, size);
+    }
+    s.buckets = s.equality?2 * s.splitterCount + 1:s.splitterCount + 1;
+
+    atomic_init(&s.nextBucket, 0);
+    barrierInit(&s.barrier);
+    runThreads(threads, worker, &s);
+    barrierDestroy(&s.barrier);
+  }
+
+  if(s.scratch != ctx->scratch) free(s.scratch);
+  free(sample);
+  free(s.splitters);
+  free(s.oracle);
+  free(s.counts);
+  free(s.bucketStart);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_PARALLEL | SORT_CAP_SCRATCH,
+  0,
+  0,
+  "sampleSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "Samplesort";
+}
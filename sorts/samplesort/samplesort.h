@@ -0,0 +1,9 @@
+#ifndef __SAMPLESORT_H_
+#define __SAMPLESORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void sampleSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __SAMPLESORT_H_ */
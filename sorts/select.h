@@ -0,0 +1,124 @@
+/**
+ * @file select.h
+ * @author Roy Freytag
+ *
+ * building blocks of the selection and partial-sort modules, for elements of any size compared by the comparison function of the context.
+ *
+ * selectPartition() partitions a range around its first element and returns where that ends up, equal elements stop both scans,
+ * so ranges of equal keys get split in half. heapSelect() moves the k smallest elements of a range into a max-heap at its front in
+ * O(n log k), it is the top-k module as well as the worst-case fallback of introselect. Short ranges get insertion sorted.
+ * Insertion sort, median of three, partition and sifting are the ones of introsort.h, on the state of a selection call.
+ */
+#ifndef __SELECT_H__
+#define __SELECT_H__
+
+#include <stdlib.h>
+#include "../sorting_lib.h"
+#include "helpers.h"
+#include "introsort.h"
+
+#define SELECT_INSERTION INTRO_INSERTION ///< ranges up to this size get insertion sorted instead of partitioned
+
+/**
+ * state of a selection call
+ */
+typedef struct
+{
+  size_t size; ///< element size
+  int (*cmp)(const void*, const void*, void*); ///< comparison function
+  void *arg; ///< argument for cmp
+  swapFn_t swap; ///< swap kernel
+} SelectState_t;
+
+/**
+ * @brief sets up the state for a selection call.
+ */
+static inline void selectInit(SelectState_t *ss, void *data, size_t size, SortContext_t *ctx)
+{
+  ss->size = size;
+  ss->cmp = ctx->compare;
+  ss->arg = ctx->compareArg;
+  ss->swap = pswapSelect(data, size);
+}
+
+/**
+ * @brief 1 if the element at x is less than the one at y.
+ */
+static inline int selectLess(SelectState_t *ss, const char *x, const char *y)
+{
+  return ss->cmp(x, y, ss->arg) < 0;
+}
+
+/**
+ * @brief sorts a short range by insertion.
+ */
+static inline void selectInsertion(SelectState_t *ss, char *a, size_t n)
+{
+  introInsertion(a, n, ss->size, ss->cmp, ss->arg, ss->swap);
+}
+
+/**
+ * @brief moves the median of the first, middle and last element of a range to its front.
+ */
+static inline void selectMedian3(SelectState_t *ss, char *a, size_t n)
+{
+  introMedian3(a, n, ss->size, ss->cmp, ss->arg, ss->swap);
+}
+
+/**
+ * @brief partitions a range around its first element.
+ * @return index the first element ends up at, no element before it is greater and none after it is less.
+ */
+static inline size_t selectPartition(SelectState_t *ss, char *a, size_t n)
+{
+  return introPartition(a, n, ss->size, ss->cmp, ss->arg, ss->swap);
+}
+
+/**
+ * @brief restores the max-heap property below node i of a heap of n elements.
+ */
+static inline void heapSift(SelectState_t *ss, char *a, size_t n, size_t i)
+{
+  introSiftDown(a, i, n, ss->size, ss->cmp, ss->arg, ss->swap);
+}
+
+/**
+ * @brief turns the first k elements of a range into a max-heap of its k smallest elements.
+ *
+ * Every element behind the heap that is less than its root replaces the root.
+ */
+static inline void heapSelect(SelectState_t *ss, char *a, size_t n, size_t k)
+{
+  size_t i, size = ss->size;
+  if(!k) return;
+  for(i = k / 2; i > 0; i--) heapSift(ss, a, k, i - 1);
+  for(i = k; i < n; i++)
+  {
+    if(!selectLess(ss, a + i * size, a)) continue;
+    ss->swap(a, a + i * size, size);
+    heapSift(ss, a, k, 0);
+  }
+}
+
+/**
+ * @brief sorts a max-heap of n elements in place.
+ */
+static inline void heapSortHeap(SelectState_t *ss, char *a, size_t n)
+{
+  for(; n > 1; n--)
+  {
+    ss->swap(a, a + (n - 1) * ss->size, ss->size);
+    heapSift(ss, a, n - 1, 0);
+  }
+}
+
+/**
+ * @brief moves the element a full sort would put at index k of a range there, by a heap of the k + 1 smallest elements.
+ */
+static inline void heapSelectNth(SelectState_t *ss, char *a, size_t n, size_t k)
+{
+  heapSelect(ss, a, n, k + 1);
+  ss->swap(a, a + k * ss->size, ss->size); //the root is the largest of the k + 1 smallest
+}
+
+#endif
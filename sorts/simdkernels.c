@@ -0,0 +1,620 @@
+/**
+ * @file simdkernels.c
+ * @author Roy Freytag
+ *
+ * SIMD sorting networks and bitonic merges for 32 and 64 bit keys.
+ *
+ * Every instruction set brings a handful of primitives per key type(load, store, min, max, exchanging lanes,
+ * reversing and selecting lanes by a bit mask), SIMD_ALGORITHMS() builds the kernels from them:
+ * - Small: pads up to SIMD_SMALL_MAX elements to a power of two with the largest key and runs a bitonic sorting network.
+ *   Compare-exchanges between lanes at least a vector apart are min/max of whole vectors, those within a vector exchange
+ *   the lanes first and select the minimum or maximum per lane.
+ * - Merge: merges two sorted arrays a vector at a time(Inoue et al., "AA-Sort"). The vector merged last holds the largest
+ *   elements seen so far, it gets merged with the next vector of the array with the smaller head by a bitonic merge network
+ *   and the smaller half is written out. Tails of less than a vector are merged scalar.
+ * - Partition(int32 and int64 only): moves the keys less than a pivot to the front in place(Bramas, "A Novel Hybrid Quicksort
+ *   Algorithm Vectorized using AVX-512 on Intel Skylake"). A vector from each end is kept aside, then the loop reads the next vector
+ *   from the end with less free space, which leaves at least a vector of space on both ends, and writes its smaller keys to the
+ *   front and the others to the back. AVX-512 compress-stores them, AVX2 permutes them by a table and stores whole vectors.
+ * The functions get compiled for their instruction set through the target attribute, so the library builds without any
+ * -m flags, and a constructor picks the best set the CPU supports. The environment variable SORT_SIMD(scalar, sse, avx2 or
+ * avx512) lowers the level, e.g. to compare the kernels on the same machine.
+ * The kernels don't count comparisons or swaps, a vector min/max is neither.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <immintrin.h>
+#include "simdkernels.h"
+
+#define SSE_ATTR __attribute__((target("sse4.2")))
+#define AVX2_ATTR __attribute__((target("avx2")))
+#define AVX512_ATTR __attribute__((target("avx512f")))
+
+/**
+ * @brief bit mask of the lanes out of lanes whose index has bit b set.
+ */
+static inline unsigned laneBits(unsigned lanes, size_t b)
+{
+  unsigned i, bits = 0;
+  for(i = 0; i < lanes; i++) if(i & b) bits |= 1u << i;
+  return bits;
+}
+
+/**
+ * @brief defines the scalar fallbacks of a key type: insertion sort, a two-way merge and the three-way merge of the tails.
+ */
+#define SCALAR_ALGORITHMS(NAME, TYPE) \
+  static void scalar_##NAME##Small(TYPE *a, size_t n) \
+  { \
+    size_t i, j; \
+    for(i = 1; i < n; i++) \
+    { \
+      TYPE v = a[i]; \
+      for(j = i; j > 0 && v < a[j - 1]; j--) a[j] = a[j - 1]; \
+      a[j] = v; \
+    } \
+  } \
+  static void scalar_##NAME##Merge(const TYPE *a, size_t na, const TYPE *b, size_t nb, TYPE *out) \
+  { \
+    size_t i = 0, j = 0; \
+    while(i < na && j < nb) \
+    { \
+      int takeB = b[j] < a[i]; \
+      *out++ = takeB?b[j]:a[i]; \
+      j += takeB; \
+      i += !takeB; \
+    } \
+    memcpy(out, a + i, (na - i) * sizeof(TYPE)); \
+    memcpy(out + na - i, b + j, (nb - j) * sizeof(TYPE)); \
+  } \
+  static void scalar_##NAME##Merge3(const TYPE *a, size_t na, const TYPE *b, size_t nb, const TYPE *c, size_t nc, TYPE *out) \
+  { \
+    size_t i = 0, j = 0, k = 0; \
+    while(i < na && j < nb && k < nc) \
+    { \
+      if(a[i] <= b[j] && a[i] <= c[k]) *out++ = a[i++]; \
+      else if(b[j] <= c[k]) *out++ = b[j++]; \
+      else *out++ = c[k++]; \
+    } \
+    if(i == na) scalar_##NAME##Merge(b + j, nb - j, c + k, nc - k, out); \
+    else if(j == nb) scalar_##NAME##Merge(a + i, na - i, c + k, nc - k, out); \
+    else scalar_##NAME##Merge(a + i, na - i, b + j, nb - j, out); \
+  }
+
+SCALAR_ALGORITHMS(i32, int32_t)
+SCALAR_ALGORITHMS(i64, int64_t)
+SCALAR_ALGORITHMS(f32, float)
+SCALAR_ALGORITHMS(f64, double)
+
+/**
+ * @brief defines the scalar partition of a key type, the fallback and the tail of the vectorized ones.
+ */
+#define SCALAR_PARTITION(NAME, TYPE) \
+  static size_t scalar_##NAME##Partition(TYPE *a, size_t n, TYPE pivot) \
+  { \
+    size_t i = 0, j = n; \
+    for(;;) \
+    { \
+      while(i < j && a[i] < pivot) i++; \
+      while(i < j && !(a[j - 1] < pivot)) j--; \
+      if(i >= j) return i; \
+      TYPE tmp = a[i]; \
+      a[i++] = a[--j]; \
+      a[j] = tmp; \
+    } \
+  }
+
+SCALAR_PARTITION(i32, int32_t)
+SCALAR_PARTITION(i64, int64_t)
+
+/**
+ * @brief defines the sorting network and merge of prefix P from its primitives.
+ *
+ * @param P prefix of the primitives, e.g. avx2_i32.
+ * @param NAME key type name of the scalar fallbacks.
+ * @param TYPE key type.
+ * @param V vector type.
+ * @param L lanes per vector.
+ * @param ATTR target attribute of the instruction set.
+ * @param PAD largest key, pads the network to a power of two.
+ */
+#define SIMD_ALGORITHMS(P, NAME, TYPE, V, L, ATTR, PAD) \
+  ATTR static inline void P##CompareExchange(V *x, V *y) \
+  { \
+    V mn = P##Min(*x, *y); \
+    *y = P##Max(*x, *y); \
+    *x = mn; \
+  } \
+  ATTR static inline V P##Clean(V v) \
+  { \
+    size_t j; \
+    for(j = L / 2; j > 0; j >>= 1) \
+    { \
+      V x = P##Exchange(v, j); \
+      v = P##Select(P##Min(v, x), P##Max(v, x), laneBits(L, j)); \
+    } \
+    return v; \
+  } \
+  ATTR static inline __attribute__((always_inline)) void P##Network(V *r, size_t p) \
+  { \
+    size_t j, k, v; \
+    for(k = 2; k <= p; k <<= 1) \
+    { \
+      for(j = k >> 1; j >= L; j >>= 1) \
+      { \
+        for(v = 0; v < p / L; v++) \
+        { \
+          if((v * L) & j) continue; \
+          if((v * L) & k) P##CompareExchange(r + v + j / L, r + v); \
+          else P##CompareExchange(r + v, r + v + j / L); \
+        } \
+      } \
+      for(; j > 0; j >>= 1) \
+      { \
+        unsigned bits = laneBits(L, j) ^ ((k < L)?laneBits(L, k):0), all = (1u << L) - 1; \
+        for(v = 0; v < p / L; v++) \
+        { \
+          V x = P##Exchange(r[v], j); \
+          r[v] = P##Select(P##Min(r[v], x), P##Max(r[v], x), (k >= L && ((v * L) & k))?bits ^ all:bits); \
+        } \
+      } \
+    } \
+  } \
+  ATTR static void P##Small(TYPE *a, size_t n) \
+  { \
+    TYPE buf[SIMD_SMALL_MAX]; \
+    V r[SIMD_SMALL_MAX / L]; \
+    size_t p = L, i, v; \
+    while(p < n) p <<= 1; \
+    memcpy(buf, a, n * sizeof(TYPE)); \
+    for(i = n; i < p; i++) buf[i] = PAD; \
+    for(v = 0; v < p / L; v++) r[v] = P##Load(buf + v * L); \
+    /*constant sizes let the compiler unroll the network and keep it in registers*/ \
+    if(p == L) P##Network(r, L); \
+    else if(p == 2 * L) P##Network(r, 2 * L); \
+    else if(p == 4 * L && 4 * L < SIMD_SMALL_MAX) P##Network(r, 4 * L); \
+    else if(p == 8 * L && 8 * L < SIMD_SMALL_MAX) P##Network(r, 8 * L); \
+    else if(p == 16 * L && 16 * L < SIMD_SMALL_MAX) P##Network(r, 16 * L); \
+    else P##Network(r, SIMD_SMALL_MAX); \
+    for(v = 0; v < p / L; v++) P##Store(buf + v * L, r[v]); \
+    memcpy(a, buf, n * sizeof(TYPE)); \
+  } \
+  ATTR static void P##Merge(const TYPE *a, size_t na, const TYPE *b, size_t nb, TYPE *out) \
+  { \
+    if(na < L || nb < L) \
+    { \
+      scalar_##NAME##Merge(a, na, b, nb, out); \
+      return; \
+    } \
+    TYPE rest[L]; \
+    V x = P##Load(a), y = P##Load(b); \
+    size_t i = L, j = L; \
+    for(;;) \
+    { \
+      y = P##Reverse(y); \
+      P##CompareExchange(&x, &y); \
+      x = P##Clean(x); \
+      y = P##Clean(y); \
+      P##Store(out, x); \
+      out += L; \
+      /*the next vector comes from the array with the smaller head, if it can't provide a whole one the rest is scalar*/ \
+      if(i + L <= na && (j >= nb || a[i] <= b[j])) \
+      { \
+        x = P##Load(a + i); \
+        i += L; \
+      } \
+      else if(j + L <= nb && (i >= na || b[j] < a[i])) \
+      { \
+        x = P##Load(b + j); \
+        j += L; \
+      } \
+      else break; \
+    } \
+    P##Store(rest, y); \
+    scalar_##NAME##Merge3(rest, L, a + i, na - i, b + j, nb - j, out); \
+  }
+
+/**
+ * @brief defines the in-place partition of prefix P, see the file description.
+ *
+ * P##Split(v, pivot, left, right) writes the keys of v less than pivot to left and the others to the elements before right,
+ * it may write a whole vector at either place and returns the number of smaller keys.
+ */
+#define SIMD_PARTITION(P, NAME, TYPE, V, L, ATTR) \
+  ATTR static size_t P##Partition(TYPE *a, size_t n, TYPE pivot) \
+  { \
+    if(n < 2 * L) return scalar_##NAME##Partition(a, n, pivot); \
+    TYPE rest[L]; \
+    V p = P##Set(pivot), first = P##Load(a), last = P##Load(a + n - L), v; \
+    size_t readL = L, readR = n - L, writeL = 0, writeR = n, i, count; \
+    while(readR - readL >= L) \
+    { \
+      if(readL - writeL <= writeR - readR) \
+      { \
+        v = P##Load(a + readL); \
+        readL += L; \
+      } \
+      else \
+      { \
+        readR -= L; \
+        v = P##Load(a + readR); \
+      } \
+      count = P##Split(v, p, a + writeL, a + writeR); \
+      writeL += count; \
+      writeR -= L - count; \
+    } \
+    /*the gap between the write positions now holds exactly the keys left to write*/ \
+    count = readR - readL; \
+    memcpy(rest, a + readL, count * sizeof(TYPE)); \
+    for(i = 0; i < count; i++) \
+    { \
+      if(rest[i] < pivot) a[writeL++] = rest[i]; \
+      else a[--writeR] = rest[i]; \
+    } \
+    count = P##Split(first, p, a + writeL, a + writeR); \
+    writeL += count; \
+    writeR -= L - count; \
+    count = P##Split(last, p, a + writeL, a + writeR); \
+    return writeL + count; \
+  }
+
+/*
+ * SSE4.2 primitives
+ */
+
+SSE_ATTR static inline __m128i sse_mask32(unsigned bits)
+{
+  __m128i lanes = _mm_setr_epi32(1, 2, 4, 8);
+  return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(bits), lanes), lanes);
+}
+
+SSE_ATTR static inline __m128i sse_mask64(unsigned bits)
+{
+  __m128i lanes = _mm_set_epi64x(2, 1);
+  return _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x(bits), lanes), lanes);
+}
+
+SSE_ATTR static inline __m128i sse_i32Load(const int32_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+SSE_ATTR static inline void sse_i32Store(int32_t *p, __m128i v) { _mm_storeu_si128((__m128i*)p, v); }
+SSE_ATTR static inline __m128i sse_i32Min(__m128i x, __m128i y) { return _mm_min_epi32(x, y); }
+SSE_ATTR static inline __m128i sse_i32Max(__m128i x, __m128i y) { return _mm_max_epi32(x, y); }
+SSE_ATTR static inline __m128i sse_i32Exchange(__m128i v, size_t j) { return (j == 1)?_mm_shuffle_epi32(v, 0xb1):_mm_shuffle_epi32(v, 0x4e); }
+SSE_ATTR static inline __m128i sse_i32Reverse(__m128i v) { return _mm_shuffle_epi32(v, 0x1b); }
+SSE_ATTR static inline __m128i sse_i32Select(__m128i mn, __m128i mx, unsigned bits) { return _mm_blendv_epi8(mn, mx, sse_mask32(bits)); }
+
+SSE_ATTR static inline __m128 sse_f32Load(const float *p) { return _mm_loadu_ps(p); }
+SSE_ATTR static inline void sse_f32Store(float *p, __m128 v) { _mm_storeu_ps(p, v); }
+SSE_ATTR static inline __m128 sse_f32Min(__m128 x, __m128 y) { return _mm_min_ps(x, y); }
+SSE_ATTR static inline __m128 sse_f32Max(__m128 x, __m128 y) { return _mm_max_ps(x, y); }
+SSE_ATTR static inline __m128 sse_f32Exchange(__m128 v, size_t j) { return (j == 1)?_mm_shuffle_ps(v, v, 0xb1):_mm_shuffle_ps(v, v, 0x4e); }
+SSE_ATTR static inline __m128 sse_f32Reverse(__m128 v) { return _mm_shuffle_ps(v, v, 0x1b); }
+SSE_ATTR static inline __m128 sse_f32Select(__m128 mn, __m128 mx, unsigned bits) { return _mm_blendv_ps(mn, mx, _mm_castsi128_ps(sse_mask32(bits))); }
+
+SSE_ATTR static inline __m128i sse_i64Load(const int64_t *p) { return _mm_loadu_si128((const __m128i*)p); }
+SSE_ATTR static inline void sse_i64Store(int64_t *p, __m128i v) { _mm_storeu_si128((__m128i*)p, v); }
+SSE_ATTR static inline __m128i sse_i64Min(__m128i x, __m128i y) { return _mm_blendv_epi8(x, y, _mm_cmpgt_epi64(x, y)); }
+SSE_ATTR static inline __m128i sse_i64Max(__m128i x, __m128i y) { return _mm_blendv_epi8(y, x, _mm_cmpgt_epi64(x, y)); }
+SSE_ATTR static inline __m128i sse_i64Exchange(__m128i v, size_t j) { (void)j; return _mm_shuffle_epi32(v, 0x4e); }
+SSE_ATTR static inline __m128i sse_i64Reverse(__m128i v) { return _mm_shuffle_epi32(v, 0x4e); }
+SSE_ATTR static inline __m128i sse_i64Select(__m128i mn, __m128i mx, unsigned bits) { return _mm_blendv_epi8(mn, mx, sse_mask64(bits)); }
+
+SSE_ATTR static inline __m128d sse_f64Load(const double *p) { return _mm_loadu_pd(p); }
+SSE_ATTR static inline void sse_f64Store(double *p, __m128d v) { _mm_storeu_pd(p, v); }
+SSE_ATTR static inline __m128d sse_f64Min(__m128d x, __m128d y) { return _mm_min_pd(x, y); }
+SSE_ATTR static inline __m128d sse_f64Max(__m128d x, __m128d y) { return _mm_max_pd(x, y); }
+SSE_ATTR static inline __m128d sse_f64Exchange(__m128d v, size_t j) { (void)j; return _mm_shuffle_pd(v, v, 1); }
+SSE_ATTR static inline __m128d sse_f64Reverse(__m128d v) { return _mm_shuffle_pd(v, v, 1); }
+SSE_ATTR static inline __m128d sse_f64Select(__m128d mn, __m128d mx, unsigned bits) { return _mm_blendv_pd(mn, mx, _mm_castsi128_pd(sse_mask64(bits))); }
+
+SIMD_ALGORITHMS(sse_i32, i32, int32_t, __m128i, 4, SSE_ATTR, INT32_MAX)
+SIMD_ALGORITHMS(sse_f32, f32, float, __m128, 4, SSE_ATTR, INFINITY)
+SIMD_ALGORITHMS(sse_i64, i64, int64_t, __m128i, 2, SSE_ATTR, INT64_MAX)
+SIMD_ALGORITHMS(sse_f64, f64, double, __m128d, 2, SSE_ATTR, INFINITY)
+
+/*
+ * AVX2 primitives
+ */
+
+AVX2_ATTR static inline __m256i avx2_mask32(unsigned bits)
+{
+  __m256i lanes = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+  return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits), lanes), lanes);
+}
+
+AVX2_ATTR static inline __m256i avx2_mask64(unsigned bits)
+{
+  __m256i lanes = _mm256_setr_epi64x(1, 2, 4, 8);
+  return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lanes), lanes);
+}
+
+AVX2_ATTR static inline __m256i avx2_exchange32(size_t j)
+{
+  return _mm256_xor_si256(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(j));
+}
+
+AVX2_ATTR static inline __m256i avx2_i32Load(const int32_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+AVX2_ATTR static inline void avx2_i32Store(int32_t *p, __m256i v) { _mm256_storeu_si256((__m256i*)p, v); }
+AVX2_ATTR static inline __m256i avx2_i32Min(__m256i x, __m256i y) { return _mm256_min_epi32(x, y); }
+AVX2_ATTR static inline __m256i avx2_i32Max(__m256i x, __m256i y) { return _mm256_max_epi32(x, y); }
+AVX2_ATTR static inline __m256i avx2_i32Exchange(__m256i v, size_t j) { return _mm256_permutevar8x32_epi32(v, avx2_exchange32(j)); }
+AVX2_ATTR static inline __m256i avx2_i32Reverse(__m256i v) { return _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+AVX2_ATTR static inline __m256i avx2_i32Select(__m256i mn, __m256i mx, unsigned bits) { return _mm256_blendv_epi8(mn, mx, avx2_mask32(bits)); }
+
+AVX2_ATTR static inline __m256 avx2_f32Load(const float *p) { return _mm256_loadu_ps(p); }
+AVX2_ATTR static inline void avx2_f32Store(float *p, __m256 v) { _mm256_storeu_ps(p, v); }
+AVX2_ATTR static inline __m256 avx2_f32Min(__m256 x, __m256 y) { return _mm256_min_ps(x, y); }
+AVX2_ATTR static inline __m256 avx2_f32Max(__m256 x, __m256 y) { return _mm256_max_ps(x, y); }
+AVX2_ATTR static inline __m256 avx2_f32Exchange(__m256 v, size_t j) { return _mm256_permutevar8x32_ps(v, avx2_exchange32(j)); }
+AVX2_ATTR static inline __m256 avx2_f32Reverse(__m256 v) { return _mm256_permutevar8x32_ps(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+AVX2_ATTR static inline __m256 avx2_f32Select(__m256 mn, __m256 mx, unsigned bits) { return _mm256_blendv_ps(mn, mx, _mm256_castsi256_ps(avx2_mask32(bits))); }
+
+AVX2_ATTR static inline __m256i avx2_i64Load(const int64_t *p) { return _mm256_loadu_si256((const __m256i*)p); }
+AVX2_ATTR static inline void avx2_i64Store(int64_t *p, __m256i v) { _mm256_storeu_si256((__m256i*)p, v); }
+AVX2_ATTR static inline __m256i avx2_i64Min(__m256i x, __m256i y) { return _mm256_blendv_epi8(x, y, _mm256_cmpgt_epi64(x, y)); }
+AVX2_ATTR static inline __m256i avx2_i64Max(__m256i x, __m256i y) { return _mm256_blendv_epi8(y, x, _mm256_cmpgt_epi64(x, y)); }
+AVX2_ATTR static inline __m256i avx2_i64Exchange(__m256i v, size_t j) { return (j == 1)?_mm256_permute4x64_epi64(v, 0xb1):_mm256_permute4x64_epi64(v, 0x4e); }
+AVX2_ATTR static inline __m256i avx2_i64Reverse(__m256i v) { return _mm256_permute4x64_epi64(v, 0x1b); }
+AVX2_ATTR static inline __m256i avx2_i64Select(__m256i mn, __m256i mx, unsigned bits) { return _mm256_blendv_epi8(mn, mx, avx2_mask64(bits)); }
+
+AVX2_ATTR static inline __m256d avx2_f64Load(const double *p) { return _mm256_loadu_pd(p); }
+AVX2_ATTR static inline void avx2_f64Store(double *p, __m256d v) { _mm256_storeu_pd(p, v); }
+AVX2_ATTR static inline __m256d avx2_f64Min(__m256d x, __m256d y) { return _mm256_min_pd(x, y); }
+AVX2_ATTR static inline __m256d avx2_f64Max(__m256d x, __m256d y) { return _mm256_max_pd(x, y); }
+AVX2_ATTR static inline __m256d avx2_f64Exchange(__m256d v, size_t j) { return (j == 1)?_mm256_permute4x64_pd(v, 0xb1):_mm256_permute4x64_pd(v, 0x4e); }
+AVX2_ATTR static inline __m256d avx2_f64Reverse(__m256d v) { return _mm256_permute4x64_pd(v, 0x1b); }
+AVX2_ATTR static inline __m256d avx2_f64Select(__m256d mn, __m256d mx, unsigned bits) { return _mm256_blendv_pd(mn, mx, _mm256_castsi256_pd(avx2_mask64(bits))); }
+
+static uint32_t avx2Permute32[256]; ///< per mask of 8 lanes: lane indices as nibbles, the set lanes first
+static uint32_t avx2Permute64[16][8]; ///< per mask of 4 lanes: 32 bit lane indices, the set lanes first
+
+/**
+ * @brief fills the permutation tables of the AVX2 partition.
+ */
+static void avx2InitPermutations(void)
+{
+  unsigned m, i, k;
+  for(m = 0; m < 256; m++)
+  {
+    uint32_t packed = 0;
+    k = 0;
+    for(i = 0; i < 8; i++) if(m & (1u << i)) packed |= i << (4 * k++);
+    for(i = 0; i < 8; i++) if(!(m & (1u << i))) packed |= i << (4 * k++);
+    avx2Permute32[m] = packed;
+  }
+  for(m = 0; m < 16; m++)
+  {
+    k = 0;
+    for(i = 0; i < 4; i++) if(m & (1u << i))
+    {
+      avx2Permute64[m][k++] = 2 * i;
+      avx2Permute64[m][k++] = 2 * i + 1;
+    }
+    for(i = 0; i < 4; i++) if(!(m & (1u << i)))
+    {
+      avx2Permute64[m][k++] = 2 * i;
+      avx2Permute64[m][k++] = 2 * i + 1;
+    }
+  }
+}
+
+AVX2_ATTR static inline __m256i avx2_i32Set(int32_t x) { return _mm256_set1_epi32(x); }
+AVX2_ATTR static inline size_t avx2_i32Split(__m256i v, __m256i p, int32_t *left, int32_t *right)
+{
+  unsigned m = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(p, v)));
+  __m256i perm = _mm256_and_si256(_mm256_srlv_epi32(_mm256_set1_epi32(avx2Permute32[m]), _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(15));
+  v = _mm256_permutevar8x32_epi32(v, perm);
+  _mm256_storeu_si256((__m256i*)left, v);
+  _mm256_storeu_si256((__m256i*)(right - 8), v);
+  return __builtin_popcount(m);
+}
+
+AVX2_ATTR static inline __m256i avx2_i64Set(int64_t x) { return _mm256_set1_epi64x(x); }
+AVX2_ATTR static inline size_t avx2_i64Split(__m256i v, __m256i p, int64_t *left, int64_t *right)
+{
+  unsigned m = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(p, v)));
+  v = _mm256_permutevar8x32_epi32(v, _mm256_loadu_si256((const __m256i*)avx2Permute64[m]));
+  _mm256_storeu_si256((__m256i*)left, v);
+  _mm256_storeu_si256((__m256i*)(right - 4), v);
+  return __builtin_popcount(m);
+}
+
+SIMD_ALGORITHMS(avx2_i32, i32, int32_t, __m256i, 8, AVX2_ATTR, INT32_MAX)
+SIMD_ALGORITHMS(avx2_f32, f32, float, __m256, 8, AVX2_ATTR, INFINITY)
+SIMD_ALGORITHMS(avx2_i64, i64, int64_t, __m256i, 4, AVX2_ATTR, INT64_MAX)
+SIMD_ALGORITHMS(avx2_f64, f64, double, __m256d, 4, AVX2_ATTR, INFINITY)
+SIMD_PARTITION(avx2_i32, i32, int32_t, __m256i, 8, AVX2_ATTR)
+SIMD_PARTITION(avx2_i64, i64, int64_t, __m256i, 4, AVX2_ATTR)
+
+/*
+ * AVX-512 primitives
+ */
+
+AVX512_ATTR static inline __m512i avx512_exchange32(size_t j)
+{
+  return _mm512_xor_si512(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(j));
+}
+
+AVX512_ATTR static inline __m512i avx512_exchange64(size_t j)
+{
+  return _mm512_xor_si512(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7), _mm512_set1_epi64(j));
+}
+
+AVX512_ATTR static inline __m512i avx512_reverse32(void)
+{
+  return _mm512_setr_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+}
+
+AVX512_ATTR static inline __m512i avx512_reverse64(void)
+{
+  return _mm512_setr_epi64(7, 6, 5, 4, 3, 2, 1, 0);
+}
+
+AVX512_ATTR static inline __m512i avx512_i32Load(const int32_t *p) { return _mm512_loadu_si512(p); }
+AVX512_ATTR static inline void avx512_i32Store(int32_t *p, __m512i v) { _mm512_storeu_si512(p, v); }
+AVX512_ATTR static inline __m512i avx512_i32Min(__m512i x, __m512i y) { return _mm512_min_epi32(x, y); }
+AVX512_ATTR static inline __m512i avx512_i32Max(__m512i x, __m512i y) { return _mm512_max_epi32(x, y); }
+AVX512_ATTR static inline __m512i avx512_i32Exchange(__m512i v, size_t j) { return _mm512_permutexvar_epi32(avx512_exchange32(j), v); }
+AVX512_ATTR static inline __m512i avx512_i32Reverse(__m512i v) { return _mm512_permutexvar_epi32(avx512_reverse32(), v); }
+AVX512_ATTR static inline __m512i avx512_i32Select(__m512i mn, __m512i mx, unsigned bits) { return _mm512_mask_blend_epi32((__mmask16)bits, mn, mx); }
+
+AVX512_ATTR static inline __m512 avx512_f32Load(const float *p) { return _mm512_loadu_ps(p); }
+AVX512_ATTR static inline void avx512_f32Store(float *p, __m512 v) { _mm512_storeu_ps(p, v); }
+AVX512_ATTR static inline __m512 avx512_f32Min(__m512 x, __m512 y) { return _mm512_min_ps(x, y); }
+AVX512_ATTR static inline __m512 avx512_f32Max(__m512 x, __m512 y) { return _mm512_max_ps(x, y); }
+AVX512_ATTR static inline __m512 avx512_f32Exchange(__m512 v, size_t j) { return _mm512_permutexvar_ps(avx512_exchange32(j), v); }
+AVX512_ATTR static inline __m512 avx512_f32Reverse(__m512 v) { return _mm512_permutexvar_ps(avx512_reverse32(), v); }
+AVX512_ATTR static inline __m512 avx512_f32Select(__m512 mn, __m512 mx, unsigned bits) { return _mm512_mask_blend_ps((__mmask16)bits, mn, mx); }
+
+AVX512_ATTR static inline __m512i avx512_i64Load(const int64_t *p) { return _mm512_loadu_si512(p); }
+AVX512_ATTR static inline void avx512_i64Store(int64_t *p, __m512i v) { _mm512_storeu_si512(p, v); }
+AVX512_ATTR static inline __m512i avx512_i64Min(__m512i x, __m512i y) { return _mm512_min_epi64(x, y); }
+AVX512_ATTR static inline __m512i avx512_i64Max(__m512i x, __m512i y) { return _mm512_max_epi64(x, y); }
+AVX512_ATTR static inline __m512i avx512_i64Exchange(__m512i v, size_t j) { return _mm512_permutexvar_epi64(avx512_exchange64(j), v); }
+AVX512_ATTR static inline __m512i avx512_i64Reverse(__m512i v) { return _mm512_permutexvar_epi64(avx512_reverse64(), v); }
+AVX512_ATTR static inline __m512i avx512_i64Select(__m512i mn, __m512i mx, unsigned bits) { return _mm512_mask_blend_epi64((__mmask8)bits, mn, mx); }
+
+AVX512_ATTR static inline __m512d avx512_f64Load(const double *p) { return _mm512_loadu_pd(p); }
+AVX512_ATTR static inline void avx512_f64Store(double *p, __m512d v) { _mm512_storeu_pd(p, v); }
+AVX512_ATTR static inline __m512d avx512_f64Min(__m512d x, __m512d y) { return _mm512_min_pd(x, y); }
+AVX512_ATTR static inline __m512d avx512_f64Max(__m512d x, __m512d y) { return _mm512_max_pd(x, y); }
+AVX512_ATTR static inline __m512d avx512_f64Exchange(__m512d v, size_t j) { return _mm512_permutexvar_pd(avx512_exchange64(j), v); }
+AVX512_ATTR static inline __m512d avx512_f64Reverse(__m512d v) { return _mm512_permutexvar_pd(avx512_reverse64(), v); }
+AVX512_ATTR static inline __m512d avx512_f64Select(__m512d mn, __m512d mx, unsigned bits) { return _mm512_mask_blend_pd((__mmask8)bits, mn, mx); }
+
+AVX512_ATTR static inline __m512i avx512_i32Set(int32_t x) { return _mm512_set1_epi32(x); }
+AVX512_ATTR static inline size_t avx512_i32Split(__m512i v, __m512i p, int32_t *left, int32_t *right)
+{
+  __mmask16 m = _mm512_cmplt_epi32_mask(v, p);
+  size_t count = __builtin_popcount(m);
+  _mm512_mask_compressstoreu_epi32(left, m, v);
+  _mm512_mask_compressstoreu_epi32(right - (16 - count), ~m, v);
+  return count;
+}
+
+AVX512_ATTR static inline __m512i avx512_i64Set(int64_t x) { return _mm512_set1_epi64(x); }
+AVX512_ATTR static inline size_t avx512_i64Split(__m512i v, __m512i p, int64_t *left, int64_t *right)
+{
+  __mmask8 m = _mm512_cmplt_epi64_mask(v, p);
+  size_t count = __builtin_popcount(m);
+  _mm512_mask_compressstoreu_epi64(left, m, v);
+  _mm512_mask_compressstoreu_epi64(right - (8 - count), ~m, v);
+  return count;
+}
+
+SIMD_ALGORITHMS(avx512_i32, i32, int32_t, __m512i, 16, AVX512_ATTR, INT32_MAX)
+SIMD_ALGORITHMS(avx512_f32, f32, float, __m512, 16, AVX512_ATTR, INFINITY)
+SIMD_ALGORITHMS(avx512_i64, i64, int64_t, __m512i, 8, AVX512_ATTR, INT64_MAX)
+SIMD_ALGORITHMS(avx512_f64, f64, double, __m512d, 8, AVX512_ATTR, INFINITY)
+SIMD_PARTITION(avx512_i32, i32, int32_t, __m512i, 16, AVX512_ATTR)
+SIMD_PARTITION(avx512_i64, i64, int64_t, __m512i, 8, AVX512_ATTR)
+
+/*
+ * runtime dispatch
+ */
+
+static unsigned level = SIMD_SCALAR; ///< instruction set the kernels were picked for
+
+/**
+ * @brief defines the kernel pointers of a key type, their setup and the public entries.
+ */
+#define SIMD_DISPATCH(NAME, TYPE) \
+  static void (*NAME##Small)(TYPE*, size_t) = scalar_##NAME##Small; \
+  static void (*NAME##Merge)(const TYPE*, size_t, const TYPE*, size_t, TYPE*) = scalar_##NAME##Merge; \
+  static void NAME##Pick(unsigned l) \
+  { \
+    switch(l) \
+    { \
+      case SIMD_AVX512: NAME##Small = avx512_##NAME##Small; NAME##Merge = avx512_##NAME##Merge; break; \
+      case SIMD_AVX2: NAME##Small = avx2_##NAME##Small; NAME##Merge = avx2_##NAME##Merge; break; \
+      case SIMD_SSE: NAME##Small = sse_##NAME##Small; NAME##Merge = sse_##NAME##Merge; break; \
+      default: NAME##Small = scalar_##NAME##Small; NAME##Merge = scalar_##NAME##Merge; break; \
+    } \
+  } \
+  void simdSmallSort_##NAME(TYPE *a, size_t n) \
+  { \
+    if(n > 1) NAME##Small(a, n); \
+  } \
+  void simdMerge_##NAME(const TYPE *a, size_t na, const TYPE *b, size_t nb, TYPE *out) \
+  { \
+    NAME##Merge(a, na, b, nb, out); \
+  }
+
+SIMD_DISPATCH(i32, int32_t)
+SIMD_DISPATCH(i64, int64_t)
+SIMD_DISPATCH(f32, float)
+SIMD_DISPATCH(f64, double)
+
+/**
+ * @brief defines the partition pointer of a key type, its setup and the public entry, SSE has no partition of its own.
+ */
+#define PARTITION_DISPATCH(NAME, TYPE) \
+  static size_t (*NAME##Partition)(TYPE*, size_t, TYPE) = scalar_##NAME##Partition; \
+  static void NAME##PickPartition(unsigned l) \
+  { \
+    switch(l) \
+    { \
+      case SIMD_AVX512: NAME##Partition = avx512_##NAME##Partition; break; \
+      case SIMD_AVX2: NAME##Partition = avx2_##NAME##Partition; break; \
+      default: NAME##Partition = scalar_##NAME##Partition; break; \
+    } \
+  } \
+  size_t simdPartition_##NAME(TYPE *a, size_t n, TYPE pivot) \
+  { \
+    return NAME##Partition(a, n, pivot); \
+  }
+
+PARTITION_DISPATCH(i32, int32_t)
+PARTITION_DISPATCH(i64, int64_t)
+
+static const char *levelNames[] = {"scalar", "sse", "avx2", "avx512"}; ///< names of the levels, as taken by SORT_SIMD
+
+/**
+ * @brief picks the kernels for the best instruction set the CPU supports, at most the one named by SORT_SIMD.
+ */
+__attribute__((constructor)) static void simdInit(void)
+{
+  unsigned l, max = SIMD_AVX512;
+  const char *env = getenv("SORT_SIMD");
+  __builtin_cpu_init();
+  if(env)
+  {
+    for(l = 0; l <= SIMD_AVX512; l++) if(!strcmp(env, levelNames[l])) max = l;
+  }
+
+  if(__builtin_cpu_supports("avx512f")) level = SIMD_AVX512;
+  else if(__builtin_cpu_supports("avx2")) level = SIMD_AVX2;
+  else if(__builtin_cpu_supports("sse4.2")) level = SIMD_SSE;
+  else level = SIMD_SCALAR;
+  if(level > max) level = max;
+
+  avx2InitPermutations();
+  i32Pick(level);
+  i64Pick(level);
+  f32Pick(level);
+  f64Pick(level);
+  i32PickPartition(level);
+  i64PickPartition(level);
+}
+
+/**
+ * @brief instruction set the kernels use.
+ * @return one of the SIMD_ constants.
+ */
+unsigned simdLevel(void)
+{
+  return level;
+}
+
+/**
+ * @brief name of an instruction set level.
+ * @param level one of the SIMD_ constants.
+ * @return name as taken by the environment variable SORT_SIMD.
+ */
+const char *simdLevelName(unsigned level)
+{
+  return (level <= SIMD_AVX512)?levelNames[level]:"unknown";
+}
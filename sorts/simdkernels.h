@@ -0,0 +1,36 @@
+/**
+ * @file simdkernels.h
+ * @author Roy Freytag
+ *
+ * SIMD sorting networks, bitonic merges and partitions for 32 and 64 bit keys, picked at runtime for the best instruction set of the CPU.
+ */
+#ifndef __SIMDKERNELS_H__
+#define __SIMDKERNELS_H__
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define SIMD_SMALL_MAX 64 ///< maximum number of elements the simdSmallSort_ functions sort
+
+#define SIMD_SCALAR 0 ///< no vector instructions, insertion sort and scalar merges
+#define SIMD_SSE    1 ///< SSE4.2, 128 bit vectors
+#define SIMD_AVX2   2 ///< AVX2, 256 bit vectors
+#define SIMD_AVX512 3 ///< AVX-512F, 512 bit vectors
+
+unsigned simdLevel(void);
+const char *simdLevelName(unsigned level);
+
+void simdSmallSort_i32(int32_t *a, size_t n);
+void simdSmallSort_i64(int64_t *a, size_t n);
+void simdSmallSort_f32(float *a, size_t n);
+void simdSmallSort_f64(double *a, size_t n);
+
+void simdMerge_i32(const int32_t *a, size_t na, const int32_t *b, size_t nb, int32_t *out);
+void simdMerge_i64(const int64_t *a, size_t na, const int64_t *b, size_t nb, int64_t *out);
+void simdMerge_f32(const float *a, size_t na, const float *b, size_t nb, float *out);
+void simdMerge_f64(const double *a, size_t na, const double *b, size_t nb, double *out);
+
+size_t simdPartition_i32(int32_t *a, size_t n, int32_t pivot);
+size_t simdPartition_i64(int64_t *a, size_t n, int64_t pivot);
+
+#endif
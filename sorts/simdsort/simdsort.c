@@ -0,0 +1,137 @@
+/**
+ * @file simdsort.c
+ * @author Roy Freytag
+ *
+ * vectorized merge sort of 32 and 64 bit keys, built from the kernels of simdkernels.c.
+ *
+ * Blocks of SIMD_SMALL_MAX elements get sorted by the sorting network, then bottom-up passes merge them by bitonic merges,
+ * moving the elements between the input and a buffer of the same size. uint64 keys get their sign bit flipped and are
+ * sorted as int64. Elements only hold a key of their size, so records and keyless elements fall back to qsort_r().
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../simdkernels.h"
+#include "simdsort.h"
+
+/**
+ * @brief defines NAME##MergeSort(), sorting n keys with buffer of n keys, and the type-specialized entry sort_NAME.
+ */
+#define SIMDSORT_TYPED(NAME, TYPE) \
+  static void NAME##MergeSort(TYPE *a, size_t n, TYPE *buffer) \
+  { \
+    TYPE *from = a, *to = buffer, *tmp; \
+    size_t i, width; \
+    for(i = 0; i < n; i += SIMD_SMALL_MAX) simdSmallSort_##NAME(a + i, (n - i < SIMD_SMALL_MAX)?n - i:SIMD_SMALL_MAX); \
+    for(width = SIMD_SMALL_MAX; width < n; width *= 2) \
+    { \
+      for(i = 0; i < n; i += 2 * width) \
+      { \
+        size_t mid = (n - i < width)?n:i + width; \
+        size_t end = (n - mid < width)?n:mid + width; \
+        simdMerge_##NAME(from + i, mid - i, from + mid, end - mid, to + i); \
+      } \
+      tmp = from; \
+      from = to; \
+      to = tmp; \
+    } \
+    if(from != a) memcpy(a, from, n * sizeof(TYPE)); \
+  } \
+  static int NAME##Compare(const void *x, const void *y) \
+  { \
+    TYPE a = *(const TYPE*)x, b = *(const TYPE*)y; \
+    return (a > b) - (a < b); \
+  } \
+  static void NAME##Sort(TYPE *a, size_t n, void *scratch) \
+  { \
+    TYPE *buffer = scratch?scratch:malloc(n * sizeof(TYPE)); \
+    if(!buffer) \
+    { \
+      qsort(a, n, sizeof(TYPE), NAME##Compare); \
+      return; \
+    } \
+    NAME##MergeSort(a, n, buffer); \
+    if(buffer != scratch) free(buffer); \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    NAME##Sort(data, n, 0); \
+  }
+
+SIMDSORT_TYPED(i32, int32_t)
+SIMDSORT_TYPED(i64, int64_t)
+SIMDSORT_TYPED(f32, float)
+SIMDSORT_TYPED(f64, double)
+
+/**
+ * @brief flips the sign bits of n keys, turning the order of uint64 into the one of int64 and back.
+ */
+static void flipSigns(uint64_t *a, size_t n)
+{
+  size_t i;
+  for(i = 0; i < n; i++) a[i] ^= 0x8000000000000000ULL;
+}
+
+static void u64Sort(uint64_t *a, size_t n, void *scratch)
+{
+  flipSigns(a, n);
+  i64Sort((int64_t*)a, n, scratch);
+  flipSigns(a, n);
+}
+
+void sort_u64(void *data, size_t n)
+{
+  if(!data || n < 2) return;
+  u64Sort(data, n, 0);
+}
+
+/**
+ * @brief context-taking entry, sorts elements that are just a supported key.
+ */
+void simdSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  void *scratch = (ctx->scratchSize >= n * size)?ctx->scratch:0;
+  if(!ctx->keyOffset)
+  {
+    switch(ctx->keyType)
+    {
+      case SORT_KEY_I32: if(size != sizeof(int32_t)) break; i32Sort(data, n, scratch); return;
+      case SORT_KEY_I64: if(size != sizeof(int64_t)) break; i64Sort(data, n, scratch); return;
+      case SORT_KEY_U64: if(size != sizeof(uint64_t)) break; u64Sort(data, n, scratch); return;
+      case SORT_KEY_F32: if(size != sizeof(float)) break; f32Sort(data, n, scratch); return;
+      case SORT_KEY_F64: if(size != sizeof(double)) break; f64Sort(data, n, scratch); return;
+    }
+  }
+  qsort_r(data, n, size, ctx->compare, ctx->compareArg);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_SCRATCH,
+  SORT_KEY_I32 | SORT_KEY_I64 | SORT_KEY_U64 | SORT_KEY_F32 | SORT_KEY_F64,
+  1,
+  "simdSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  static char name[64];
+  snprintf(name, sizeof(name), "SIMD Mergesort %s", simdLevelName(simdLevel()));
+  return name;
+}
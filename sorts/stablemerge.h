@@ -0,0 +1,151 @@
+/**
+ * @file stablemerge.h
+ * @author Roy Freytag
+ *
+ * stable merge sort for elements of any size, for modules that have to stay stable when they can't use their own algorithm.
+ *
+ * stableMergeSort() insertion sorts blocks of STABLE_INSERTION elements and merges them bottom-up with doubling widths.
+ * With a buffer a merge moves the left run aside and merges back forward. Without one stableMergeInPlace() splits the
+ * longer run in the middle, finds the matching position in the other one by binary search and rotates the parts in
+ * between, which needs no memory at all for O(n log^2 n) swaps. Equal elements keep their order throughout.
+ */
+#ifndef __STABLEMERGE_H__
+#define __STABLEMERGE_H__
+
+#include <stdlib.h>
+#include <string.h>
+#include "helpers.h"
+
+#define STABLE_INSERTION 16 ///< blocks of this size get insertion sorted before merging
+
+/**
+ * @brief reverses a range.
+ */
+static inline void stableReverse(char *a, size_t n, size_t size, swapFn_t swap)
+{
+  char *z = a + (n - 1) * size;
+  for(; n > 1 && a < z; a += size, z -= size) swap(a, z, size);
+}
+
+/**
+ * @brief rotates a range left by k elements.
+ */
+static inline void stableRotate(char *a, size_t n, size_t k, size_t size, swapFn_t swap)
+{
+  if(!k || k == n) return;
+  stableReverse(a, k, size, swap);
+  stableReverse(a + k * size, n - k, size, swap);
+  stableReverse(a, n, size, swap);
+}
+
+/**
+ * @brief binary search of the element at key in a sorted range.
+ * @param upper 1 to skip elements equal to key as well.
+ * @return index of the first element not less than key, or greater than it with upper set.
+ */
+static inline size_t stableSearch(const char *key, const char *a, size_t n, int upper, size_t size, int (*cmp)(const void*, const void*, void*), void *arg)
+{
+  size_t lo = 0, hi = n;
+  while(lo < hi)
+  {
+    size_t m = lo + (hi - lo) / 2;
+    int c = cmp(a + m * size, key, arg);
+    if(c < 0 || (upper && !c)) lo = m + 1;
+    else hi = m;
+  }
+  return lo;
+}
+
+/**
+ * @brief merges the runs a[0, na) and a[na, na + nb) in place by rotations.
+ *
+ * The element the longer run gets split at ends up in its final place between both halves, the left half is merged
+ * recursively and the right one in the loop.
+ */
+static inline void stableMergeInPlace(char *a, size_t na, size_t nb, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i, j;
+  while(na && nb)
+  {
+    if(na >= nb)
+    {
+      i = na / 2; //elements of the right run less than a[i] go before it
+      j = stableSearch(a + i * size, a + na * size, nb, 0, size, cmp, arg);
+      stableRotate(a + i * size, na - i + j, na - i, size, swap);
+      stableMergeInPlace(a, i, j, size, cmp, arg, swap);
+      a += (i + j + 1) * size;
+      na -= i + 1;
+      nb -= j;
+    }
+    else
+    {
+      j = nb / 2; //elements of the left run not greater than b[j] go before it
+      i = stableSearch(a + (na + j) * size, a, na, 1, size, cmp, arg);
+      stableRotate(a + i * size, na - i + j + 1, na - i, size, swap);
+      stableMergeInPlace(a, i, j, size, cmp, arg, swap);
+      a += (i + j + 1) * size;
+      na -= i;
+      nb -= j + 1;
+    }
+  }
+}
+
+/**
+ * @brief merges the runs a[0, na) and a[na, na + nb) through a buffer of na elements.
+ */
+static inline void stableMergeBuffered(char *a, size_t na, size_t nb, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, char *buffer)
+{
+  char *pa = buffer, *ea = buffer + na * size, *pb = a + na * size, *eb = pb + nb * size;
+  memcpy(buffer, a, na * size);
+  while(pa < ea && pb < eb)
+  {
+    if(cmp(pb, pa, arg) < 0)
+    {
+      memcpy(a, pb, size);
+      pb += size;
+    }
+    else
+    {
+      memcpy(a, pa, size);
+      pa += size;
+    }
+    a += size;
+  }
+  memcpy(a, pa, ea - pa); //the rest of the right run is in place already
+}
+
+/**
+ * @brief stable insertion sort of a short range, moving elements by adjacent swaps.
+ */
+static inline void stableInsertion(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap)
+{
+  size_t i;
+  for(i = 1; i < n; i++)
+  {
+    char *p = a + i * size;
+    for(; p > a && cmp(p, p - size, arg) < 0; p -= size) swap(p, p - size, size);
+  }
+}
+
+/**
+ * @brief stable bottom-up merge sort.
+ * @param buffer buffer of n elements, 0 to merge in place.
+ */
+static inline void stableMergeSort(char *a, size_t n, size_t size, int (*cmp)(const void*, const void*, void*), void *arg, swapFn_t swap, char *buffer)
+{
+  size_t lo, width;
+  for(lo = 0; lo < n; lo += STABLE_INSERTION) stableInsertion(a + lo * size, (n - lo < STABLE_INSERTION)?n - lo:STABLE_INSERTION, size, cmp, arg, swap);
+  for(width = STABLE_INSERTION; width < n; width *= 2)
+  {
+    for(lo = 0; lo + width < n; lo += 2 * width)
+    {
+      char *l = a + lo * size, *r = l + width * size;
+      size_t nb = (n - lo - width < width)?n - lo - width:width;
+      if(cmp(r, r - size, arg) >= 0) continue; //already in order
+      if(buffer) stableMergeBuffered(l, width, nb, size, cmp, arg, buffer);
+      else stableMergeInPlace(l, width, nb, size, cmp, arg, swap);
+    }
+  }
+}
+
+#endif
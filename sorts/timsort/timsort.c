@@ -0,0 +1,121 @@
+/**
+ * @file timsort.c
+ * @author Roy Freytag
+ *
+ * TimSort(Tim Peters, listsort.txt of CPython).
+ *
+ * Splits the elements into natural runs, extending short ones by binary insertion sort, and pushes them onto a stack.
+ * Whenever the lengths of the topmost runs break the invariants
+ * - runs[i - 2] > runs[i - 1] + runs[i]
+ * - runs[i - 1] > runs[i]
+ * the smaller neighbour of the middle run gets merged with it, so merges stay balanced and the stack stays short.
+ * The invariants are checked for the top four runs, which fixes the flaw found by de Gouw et al. in the original.
+ * The merges gallop, see gallopmerge.h.
+ */
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../gallopmerge.h"
+#include "timsort.h"
+
+/**
+ * a pending run
+ */
+typedef struct
+{
+  size_t base; ///< index of the first element
+  size_t len; ///< number of elements
+} Run_t;
+
+/**
+ * @brief merges the runs i and i + 1 of the stack.
+ */
+static void mergeAt(MergeState_t *ms, char *a, Run_t *runs, size_t *count, size_t i)
+{
+  mergeRuns(ms, a + runs[i].base * ms->size, runs[i].len, runs[i + 1].len);
+  runs[i].len += runs[i + 1].len;
+  if(i + 2 < *count) runs[i + 1] = runs[i + 2];
+  (*count)--;
+}
+
+/**
+ * @brief merges runs on top of the stack until the invariants hold again.
+ */
+static void mergeCollapse(MergeState_t *ms, char *a, Run_t *runs, size_t *count)
+{
+  while(*count > 1)
+  {
+    size_t i = *count - 2;
+    if((i > 0 && runs[i - 1].len <= runs[i].len + runs[i + 1].len) || (i > 1 && runs[i - 2].len <= runs[i - 1].len + runs[i].len))
+    {
+      if(runs[i - 1].len < runs[i + 1].len) i--;
+    }
+    else if(runs[i].len > runs[i + 1].len) break;
+    mergeAt(ms, a, runs, count, i);
+  }
+}
+
+/**
+ * @brief context-taking entry.
+ */
+void timSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+
+  MergeState_t ms;
+  mergeInit(&ms, data, size, ctx);
+
+  char *a = data;
+  Run_t runs[MAX_RUNS];
+  size_t count = 0, lo = 0, minRun = minRunLength(n);
+  while(lo < n)
+  {
+    size_t len = countRun(&ms, a + lo * size, n - lo);
+    if(len < minRun)
+    {
+      size_t force = (n - lo < minRun)?n - lo:minRun;
+      binaryInsertionSort(&ms, a + lo * size, force, len);
+      len = force;
+    }
+    runs[count].base = lo;
+    runs[count].len = len;
+    count++;
+    mergeCollapse(&ms, a, runs, &count);
+    lo += len;
+  }
+
+  while(count > 1)
+  {
+    size_t i = count - 2;
+    if(i > 0 && runs[i - 1].len < runs[i + 1].len) i--;
+    mergeAt(&ms, a, runs, &count, i);
+  }
+
+  mergeFree(&ms);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_STABLE | SORT_CAP_SCRATCH,
+  0,
+  1,
+  "timSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  return "TimSort";
+}
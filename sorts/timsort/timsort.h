@@ -0,0 +1,9 @@
+#ifndef __TIMSORT_H_
+#define __TIMSORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void timSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+#endif /* __TIMSORT_H_ */
@@ -0,0 +1,159 @@
+/**
+ * @file vqsort.c
+ * @author Roy Freytag
+ *
+ * vectorized quicksort of 32 and 64 bit integers(after vqsort, Blacher et al., "Vectorized and performance-portable Quicksort").
+ *
+ * Partitions with simdPartition_ of helpers.h, AVX-512 compress-stores or AVX2 permutations depending on the CPU.
+ * The pivot is the median of SIMD_SMALL_MAX keys spread over the range, sorted by the sorting network, which is also
+ * the base case. If no key is less than the pivot, it is the smallest one: a second partition by pivot + 1 moves the keys
+ * equal to it to the front, where they are done, so many duplicates don't make it quadratic. Ranges recursing deeper than
+ * 2 log n get heapsorted. uint64 keys get their sign bit flipped and are sorted as int64.
+ * Elements only hold a key of their size, so records and keyless elements fall back to qsort_r().
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "../../sorting_lib.h"
+#include "../helpers.h"
+#include "../introsort.h"
+#include "vqsort.h"
+
+/**
+ * @brief defines NAME##Sort(), the vectorized quicksort of keys of TYPE up to MAX.
+ */
+#define VQSORT_TYPED(NAME, TYPE, MAX) \
+  static void NAME##SiftDown(TYPE *a, size_t root, size_t n) \
+  { \
+    size_t child; \
+    while((child = 2 * root + 1) < n) \
+    { \
+      if(child + 1 < n && a[child] < a[child + 1]) child++; \
+      if(!(a[root] < a[child])) return; \
+      TYPE tmp = a[root]; \
+      a[root] = a[child]; \
+      a[child] = tmp; \
+      root = child; \
+    } \
+  } \
+  static void NAME##HeapSort(TYPE *a, size_t n) \
+  { \
+    size_t i; \
+    for(i = n / 2; i > 0; i--) NAME##SiftDown(a, i - 1, n); \
+    for(i = n - 1; i > 0; i--) \
+    { \
+      TYPE tmp = a[0]; \
+      a[0] = a[i]; \
+      a[i] = tmp; \
+      NAME##SiftDown(a, 0, i); \
+    } \
+  } \
+  static void NAME##Sort(TYPE *a, size_t n, unsigned depth) \
+  { \
+    TYPE sample[SIMD_SMALL_MAX]; \
+    size_t i, lo; \
+    while(n > SIMD_SMALL_MAX) \
+    { \
+      if(!depth--) \
+      { \
+        NAME##HeapSort(a, n); \
+        return; \
+      } \
+      for(i = 0; i < SIMD_SMALL_MAX; i++) sample[i] = a[i * (n / SIMD_SMALL_MAX)]; \
+      simdSmallSort_##NAME(sample, SIMD_SMALL_MAX); \
+      TYPE pivot = sample[SIMD_SMALL_MAX / 2]; \
+      lo = simdPartition_##NAME(a, n, pivot); \
+      if(!lo) \
+      { \
+        /*the pivot is the smallest key, the keys equal to it are done*/ \
+        if(pivot == MAX) return; \
+        lo = simdPartition_##NAME(a, n, pivot + 1); \
+        a += lo; \
+        n -= lo; \
+        continue; \
+      } \
+      if(lo < n - lo) \
+      { \
+        NAME##Sort(a, lo, depth); \
+        a += lo; \
+        n -= lo; \
+      } \
+      else \
+      { \
+        NAME##Sort(a + lo, n - lo, depth); \
+        n = lo; \
+      } \
+    } \
+    simdSmallSort_##NAME(a, n); \
+  } \
+  void sort_##NAME(void *data, size_t n) \
+  { \
+    if(!data || n < 2) return; \
+    NAME##Sort(data, n, introDepthLimit(n)); \
+  }
+
+VQSORT_TYPED(i32, int32_t, INT32_MAX)
+VQSORT_TYPED(i64, int64_t, INT64_MAX)
+
+/**
+ * @brief flips the sign bits of n keys, turning the order of uint64 into the one of int64 and back.
+ */
+static void flipSigns(uint64_t *a, size_t n)
+{
+  size_t i;
+  for(i = 0; i < n; i++) a[i] ^= 0x8000000000000000ULL;
+}
+
+void sort_u64(void *data, size_t n)
+{
+  if(!data || n < 2) return;
+  flipSigns(data, n);
+  i64Sort(data, n, introDepthLimit(n));
+  flipSigns(data, n);
+}
+
+/**
+ * @brief context-taking entry, sorts elements that are just a supported key.
+ */
+void vqSort(void *data, size_t n, size_t size, SortContext_t *ctx)
+{
+  if(!data || n < 2) return;
+  if(!ctx->keyOffset)
+  {
+    switch(ctx->keyType)
+    {
+      case SORT_KEY_I32: if(size != sizeof(int32_t)) break; sort_i32(data, n); return;
+      case SORT_KEY_I64: if(size != sizeof(int64_t)) break; sort_i64(data, n); return;
+      case SORT_KEY_U64: if(size != sizeof(uint64_t)) break; sort_u64(data, n); return;
+    }
+  }
+  qsort_r(data, n, size, ctx->compare, ctx->compareArg);
+}
+
+static const SortCapabilities_t capabilities =
+{
+  SORT_CAP_INPLACE,
+  SORT_KEY_I32 | SORT_KEY_I64 | SORT_KEY_U64,
+  1,
+  "vqSort"
+};
+
+unsigned getSortAbiVersion(void)
+{
+  return SORT_ABI_VERSION;
+}
+
+const SortCapabilities_t* getSortCapabilities(void)
+{
+  return &capabilities;
+}
+
+char* getSortName(void)
+{
+  static char name[64];
+  snprintf(name, sizeof(name), "Vectorized Quicksort %s", simdLevelName(simdLevel()));
+  return name;
+}
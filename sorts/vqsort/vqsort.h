@@ -0,0 +1,14 @@
+#ifndef __VQSORT_H_
+#define __VQSORT_H_
+
+#include <stdlib.h>
+#include "../../sorting_lib.h"
+
+void vqSort(void *data, size_t n, size_t size, SortContext_t *ctx);
+
+//type-specialized entries
+void sort_i32(void *data, size_t n);
+void sort_i64(void *data, size_t n);
+void sort_u64(void *data, size_t n);
+
+#endif /* __VQSORT_H_ */
@@ -0,0 +1,159 @@
+/**
+ * @file stats.c
+ * @author Roy Freytag
+ *
+ * statistics over the samples of repeated benchmark runs.
+ *
+ * A single preempted or page-fault heavy run can skew a plain mean a lot,
+ * so all samples of a data point are kept and summarized by robust measures as well.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "stats.h"
+
+/**
+ * two-sided 95% quantiles of the student t-distribution for 1 to 30 degrees of freedom
+ */
+static const double tQuantiles[] = {
+  12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+  2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+  2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+};
+
+/**
+ * @brief creates a sample buffer.
+ * @param capacity maximum number of samples.
+ * @return pointer to the buffer or 0 if the allocation failed.
+ */
+Samples_t *sta_createSamples(size_t capacity)
+{
+  Samples_t *tmp = malloc(sizeof(Samples_t));
+  if(!tmp) return 0;
+  tmp->samples = malloc(sizeof(double) * (capacity?capacity:1));
+  if(!tmp->samples)
+  {
+    free(tmp);
+    return 0;
+  }
+  tmp->count = 0;
+  tmp->capacity = capacity;
+  return tmp;
+}
+
+/**
+ * @brief frees the sample buffer.
+ * @param s sample buffer.
+ */
+void sta_destroySamples(Samples_t *s)
+{
+  if(!s) return;
+  free(s->samples);
+  free(s);
+}
+
+/**
+ * @brief drops all recorded samples.
+ * @param s sample buffer.
+ */
+void sta_clearSamples(Samples_t *s)
+{
+  s->count = 0;
+}
+
+/**
+ * @brief records a sample.
+ * @param s sample buffer.
+ * @param sample value to record.
+ * @return
+ * - 1 if the sample was recorded
+ * - 0 if the buffer is full
+ */
+int sta_addSample(Samples_t *s, double sample)
+{
+  if(s->count >= s->capacity) return 0;
+  s->samples[s->count++] = sample;
+  return 1;
+}
+
+/**
+ * @brief comparison function for qsort() on doubles.
+ */
+static int doubleCompare(const void *a, const void *b)
+{
+  double x = *((double*)a), y = *((double*)b);
+  return (x < y)?-1:((x > y)?1:0);
+}
+
+/**
+ * @brief percentile of sorted samples, linearly interpolated between the closest ranks.
+ * @param sorted sorted samples.
+ * @param n number of samples.
+ * @param p percentile from 0 to 1.
+ */
+static double percentile(double *sorted, size_t n, double p)
+{
+  double rank = p * (n - 1);
+  size_t lo = (size_t)rank;
+  if(lo + 1 >= n) return sorted[n-1];
+  return sorted[lo] + (rank - lo) * (sorted[lo+1] - sorted[lo]);
+}
+
+/**
+ * @brief calculates mean and sample standard deviation.
+ */
+static void meanStddev(double *samples, size_t n, double *mean, double *stddev)
+{
+  size_t i;
+  double sum = 0, sq = 0;
+  for(i = 0; i < n; i++) sum += samples[i];
+  *mean = sum / n;
+  for(i = 0; i < n; i++) sq += (samples[i] - *mean) * (samples[i] - *mean);
+  *stddev = (n > 1)?sqrt(sq / (n - 1)):0;
+}
+
+/**
+ * @brief summarizes the recorded samples.
+ *
+ * The sample buffer itself is left in recording order.
+ * @param s sample buffer.
+ * @param stats summary to fill, all zero if there are no samples.
+ */
+void sta_calculate(Samples_t *s, Stats_t *stats)
+{
+  memset(stats, 0, sizeof(Stats_t));
+  if(!s->count) return;
+
+  double *sorted = malloc(sizeof(double) * s->count);
+  if(!sorted) return;
+  memcpy(sorted, s->samples, sizeof(double) * s->count);
+  qsort(sorted, s->count, sizeof(double), doubleCompare);
+
+  stats->count = s->count;
+  stats->min = sorted[0];
+  stats->median = percentile(sorted, s->count, 0.5);
+  stats->p95 = percentile(sorted, s->count, 0.95);
+  meanStddev(sorted, s->count, &stats->mean, &stats->stddev);
+
+  free(sorted);
+}
+
+/**
+ * @brief relative half-width of the 95% confidence interval of the mean.
+ * @param s sample buffer.
+ * @return half-width in percent of the mean, HUGE_VAL if there are less than two samples.
+ */
+double sta_confidence(Samples_t *s)
+{
+  if(s->count < 2) return HUGE_VAL;
+
+  double mean, stddev;
+  meanStddev(s->samples, s->count, &mean, &stddev);
+  if(mean <= 0) return 0;
+
+  size_t df = s->count - 1;
+  double t = (df <= sizeof(tQuantiles)/sizeof(tQuantiles[0]))?tQuantiles[df-1]:1.96;
+  return 100.0 * t * stddev / sqrt(s->count) / mean;
+}
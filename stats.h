@@ -0,0 +1,45 @@
+/**
+ * @file stats.h
+ * @author Roy Freytag
+ *
+ * statistics over the samples of repeated benchmark runs
+ */
+
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <stdlib.h>
+
+/**
+ * buffer of samples
+ */
+typedef struct
+{
+  double *samples; ///< recorded samples
+  size_t count; ///< number of recorded samples
+  size_t capacity; ///< number of samples that fit into the buffer
+} Samples_t;
+
+/**
+ * summary of a sample buffer
+ */
+typedef struct
+{
+  double min; ///< smallest sample
+  double median; ///< median of the samples
+  double p95; ///< 95th percentile of the samples
+  double mean; ///< arithmetic mean
+  double stddev; ///< sample standard deviation
+  size_t count; ///< number of samples the summary is based on
+} Stats_t;
+
+Samples_t *sta_createSamples(size_t capacity);
+void      sta_destroySamples(Samples_t *s);
+
+void      sta_clearSamples(Samples_t *s);
+int       sta_addSample(Samples_t *s, double sample);
+
+void      sta_calculate(Samples_t *s, Stats_t *stats);
+double    sta_confidence(Samples_t *s);
+
+#endif /* STATS_H_ */
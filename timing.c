@@ -0,0 +1,109 @@
+/**
+ * @file timing.c
+ * @author Roy Freytag
+ *
+ * high resolution timing of single benchmark runs.
+ *
+ * Every run gets timed by the monotonic wall-clock, the cpu-time of the calling thread and the TSC.
+ * The wall-clock is what the benchmark reports, the cpu-time shows how much of it the calling thread actually ran
+ * and the cycles allow comparing runs across machines with different clock rates.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC
+#endif
+
+#include "timing.h"
+
+#define CALIBRATION_TIME 50 ///< time in ms to spend on the TSC calibration
+
+static double tscFrequency = 0; ///< TSC ticks per ms, 0 when not calibrated or not available
+
+/**
+ * @brief reads the TSC.
+ * @return current TSC value or 0 if there is no TSC on this platform.
+ */
+static inline unsigned long long readTsc(void)
+{
+#ifdef HAVE_TSC
+  _mm_lfence(); //don't let the sort leak past the reading
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief difference of two timespecs.
+ * @return b - a in ms
+ */
+static double timespecDiff(struct timespec *a, struct timespec *b)
+{
+  return (b->tv_sec - a->tv_sec) * 1000.0 + (b->tv_nsec - a->tv_nsec) / 1000000.0;
+}
+
+/**
+ * @brief measures the TSC frequency against the monotonic clock.
+ *
+ * Should be called once at startup, before any runs are timed.
+ */
+void tim_calibrate(void)
+{
+#ifdef HAVE_TSC
+  struct timespec s, e;
+  unsigned long long c0, c1;
+  double elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &s);
+  c0 = readTsc();
+  do
+  {
+    clock_gettime(CLOCK_MONOTONIC, &e);
+    elapsed = timespecDiff(&s, &e);
+  } while(elapsed < CALIBRATION_TIME);
+  c1 = readTsc();
+
+  tscFrequency = (c1 - c0) / elapsed;
+#endif
+}
+
+/**
+ * @brief getter for the calibrated TSC frequency.
+ * @return TSC ticks per ms, 0 if not calibrated or there is no TSC.
+ */
+double tim_getTscFrequency(void)
+{
+  return tscFrequency;
+}
+
+/**
+ * @brief takes the starting time stamp of a run.
+ * @param start time stamp to fill.
+ */
+void tim_start(TimeStamp_t *start)
+{
+  clock_gettime(CLOCK_MONOTONIC, &start->wall);
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start->cpu);
+  start->cycles = readTsc();
+}
+
+/**
+ * @brief takes the ending time stamp of a run and calculates the durations.
+ * @param start time stamp taken by tim_start().
+ * @param result durations since start.
+ */
+void tim_stop(TimeStamp_t *start, Timing_t *result)
+{
+  TimeStamp_t end;
+  end.cycles = readTsc();
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &end.cpu);
+  clock_gettime(CLOCK_MONOTONIC, &end.wall);
+
+  result->wall = timespecDiff(&start->wall, &end.wall);
+  result->cpu = timespecDiff(&start->cpu, &end.cpu);
+  result->cycles = end.cycles - start->cycles;
+}
@@ -0,0 +1,39 @@
+/**
+ * @file timing.h
+ * @author Roy Freytag
+ *
+ * high resolution timing of single benchmark runs
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <time.h>
+
+/**
+ * point in time as seen by all the clocks we record
+ */
+typedef struct
+{
+  struct timespec wall; ///< CLOCK_MONOTONIC time
+  struct timespec cpu; ///< CLOCK_THREAD_CPUTIME_ID time
+  unsigned long long cycles; ///< TSC value, 0 if there is no TSC
+} TimeStamp_t;
+
+/**
+ * measured duration of a run
+ */
+typedef struct
+{
+  double wall; ///< wall-clock time in ms
+  double cpu; ///< cpu time of the calling thread in ms
+  unsigned long long cycles; ///< elapsed TSC cycles
+} Timing_t;
+
+void   tim_calibrate(void);
+double tim_getTscFrequency(void);
+
+void   tim_start(TimeStamp_t *start);
+void   tim_stop(TimeStamp_t *start, Timing_t *result);
+
+#endif /* TIMING_H_ */